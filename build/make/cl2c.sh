@@ -0,0 +1,61 @@
+#!/bin/sh
+##
+##  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+##
+##  Use of this source code is governed by a BSD-style license
+##  that can be found in the LICENSE file in the root of the source
+##  tree. An additional intellectual property rights grant can be found
+##  in the file PATENTS.  All contributing project authors may
+##  be found in the AUTHORS file in the root of the source tree.
+##
+
+##
+## Embeds OpenCL kernel sources in a C header. Each file is stored as a
+## nul-terminated byte array, and a table maps its path relative to the
+## source root, without the .cl extension, to the array.
+##
+## Usage: cl2c.sh --sym=<symbol> [--root=<source root>] <file.cl>...
+##
+
+sym=cl_sources
+root=.
+
+for opt in "$@"; do
+    optval="${opt#*=}"
+    case "$opt" in
+    --sym=*) sym="$optval" ;;
+    --root=*) root="$optval" ;;
+    *) break ;;
+    esac
+    shift
+done
+
+cat <<HEADER
+/* This file is automatically generated by cl2c.sh. Do not edit. */
+#ifndef `echo ${sym} | tr '[a-z]' '[A-Z]'`_H
+#define `echo ${sym} | tr '[a-z]' '[A-Z]'`_H
+
+HEADER
+
+i=0
+for f in "$@"; do
+    echo "static const char ${sym}_${i}[] = {"
+    od -An -v -tx1 "$f" | sed -e 's/[ ]*\([0-9a-f][0-9a-f]\)/0x\1,/g' -e 's/^/    /'
+    echo "    0x00"
+    echo "};"
+    echo
+    i=$((i+1))
+done
+
+echo "static const struct { const char *name; const char *src; } ${sym}[] = {"
+i=0
+for f in "$@"; do
+    name="${f#${root}/}"
+    name="${name#./}"
+    echo "    {\"${name%.cl}\", ${sym}_${i}},"
+    i=$((i+1))
+done
+echo "    {0, 0}"
+echo "};"
+echo
+echo "#endif"
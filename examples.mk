@@ -40,6 +40,23 @@ vpxenc.DESCRIPTION           = Full featured encoder
 UTILS-$(CONFIG_ENCODERS)    += vp8_scalable_patterns.c
 vp8_scalable_patterns.GUID   = 0D6A210B-F482-4D6F-8570-4A9C01ACC88C
 vp8_scalable_patterns.DESCRIPTION = Temporal Scalability Encoder
+UTILS-$(CONFIG_VP8_ENCODER) += vp8_screen_bench.c
+vp8_screen_bench.SRCS        += vpx_ports/vpx_timer.h
+vp8_screen_bench.GUID        = 3F8E2A61-5C7D-4B19-9E04-A2D6B81C7F35
+vp8_screen_bench.DESCRIPTION = Screen content motion search benchmark
+ifeq ($(CONFIG_VP8_DECODER),yes)
+UTILS-$(CONFIG_VP8_ENCODER) += vp8_transrate.c
+vp8_transrate.SRCS           += vpx_ports/vpx_timer.h
+vp8_transrate.GUID           = 8C2D4E17-6B3F-4A95-B0E8-5F1A9C73D264
+vp8_transrate.DESCRIPTION    = Transrater reusing the decoded motion
+endif
+# vp8_cl_tune calls into the library internals, which the shared library
+# doesn't export.
+ifneq ($(CONFIG_SHARED),yes)
+UTILS-$(CONFIG_OPENCL)      += vp8_cl_tune.c
+vp8_cl_tune.GUID             = 6E0B1C42-9D3A-4F57-A1C8-3B5E7D2F9A14
+vp8_cl_tune.DESCRIPTION      = OpenCL loop filter autotuner
+endif
 
 # Clean up old ivfenc, ivfdec binaries.
 ifeq ($(CONFIG_MSVS),yes)
@@ -90,6 +90,7 @@ $(eval $(if $(filter universal%,$(TOOLCHAIN)),LIPO_LIBVPX,BUILD_LIBVPX):=yes)
 
 CODEC_SRCS-$(BUILD_LIBVPX) += build/make/version.sh
 CODEC_SRCS-$(BUILD_LIBVPX) += build/make/rtcd.sh
+CODEC_SRCS-$(BUILD_LIBVPX) += build/make/cl2c.sh
 CODEC_SRCS-$(BUILD_LIBVPX) += vpx/vpx_integer.h
 CODEC_SRCS-$(BUILD_LIBVPX) += vpx_ports/asm_offsets.h
 CODEC_SRCS-$(BUILD_LIBVPX) += vpx_ports/vpx_timer.h
@@ -127,17 +128,6 @@ else
 INSTALL-LIBS-$(CONFIG_STATIC) += $(LIBSUBDIR)/libvpx.a
 INSTALL-LIBS-$(CONFIG_DEBUG_LIBS) += $(LIBSUBDIR)/libvpx_g.a
 
-#Install the OpenCL kernels if CL enabled.
-ifeq ($(CONFIG_OPENCL),yes)
-INSTALL-LIBS-yes += $(LIBSUBDIR)/vp8/common/opencl/filter_cl.cl
-INSTALL-LIBS-yes += $(LIBSUBDIR)/vp8/common/opencl/idctllm_cl.cl
-INSTALL-LIBS-yes += $(LIBSUBDIR)/vp8/common/opencl/loopfilter.cl
-#only install decoder CL files if VP8 decoder enabled
-ifeq ($(CONFIG_VP8_DECODER),yes)
-INSTALL-LIBS-yes += $(LIBSUBDIR)/vp8/decoder/opencl/dequantize_cl.cl
-endif
-endif #CONFIG_OPENCL=yes
-
 endif
 
 CODEC_SRCS=$(filter-out %_test.cc,$(call enabled,CODEC_SRCS))
@@ -347,6 +337,18 @@ vpx_rtcd.h: $(sort $(filter %rtcd_defs.sh,$(CODEC_SRCS)))
           $(RTCD_OPTIONS) $^ > $@
 CLEAN-OBJS += $(BUILD_PFX)vpx_rtcd.h
 
+#
+# Rule to embed the OpenCL kernel sources in the library
+#
+ifeq ($(CONFIG_OPENCL),yes)
+$(filter %vp8_opencl.c.d %vp8_opencl.c.o,$(OBJS-yes:.o=.d) $(OBJS-yes)): vp8_cl_sources.h
+vp8_cl_sources.h: $(sort $(filter %.cl,$(CODEC_SRCS)))
+	@echo "    [CREATE] $@"
+	$(qexec)$(SRC_PATH_BARE)/build/make/cl2c.sh --sym=vp8_cl_sources \
+          --root=$(SRC_PATH_BARE) $^ > $@
+CLEAN-OBJS += $(BUILD_PFX)vp8_cl_sources.h
+endif
+
 CODEC_DOC_SRCS += vpx/vpx_codec.h \
                   vpx/vpx_decoder.h \
                   vpx/vpx_encoder.h \
@@ -243,6 +243,8 @@ typedef struct macroblockd
 
 #if CONFIG_OPENCL
     cl_command_queue cl_commands; //Each macroblock gets its own command queue.
+    struct VP8_CL_PROFILE *cl_profile; //Timing of cl_commands, or NULL
+    struct VP8_LOOP_FILTER_CL *cl_lf; //Loop filter state of the decoder
     cl_mem cl_predictor_mem;
     cl_mem cl_qcoeff_mem;
     cl_mem cl_dqcoeff_mem;
@@ -114,23 +114,16 @@ void vp8_loop_filter_init(VP8_COMMON *cm)
     }
 }
 
-void vp8_loop_filter_frame_init(VP8_COMMON *cm,
-                                MACROBLOCKD *mbd,
-                                int default_filt_lvl)
+/* Works out the filter level of each segment, reference frame and mode
+ * class for the frame level default_filt_lvl.
+ */
+static void lf_init_lvl(MACROBLOCKD *mbd, int default_filt_lvl,
+                        unsigned char lvl[4][4][4])
 {
     int seg,  /* segment number */
         ref,  /* index in ref_lf_deltas */
         mode; /* index in mode_lf_deltas */
 
-    loop_filter_info_n *lfi = &cm->lf_info;
-
-    /* update limits if sharpness has changed */
-    if(cm->last_sharpness_level != cm->sharpness_level)
-    {
-        vp8_loop_filter_update_sharpness(lfi, cm->sharpness_level);
-        cm->last_sharpness_level = cm->sharpness_level;
-    }
-
     for(seg = 0; seg < MAX_MB_SEGMENTS; seg++)
     {
         int lvl_seg = default_filt_lvl;
@@ -156,7 +149,7 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
             /* we could get rid of this if we assume that deltas are set to
              * zero when not in use; encoder always uses deltas
              */
-            vpx_memset(lfi->lvl[seg][0], lvl_seg, 4 * 4 );
+            vpx_memset(lvl[seg][0], lvl_seg, 4 * 4 );
             continue;
         }
 
@@ -174,11 +167,11 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
         lvl_mode = lvl_ref +  mbd->mode_lf_deltas[mode];
         lvl_mode = (lvl_mode > 0) ? (lvl_mode > 63 ? 63 : lvl_mode) : 0; /* clamp */
 
-        lfi->lvl[seg][ref][mode] = lvl_mode;
+        lvl[seg][ref][mode] = lvl_mode;
 
         mode = 1; /* all the rest of Intra modes */
         lvl_mode = (lvl_ref > 0) ? (lvl_ref > 63 ? 63 : lvl_ref)  : 0; /* clamp */
-        lfi->lvl[seg][ref][mode] = lvl_mode;
+        lvl[seg][ref][mode] = lvl_mode;
 
         /* LAST, GOLDEN, ALT */
         for(ref = 1; ref < MAX_REF_FRAMES; ref++)
@@ -194,17 +187,56 @@ void vp8_loop_filter_frame_init(VP8_COMMON *cm,
                 lvl_mode = lvl_ref + mbd->mode_lf_deltas[mode];
                 lvl_mode = (lvl_mode > 0) ? (lvl_mode > 63 ? 63 : lvl_mode) : 0; /* clamp */
 
-                lfi->lvl[seg][ref][mode] = lvl_mode;
+                lvl[seg][ref][mode] = lvl_mode;
             }
         }
     }
 }
 
+void vp8_loop_filter_frame_init(VP8_COMMON *cm,
+                                MACROBLOCKD *mbd,
+                                int default_filt_lvl)
+{
+    loop_filter_info_n *lfi = &cm->lf_info;
+
+    /* update limits if sharpness has changed */
+    if(cm->last_sharpness_level != cm->sharpness_level)
+    {
+        vp8_loop_filter_update_sharpness(lfi, cm->sharpness_level);
+        cm->last_sharpness_level = cm->sharpness_level;
+    }
+
+    lf_init_lvl(mbd, default_filt_lvl, lfi->lvl);
+}
+
 void vp8_loop_filter_frame
 (
     VP8_COMMON *cm,
     MACROBLOCKD *mbd
 )
+{
+#if CONFIG_OPENCL && ENABLE_CL_LOOPFILTER
+    if ( cl_initialized == CL_SUCCESS && mbd->cl_lf != NULL ){
+        vp8_loop_filter_frame_cl(cm,mbd);
+        return;
+    }
+#endif
+    
+    /* Initialize the loop filter for this frame. */
+    vp8_loop_filter_frame_init(cm, mbd, cm->filter_level);
+
+    vp8_loop_filter_rows(cm, 0, cm->mb_rows);
+}
+
+/* Filters MB rows start_row to end_row - 1 of cm->frame_to_show. The rows
+ * have to be filtered in order, after vp8_loop_filter_frame_init().
+ */
+void vp8_loop_filter_rows
+(
+    VP8_COMMON *cm,
+    int start_row,
+    int end_row
+)
 {
     YV12_BUFFER_CONFIG *post = cm->frame_to_show;
     loop_filter_info_n *lfi_n = &cm->lf_info;
@@ -219,26 +251,16 @@ void vp8_loop_filter_frame
 
     unsigned char *y_ptr, *u_ptr, *v_ptr;
 
-    /* Point at base of Mb MODE_INFO list */
-    const MODE_INFO *mode_info_context = cm->mi;
-    
-#if CONFIG_OPENCL && ENABLE_CL_LOOPFILTER
-    if ( cl_initialized == CL_SUCCESS ){
-        vp8_loop_filter_frame_cl(cm,mbd);
-        return;
-    }
-#endif
-    
-    /* Initialize the loop filter for this frame. */
-    vp8_loop_filter_frame_init(cm, mbd, cm->filter_level);
+    /* Point at the MODE_INFO of the first MB to filter */
+    const MODE_INFO *mode_info_context = cm->mi + start_row * cm->mode_info_stride;
 
     /* Set up the buffer pointers */
-    y_ptr = post->y_buffer;
-    u_ptr = post->u_buffer;
-    v_ptr = post->v_buffer;
+    y_ptr = post->y_buffer + start_row * post->y_stride * 16;
+    u_ptr = post->u_buffer + start_row * post->uv_stride * 8;
+    v_ptr = post->v_buffer + start_row * post->uv_stride * 8;
 
     /* vp8_filter each macro block */
-    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    for (mb_row = start_row; mb_row < end_row; mb_row++)
     {
         for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
         {
@@ -322,14 +344,36 @@ void vp8_loop_filter_frame_yonly
     int default_filt_lvl
 )
 {
-    YV12_BUFFER_CONFIG *post = cm->frame_to_show;
+#if 0
+    if(default_filt_lvl == 0) /* no filter applied */
+        return;
+#endif
 
+    /* Initialize the loop filter for this frame. */
+    vp8_loop_filter_frame_init( cm, mbd, default_filt_lvl);
+
+    vp8_loop_filter_buffer_yonly(cm, mbd, cm->frame_to_show, default_filt_lvl);
+}
+
+/* Filters the Y plane of post. Only reads cm and mbd, so several levels can
+ * be tried at the same time on different buffers, as long as cm->lf_info is
+ * up to date with the sharpness level.
+ */
+void vp8_loop_filter_buffer_yonly
+(
+    VP8_COMMON *cm,
+    MACROBLOCKD *mbd,
+    YV12_BUFFER_CONFIG *post,
+    int default_filt_lvl
+)
+{
     unsigned char *y_ptr;
     int mb_row;
     int mb_col;
 
-    loop_filter_info_n *lfi_n = &cm->lf_info;
+    const loop_filter_info_n *lfi_n = &cm->lf_info;
     loop_filter_info lfi;
+    unsigned char lvl[4][4][4];
 
     int filter_level;
     FRAME_TYPE frame_type = cm->frame_type;
@@ -337,13 +381,7 @@ void vp8_loop_filter_frame_yonly
     /* Point at base of Mb MODE_INFO list */
     const MODE_INFO *mode_info_context = cm->mi;
 
-#if 0
-    if(default_filt_lvl == 0) /* no filter applied */
-        return;
-#endif
-
-    /* Initialize the loop filter for this frame. */
-    vp8_loop_filter_frame_init( cm, mbd, default_filt_lvl);
+    lf_init_lvl(mbd, default_filt_lvl, lvl);
 
     /* Set up the buffer pointers */
     y_ptr = post->y_buffer;
@@ -361,7 +399,7 @@ void vp8_loop_filter_frame_yonly
             const int seg = mode_info_context->mbmi.segment_id;
             const int ref_frame = mode_info_context->mbmi.ref_frame;
 
-            filter_level = lfi_n->lvl[seg][ref_frame][mode_index];
+            filter_level = lvl[seg][ref_frame][mode_index];
 
             if (filter_level)
             {
@@ -15,6 +15,7 @@
 #include "vpx_ports/mem.h"
 #include "vpx_config.h"
 #include "vpx_rtcd.h"
+#include "vpx_scale/yv12config.h"
 
 #define MAX_LOOP_FILTER             63
 /* fraction of total macroblock rows to be used in fast filter level picking */
@@ -82,10 +83,17 @@ void vp8_loop_filter_partial_frame(struct VP8Common *cm,
                                    struct macroblockd *mbd,
                                    int default_filt_lvl);
 
+void vp8_loop_filter_rows(struct VP8Common *cm, int start_row, int end_row);
+
 void vp8_loop_filter_frame_yonly(struct VP8Common *cm,
                                  struct macroblockd *mbd,
                                  int default_filt_lvl);
 
+void vp8_loop_filter_buffer_yonly(struct VP8Common *cm,
+                                  struct macroblockd *mbd,
+                                  YV12_BUFFER_CONFIG *post,
+                                  int default_filt_lvl);
+
 void vp8_loop_filter_update_sharpness(loop_filter_info_n *lfi,
                                       int sharpness_lvl);
 
@@ -174,6 +174,7 @@ extern "C"
         int two_pass_vbrbias;        // two pass datarate control tweaks
         int two_pass_vbrmin_section;
         int two_pass_vbrmax_section;
+        int first_pass_downscale;    // run the first pass at half resolution
         // END DATARATE CONTROL OPTIONS
         //----------------------------------------------------------------
 
@@ -187,6 +188,12 @@ extern "C"
 
 
         int multi_threaded;   // how many threads to run the encoder on
+        int pool_threads;     // threads in the shared pool to run them on, 0 for own threads
+        int lf_row_sync;      // loop filter rows while the frame is encoded
+        int token_row_sync;   // pack tokens of rows while the frame is encoded
+        int halfpel_planes_kb; // memory for precomputed half pel planes, 0 for none
+        int screen_content;   // look up blocks of the last frame by hash
+        int auto_active_map;  // noise threshold of still MBs, 0 for no automatic active map
         int token_partitions; // how many token partitions to create for multi core decoding
         int encode_breakout;  // early breakout encode threshold : for video conf recommend 800
 
@@ -224,6 +231,11 @@ extern "C"
 
         /* Memory location to store low-resolution encoder's mode info */
         void* mr_low_res_mode_info;
+
+        /* Encode the resolutions at the same time, each one running as far
+         * behind the next lower one as the mode info it needs.
+         */
+        int mr_pipeline;
 #endif
     } VP8_CONFIG;
 
@@ -249,8 +261,10 @@ extern "C"
     int vp8_update_entropy(struct VP8_COMP* comp, int update);
     int vp8_set_roimap(struct VP8_COMP* comp, unsigned char *map, unsigned int rows, unsigned int cols, int delta_q[4], int delta_lf[4], unsigned int threshold[4]);
     int vp8_set_active_map(struct VP8_COMP* comp, unsigned char *map, unsigned int rows, unsigned int cols);
+    int vp8_set_mb_hints(struct VP8_COMP* comp, vpx_mb_hint_map_t *map);
     int vp8_set_internal_size(struct VP8_COMP* comp, VPX_SCALING horiz_mode, VPX_SCALING vert_mode);
     int vp8_get_quantizer(struct VP8_COMP* c);
+    int vp8_get_halfpel_planes_kb(struct VP8_COMP* c);
 
 #ifdef __cplusplus
 }
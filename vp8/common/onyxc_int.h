@@ -34,7 +34,14 @@ void vp8_initialize_common(void);
 #define MAXQ 127
 #define QINDEX_RANGE (MAXQ + 1)
 
+#if CONFIG_OPENCL
+/* One extra buffer holds the frame whose loop filter is still running on the
+ * OpenCL device while the next frame is decoded.
+ */
+#define NUM_YV12_BUFFERS 5
+#else
 #define NUM_YV12_BUFFERS 4
+#endif
 
 #define MAX_PARTITIONS 9
 
@@ -34,6 +34,8 @@ extern "C"
         int     max_threads;
         int     error_concealment;
         int     input_fragments;
+        int     async_loopfilter;
+        int     cl_profiling;
     } VP8D_CONFIG;
     typedef enum
     {
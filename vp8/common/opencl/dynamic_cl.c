@@ -76,11 +76,11 @@ int load_cl(char *lib_name){
     CL_LOAD_FN("clSetKernelArg", cl.setKernelArg);
 //    CL_LOAD_FN("clGetKernelInfo", cl.getKernelInfo);
     CL_LOAD_FN("clGetKernelWorkGroupInfo", cl.getKernelWorkGroupInfo);
-//    CL_LOAD_FN("clWaitForEvents", cl.waitForEvents);
+    CL_LOAD_FN("clWaitForEvents", cl.waitForEvents);
 //    CL_LOAD_FN("clGetEventInfo", cl.getEventInfo);
 //    CL_LOAD_FN("clRetainEvent", cl.retainEvent);
-//    CL_LOAD_FN("clReleaseEvent", cl.releaseEvent);
-//    CL_LOAD_FN("clGetEventProfilingInfo", cl.getEventProfilingInfo);
+    CL_LOAD_FN("clReleaseEvent", cl.releaseEvent);
+    CL_LOAD_FN("clGetEventProfilingInfo", cl.getEventProfilingInfo);
     CL_LOAD_FN("clFlush", cl.flush);
     CL_LOAD_FN("clFinish", cl.finish);
     CL_LOAD_FN("clEnqueueReadBuffer", cl.enqueueReadBuffer);
@@ -15,6 +15,7 @@
 #include "vpx_mem/vpx_mem.h"
 #include "vp8_opencl.h"
 #include "blockd_cl.h"
+#include "profile_cl.h"
 
 //Disable usage of mapped buffers for performance increase on Nvidia hardware
 #if ARCH_ARM
@@ -43,22 +44,6 @@
 const char *loopFilterCompileOptions = "-D COLS_LOCATION=1 -D DC_DIFFS_LOCATION=2 -D ROWS_LOCATION=3 -D MAX_LOOP_FILTER=63" VP8_SIMD_STRING;
 const char *loop_filter_cl_file_name = "vp8/common/opencl/loopfilter";
 
-typedef struct VP8_LOOP_SETTINGS{
-    int y_stride;
-    int uv_stride;
-    LOOPFILTERTYPE filter_type;
-    int mbrows;
-    int mbcols;
-} VP8_LOOP_SETTINGS;
-
-static VP8_LOOP_SETTINGS prior_settings;
-
-static int frame_num = 0;
-static cl_int *block_offsets = NULL;
-static cl_int *priority_num_blocks = NULL;
-static int recalculate_offsets = 1;
-static int max_blocks = 0;
-
 typedef unsigned char uc;
 
 extern void vp8_loop_filter_frame
@@ -67,91 +52,81 @@ extern void vp8_loop_filter_frame
     MACROBLOCKD *mbd
 );
 
-typedef struct VP8_LOOP_MEM{
-    cl_int num_blocks;
-    cl_mem offsets_mem;
-    cl_mem pitches_mem;
-    cl_mem filters_mem;
-    
-    cl_mem block_offsets_mem;
-    cl_mem priority_num_blocks_mem;
-} VP8_LOOP_MEM;
-
-VP8_LOOP_MEM loop_mem;
-cl_mem lfi_mem = NULL;
-
 prototype_loopfilter_cl(vp8_loop_filter_all_edges_cl);
 prototype_loopfilter_cl(vp8_loop_filter_simple_all_edges_cl);
 
-int cl_free_loop_mem(){
+int cl_free_loop_mem(VP8_LOOP_FILTER_CL *lf){
+    VP8_LOOP_MEM *loop_mem = &lf->mem;
     int err = 0;
 
-    if (block_offsets != NULL) free(block_offsets);
-    if (priority_num_blocks != NULL) free(priority_num_blocks);
-    block_offsets = NULL;
-    priority_num_blocks = NULL;
+    if (lf->block_offsets != NULL) free(lf->block_offsets);
+    if (lf->priority_num_blocks != NULL) free(lf->priority_num_blocks);
+    lf->block_offsets = NULL;
+    lf->priority_num_blocks = NULL;
     
-    if (loop_mem.offsets_mem != NULL) err |= clReleaseMemObject(loop_mem.offsets_mem);
-    if (loop_mem.pitches_mem != NULL) err |= clReleaseMemObject(loop_mem.pitches_mem);
-    if (loop_mem.filters_mem != NULL) err |= clReleaseMemObject(loop_mem.filters_mem);
-    if (loop_mem.block_offsets_mem != NULL) err |= clReleaseMemObject(loop_mem.block_offsets_mem);
-    if (loop_mem.priority_num_blocks_mem != NULL) err |= clReleaseMemObject(loop_mem.priority_num_blocks_mem);
-    loop_mem.offsets_mem = NULL;
-    loop_mem.pitches_mem = NULL;
-    loop_mem.filters_mem = NULL;
-    loop_mem.block_offsets_mem = NULL;
-    loop_mem.priority_num_blocks_mem = NULL;
-
-    loop_mem.num_blocks = 0;
+    if (loop_mem->offsets_mem != NULL) err |= clReleaseMemObject(loop_mem->offsets_mem);
+    if (loop_mem->pitches_mem != NULL) err |= clReleaseMemObject(loop_mem->pitches_mem);
+    if (loop_mem->filters_mem != NULL) err |= clReleaseMemObject(loop_mem->filters_mem);
+    if (loop_mem->block_offsets_mem != NULL) err |= clReleaseMemObject(loop_mem->block_offsets_mem);
+    if (loop_mem->priority_num_blocks_mem != NULL) err |= clReleaseMemObject(loop_mem->priority_num_blocks_mem);
+    loop_mem->offsets_mem = NULL;
+    loop_mem->pitches_mem = NULL;
+    loop_mem->filters_mem = NULL;
+    loop_mem->block_offsets_mem = NULL;
+    loop_mem->priority_num_blocks_mem = NULL;
+
+    loop_mem->num_blocks = 0;
 
     return err;
 }
 
 int cl_populate_loop_mem(MACROBLOCKD *mbd, YV12_BUFFER_CONFIG *post){
+    VP8_LOOP_MEM *loop_mem = &mbd->cl_lf->mem;
     int err;
 
 #if USE_MAPPED_BUFFERS
     cl_int *pitches = NULL;
-    VP8_CL_MAP_BUF(mbd->cl_commands, loop_mem.pitches_mem, pitches, 3*sizeof(cl_int),,err)
+    VP8_CL_MAP_BUF(mbd->cl_commands, loop_mem->pitches_mem, pitches, 3*sizeof(cl_int),,err)
     pitches[0] = post->y_stride;
     pitches[1] = post->uv_stride;
     pitches[2] = post->uv_stride;
-    VP8_CL_UNMAP_BUF(mbd->cl_commands, loop_mem.pitches_mem, pitches,,err)
+    VP8_CL_UNMAP_BUF_EV(mbd->cl_commands, loop_mem->pitches_mem, pitches, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE),,err)
 #else
     cl_int pitches[3] = {post->y_stride, post->uv_stride, post->uv_stride};
-    VP8_CL_SET_BUF(mbd->cl_commands, loop_mem.pitches_mem, 3*sizeof(cl_int), pitches,,err);
+    VP8_CL_SET_BUF_EV(mbd->cl_commands, loop_mem->pitches_mem, 3*sizeof(cl_int), pitches, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE),,err);
 #endif
     return err;
 }
 
 int cl_grow_loop_mem(MACROBLOCKD *mbd, YV12_BUFFER_CONFIG *post, VP8_COMMON *cm){
-
+    VP8_LOOP_FILTER_CL *lf = mbd->cl_lf;
+    VP8_LOOP_MEM *loop_mem = &lf->mem;
     int err;
 
     int num_blocks = cm->MBs;
     int priority_levels = 2*(cm->mb_rows - 1) + cm->mb_cols;
     
     //Don't reallocate if the memory is already large enough
-    if (num_blocks <= loop_mem.num_blocks)
+    if (num_blocks <= loop_mem->num_blocks)
         return CL_SUCCESS;
 
-    recalculate_offsets = 1;
+    lf->recalculate_offsets = 1;
     
     //free all first.
-    cl_free_loop_mem();
+    cl_free_loop_mem(lf);
 
     //Now re-allocate the memory in the right size
-    loop_mem.offsets_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*cm->MBs*3, NULL, &err);
+    loop_mem->offsets_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*cm->MBs*3, NULL, &err);
     if (err != CL_SUCCESS){
         printf("Error creating loop filter buffer\n");
         return err;
     }
-    loop_mem.pitches_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*3, NULL, &err);
+    loop_mem->pitches_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*3, NULL, &err);
     if (err != CL_SUCCESS){
         printf("Error creating loop filter buffer\n");
         return err;
     }
-    loop_mem.filters_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*cm->MBs*4, NULL, &err);
+    loop_mem->filters_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int)*cm->MBs*4, NULL, &err);
     if (err != CL_SUCCESS){
         printf("Error creating loop filter buffer\n");
         return err;
@@ -159,37 +134,36 @@ int cl_grow_loop_mem(MACROBLOCKD *mbd, YV12_BUFFER_CONFIG *post, VP8_COMMON *cm)
 
     //Number of blocks that have already been processed at the beginning of a
     //given priority level.
-    block_offsets = malloc( sizeof(cl_int) * priority_levels );
-    if (block_offsets == NULL){
+    lf->block_offsets = malloc( sizeof(cl_int) * priority_levels );
+    if (lf->block_offsets == NULL){
         cl_destroy(mbd->cl_commands, VP8_CL_TRIED_BUT_FAILED);
         return VP8_CL_TRIED_BUT_FAILED;
     }
-    loop_mem.block_offsets_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int) * priority_levels, NULL, &err);
+    loop_mem->block_offsets_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int) * priority_levels, NULL, &err);
     if (err != CL_SUCCESS){
         printf("Error creating loop filter buffer\n");
         return err;
     }
 
     //Number of blocks to be processed in a given priority level.
-    priority_num_blocks = malloc( sizeof(cl_int) * priority_levels );
-    if (priority_num_blocks == NULL){
+    lf->priority_num_blocks = malloc( sizeof(cl_int) * priority_levels );
+    if (lf->priority_num_blocks == NULL){
         cl_destroy(mbd->cl_commands, VP8_CL_TRIED_BUT_FAILED);
         return VP8_CL_TRIED_BUT_FAILED;
     }
-    loop_mem.priority_num_blocks_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int) * priority_levels, NULL, &err);
+    loop_mem->priority_num_blocks_mem = clCreateBuffer(cl_data.context, CL_MEM_READ_ONLY|VP8_CL_MEM_ALLOC_TYPE, sizeof(cl_int) * priority_levels, NULL, &err);
     if (err != CL_SUCCESS){
         printf("Error creating loop filter buffer\n");
         return err;
     }
     
-    loop_mem.num_blocks = num_blocks;
+    loop_mem->num_blocks = num_blocks;
 
     return cl_populate_loop_mem(mbd, post);
 }
 
-static char* vp8_cl_build_lf_compile_opts(){
+static char* vp8_cl_build_lf_compile_opts(const VP8_CL_LF_TUNING *tuning){
     //Build program compile-time options
-    //If CPU (or forced), use combined planes
     size_t lf_co_size = strlen(loopFilterCompileOptions)+1;
     char *type_str;
     char *lf_opts = malloc(lf_co_size + strlen(VP8_LF_COMBINE_PLANES_STR) + 1 + strlen(VP8_LF_UINT_BUFFER_STR)+1);
@@ -202,28 +176,48 @@ static char* vp8_cl_build_lf_compile_opts(){
         free(lf_opts);
         return NULL;
     }
-    cl_data.vp8_loop_filter_combine_planes = (cl_data.device_type == CL_DEVICE_TYPE_CPU);
+    cl_data.vp8_loop_filter_combine_planes = tuning->combine_planes;
     sprintf(type_str,"%d", cl_data.vp8_loop_filter_combine_planes);
     
     lf_opts = strcpy(lf_opts, loopFilterCompileOptions);
     lf_opts = strcat(lf_opts, VP8_LF_COMBINE_PLANES_STR);
     lf_opts = strcat(lf_opts, type_str);
     
-    cl_data.vp8_loop_filter_uint_buffer = (cl_data.device_type != CL_DEVICE_TYPE_CPU);
+    cl_data.vp8_loop_filter_uint_buffer = tuning->uint_buffer;
     sprintf(type_str,"%d", cl_data.vp8_loop_filter_uint_buffer);
     lf_opts = strcat(lf_opts, VP8_LF_UINT_BUFFER_STR);
     lf_opts = strcat(lf_opts, type_str);
     
     free(type_str);
+
+    //Not a build option, only picked up when the kernels are enqueued.
+    cl_data.vp8_loop_filter_group_planes = tuning->group_planes;
+
     return lf_opts;
 }
 
 //Start of externally callable functions.
 
 int cl_init_loop_filter() {
+    VP8_CL_LF_TUNING tuning;
+
+    //Use the settings found by vp8_cl_loop_filter_autotune() for this
+    //device if there are any. Otherwise, CPUs use combined planes and
+    //uchar buffers, while other devices get separate planes and uint
+    //buffers.
+    if (!vp8_cl_loop_filter_read_tuning(&tuning)){
+        tuning.combine_planes = (cl_data.device_type == CL_DEVICE_TYPE_CPU);
+        tuning.uint_buffer = (cl_data.device_type != CL_DEVICE_TYPE_CPU);
+        tuning.group_planes = 0;
+    }
+
+    return cl_init_loop_filter_tuning(&tuning);
+}
+
+int cl_init_loop_filter_tuning(const VP8_CL_LF_TUNING *tuning) {
     int err;
 
-    char *lf_opts = vp8_cl_build_lf_compile_opts();
+    char *lf_opts = vp8_cl_build_lf_compile_opts(tuning);
     if (lf_opts == NULL)
         return VP8_CL_TRIED_BUT_FAILED;
     
@@ -260,15 +254,6 @@ int cl_init_loop_filter() {
         cl_data.vp8_loop_filter_simple_horizontal_edges_kernel = NULL;
         cl_data.vp8_loop_filter_simple_vertical_edges_kernel = NULL;
     }
-    
-    loop_mem.num_blocks = 0;
-    loop_mem.offsets_mem = NULL;
-    loop_mem.pitches_mem = NULL;
-    loop_mem.filters_mem = NULL;
-    loop_mem.block_offsets_mem = NULL;
-    loop_mem.priority_num_blocks_mem = NULL;
-    block_offsets = NULL;
-    priority_num_blocks = NULL;
 
     vp8_loop_filter_filters_init();
 
@@ -277,13 +262,6 @@ int cl_init_loop_filter() {
 
 void cl_destroy_loop_filter(){
 
-    cl_free_loop_mem();
-
-    if (lfi_mem != NULL){
-        clReleaseMemObject(lfi_mem);
-        lfi_mem = NULL;
-    }
-   
     VP8_CL_RELEASE_KERNEL(cl_data.vp8_loop_filter_all_edges_kernel);
     VP8_CL_RELEASE_KERNEL(cl_data.vp8_loop_filter_horizontal_edges_kernel);
     VP8_CL_RELEASE_KERNEL(cl_data.vp8_loop_filter_vertical_edges_kernel);
@@ -300,12 +278,13 @@ void cl_destroy_loop_filter(){
 
 
 /* Generate the list of filtering values per priority level*/
-void vp8_loop_filter_build_filter_offsets(cl_int *filters, int level, 
+void vp8_loop_filter_build_filter_offsets(VP8_LOOP_FILTER_CL *lf,
+        cl_int *filters, int level, 
         cl_int *filter_levels, cl_int *dc_diffs, cl_int *mb_rows, cl_int *mb_cols
 )
 {
-    int offset = block_offsets[level]*4;
-    int num_blocks = priority_num_blocks[level];
+    int offset = lf->block_offsets[level]*4;
+    int num_blocks = lf->priority_num_blocks[level];
 
     if (num_blocks == 0)
         return;
@@ -326,7 +305,7 @@ void vp8_loop_filter_build_offsets(MACROBLOCKD *mbd, int num_blocks,
     
     if (filter_type == NORMAL_LOOPFILTER){
                 
-        offsets += block_offsets[priority_level]*3;
+        offsets += mbd->cl_lf->block_offsets[priority_level]*3;
                 
         //populate it with the correct offsets for current filter type
         for (blk = 0; blk < num_blocks; blk++){
@@ -337,7 +316,7 @@ void vp8_loop_filter_build_offsets(MACROBLOCKD *mbd, int num_blocks,
         }
     } else {
         //Simple filter
-        offsets += block_offsets[priority_level];
+        offsets += mbd->cl_lf->block_offsets[priority_level];
         
         //populate it with the correct offsets for current filter type
         for (blk = 0; blk < num_blocks; blk++){
@@ -353,7 +332,7 @@ void vp8_loop_filter_macroblocks_cl(
 )
 {
     LOOPFILTERTYPE filter_type = cm->filter_type;
-    int num_blocks = priority_num_blocks[priority_level];
+    int num_blocks = mbd->cl_lf->priority_num_blocks[priority_level];
     
     args->priority_level = priority_level;
     args->num_levels = num_levels;
@@ -415,6 +394,7 @@ void vp8_loop_filter_build_priority(int priority, VP8_COMMON *cm, MACROBLOCKD *m
         cl_int *offsets
 )
 {
+    VP8_LOOP_FILTER_CL *lf = mbd->cl_lf;
     int mb_row, mb_col, mb_cols = cm->mb_cols;
     int priority_mbs = 0;
     int start_block = *current_blocks;
@@ -470,14 +450,14 @@ void vp8_loop_filter_build_priority(int priority, VP8_COMMON *cm, MACROBLOCKD *m
         }
     }
     
-    if (recalculate_offsets == 1){
+    if (lf->recalculate_offsets == 1){
         //Set the block/num_blocks for the current level
-        priority_num_blocks[priority] = priority_mbs;
+        lf->priority_num_blocks[priority] = priority_mbs;
 
         if (priority == 0)
-            block_offsets[0] = 0;
+            lf->block_offsets[0] = 0;
         else
-            block_offsets[priority] = block_offsets[priority-1] + priority_num_blocks[priority-1];
+            lf->block_offsets[priority] = lf->block_offsets[priority-1] + lf->priority_num_blocks[priority-1];
 
         vp8_loop_filter_build_offsets(mbd, priority_mbs, 
             &y_offsets[start_block], &u_offsets[start_block], &v_offsets[start_block], 
@@ -489,15 +469,16 @@ void vp8_loop_filter_build_priority(int priority, VP8_COMMON *cm, MACROBLOCKD *m
 void vp8_loop_filter_offsets_copy(VP8_COMMON *cm, MACROBLOCKD *mbd, 
         cl_int *dc_diffs, cl_int *rows, cl_int *cols, cl_int *filter_levels, int levels
 ){
+    VP8_LOOP_FILTER_CL *lf = mbd->cl_lf;
     int err, level;
     
     cl_int *filters;
 
-    int num_blocks = priority_num_blocks[levels-1] + block_offsets[levels-1];
+    int num_blocks = lf->priority_num_blocks[levels-1] + lf->block_offsets[levels-1];
     
 #if MAP_FILTERS
     //Always copy the dc_diffs, rows, cols, and filter_offsets values
-    VP8_CL_MAP_BUF(mbd->cl_commands, loop_mem.filters_mem, filters, 4*num_blocks*sizeof(cl_int),,);
+    VP8_CL_MAP_BUF(mbd->cl_commands, lf->mem.filters_mem, filters, 4*num_blocks*sizeof(cl_int),,);
 #else
     filters = malloc(4*cm->MBs*sizeof(cl_int));
     if (filters == NULL){
@@ -507,29 +488,38 @@ void vp8_loop_filter_offsets_copy(VP8_COMMON *cm, MACROBLOCKD *mbd,
     
     for (level = 0; level < levels; level++){
         if (level > 0){
-            filter_levels = &filter_levels[priority_num_blocks[level-1]];
-            rows = &rows[priority_num_blocks[level-1]];
-            cols = &cols[priority_num_blocks[level-1]];
-            dc_diffs = &dc_diffs[priority_num_blocks[level-1]];
+            filter_levels = &filter_levels[lf->priority_num_blocks[level-1]];
+            rows = &rows[lf->priority_num_blocks[level-1]];
+            cols = &cols[lf->priority_num_blocks[level-1]];
+            dc_diffs = &dc_diffs[lf->priority_num_blocks[level-1]];
         }
-        vp8_loop_filter_build_filter_offsets(filters, level, 
+        vp8_loop_filter_build_filter_offsets(lf, filters, level, 
                 filter_levels, dc_diffs, rows, cols);
     }
     
 #if MAP_FILTERS
-    VP8_CL_UNMAP_BUF(mbd->cl_commands, loop_mem.filters_mem, filters, ,)
+    VP8_CL_UNMAP_BUF_EV(mbd->cl_commands, lf->mem.filters_mem, filters, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE), ,)
 #else
-    VP8_CL_SET_BUF(mbd->cl_commands, loop_mem.filters_mem, 4*num_blocks*sizeof(cl_int), filters, vp8_loop_filter_frame(cm,mbd),)
+    VP8_CL_SET_BUF_EV(mbd->cl_commands, lf->mem.filters_mem, 4*num_blocks*sizeof(cl_int), filters, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE), vp8_loop_filter_frame(cm,mbd),)
     free(filters);
 #endif
 }
 
-void vp8_loop_filter_frame_cl
+/* Enqueues the loop filter for cm->frame_to_show and a non-blocking read back
+ * of the filtered frame, using the loop filter state in mbd->cl_lf. The host
+ * copy (post->buffer_alloc) is not updated until
+ * vp8_loop_filter_frame_cl_finish() is called. *done receives the event
+ * of the read back, and is left NULL if the frame was filtered on the host
+ * instead.
+ */
+void vp8_loop_filter_frame_cl_start
 (
     VP8_COMMON *cm,
-    MACROBLOCKD *mbd
+    MACROBLOCKD *mbd,
+    cl_event *done
 )
 {
+    VP8_LOOP_FILTER_CL *lf = mbd->cl_lf;
     YV12_BUFFER_CONFIG *post = cm->frame_to_show;
     VP8_LOOP_SETTINGS current_settings;
     
@@ -553,24 +543,28 @@ void vp8_loop_filter_frame_cl
     int i;
     
     VP8_LOOPFILTER_ARGS args;
+
+    //Only one frame per decoder can be in flight, as it reuses the buffers.
+    vp8_loop_filter_frame_cl_finish(lf);
+    *done = NULL;
     
     /* Initialize the loop filter for this frame. */
     vp8_loop_filter_frame_init( cm, mbd, cm->filter_level);
 
 #if USE_MAPPED_BUFFERS
-    if (lfi_mem == NULL){
-        VP8_CL_CREATE_MAPPED_BUF(mbd->cl_commands, lfi_mem, lfi_ptr, sizeof(loop_filter_info_n), , );
+    if (lf->lfi_mem == NULL){
+        VP8_CL_CREATE_MAPPED_BUF(mbd->cl_commands, lf->lfi_mem, lfi_ptr, sizeof(loop_filter_info_n), , );
     } else {
         //map the buffer
-        VP8_CL_MAP_BUF(mbd->cl_commands, lfi_mem, lfi_ptr, sizeof(loop_filter_info_n),,);
+        VP8_CL_MAP_BUF(mbd->cl_commands, lf->lfi_mem, lfi_ptr, sizeof(loop_filter_info_n),,);
     }
     vpx_memcpy(lfi_ptr, &cm->lf_info, sizeof(loop_filter_info_n));
-    VP8_CL_UNMAP_BUF(mbd->cl_commands, lfi_mem, lfi_ptr,,)
+    VP8_CL_UNMAP_BUF_EV(mbd->cl_commands, lf->lfi_mem, lfi_ptr, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE),,)
 #else
-     if (lfi_mem == NULL){
-        VP8_CL_CREATE_BUF(mbd->cl_commands, lfi_mem, , sizeof(loop_filter_info_n), &cm->lf_info,, );
+     if (lf->lfi_mem == NULL){
+        VP8_CL_CREATE_BUF(mbd->cl_commands, lf->lfi_mem, , sizeof(loop_filter_info_n), &cm->lf_info,, );
      } else {
-        VP8_CL_SET_BUF(mbd->cl_commands, lfi_mem, sizeof(loop_filter_info_n), &cm->lf_info,,);
+        VP8_CL_SET_BUF_EV(mbd->cl_commands, lf->lfi_mem, sizeof(loop_filter_info_n), &cm->lf_info, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE),,);
      }
 #endif
 
@@ -585,14 +579,14 @@ void vp8_loop_filter_frame_cl
         vpx_memcpy(buf, post->buffer_alloc, post->frame_size);
     }
     
-    VP8_CL_UNMAP_BUF(mbd->cl_commands, post->buffer_mem, buf,,);
+    VP8_CL_UNMAP_BUF_EV(mbd->cl_commands, post->buffer_mem, buf, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_FRAME_WRITE),,);
 #else
-    VP8_CL_SET_BUF(mbd->cl_commands, post->buffer_mem, post->frame_size, post->buffer_alloc,
+    VP8_CL_SET_BUF_EV(mbd->cl_commands, post->buffer_mem, post->frame_size, post->buffer_alloc, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_FRAME_WRITE),
             vp8_loop_filter_frame(cm,mbd),);
 #endif
 
 #if SKIP_NON_FILTERED_MBS
-    recalculate_offsets = 1;
+    lf->recalculate_offsets = 1;
 #else
     current_settings.filter_type = cm->filter_type;
     current_settings.y_stride = post->y_stride;
@@ -601,23 +595,23 @@ void vp8_loop_filter_frame_cl
     current_settings.mbrows = cm->mb_rows;
 
     //Determine if offsets need to be recalculated
-    recalculate_offsets = 0;
-    if (frame_num++ == 0)
-        recalculate_offsets = 1;
-    else if (memcmp(&current_settings, &prior_settings, sizeof(VP8_LOOP_SETTINGS))){
-        recalculate_offsets = 1;
+    lf->recalculate_offsets = 0;
+    if (lf->frame_num++ == 0)
+        lf->recalculate_offsets = 1;
+    else if (memcmp(&current_settings, &lf->prior_settings, sizeof(VP8_LOOP_SETTINGS))){
+        lf->recalculate_offsets = 1;
     }
 #endif
 
     
-    if (recalculate_offsets == 1){
-        if (cm->MBs <= loop_mem.num_blocks)
+    if (lf->recalculate_offsets == 1){
+        if (cm->MBs <= lf->mem.num_blocks)
             cl_populate_loop_mem(mbd, post); //populate pitches_mem
         else
             cl_grow_loop_mem(mbd, post, cm);
         
         //Copy the current frame's settings for later re-use
-        memcpy(&prior_settings, &current_settings, sizeof(VP8_LOOP_SETTINGS));
+        memcpy(&lf->prior_settings, &current_settings, sizeof(VP8_LOOP_SETTINGS));
         
         //map offsets_mem
         if (cm->filter_type == NORMAL_LOOPFILTER)
@@ -625,10 +619,10 @@ void vp8_loop_filter_frame_cl
         else
             offsets_size = sizeof(cl_int)*cm->MBs;
 
-        max_blocks = 0;
+        lf->max_blocks = 0;
             
 #if MAP_OFFSETS
-        VP8_CL_MAP_BUF(mbd->cl_commands, loop_mem.offsets_mem, offsets, offsets_size,,)
+        VP8_CL_MAP_BUF(mbd->cl_commands, lf->mem.offsets_mem, offsets, offsets_size,,)
 #else
         offsets = malloc(offsets_size);
         if (offsets == NULL){
@@ -640,12 +634,12 @@ void vp8_loop_filter_frame_cl
     }
 
     args.buf_mem = post->buffer_mem;
-    args.lfi_mem = lfi_mem;
-    args.offsets_mem = loop_mem.offsets_mem;
-    args.pitches_mem = loop_mem.pitches_mem;
-    args.filters_mem = loop_mem.filters_mem;
-    args.block_offsets_mem = loop_mem.block_offsets_mem;
-    args.priority_num_blocks_mem = loop_mem.priority_num_blocks_mem;
+    args.lfi_mem = lf->lfi_mem;
+    args.offsets_mem = lf->mem.offsets_mem;
+    args.pitches_mem = lf->mem.pitches_mem;
+    args.filters_mem = lf->mem.filters_mem;
+    args.block_offsets_mem = lf->mem.block_offsets_mem;
+    args.priority_num_blocks_mem = lf->mem.priority_num_blocks_mem;
     args.frame_type = cm->frame_type;
     
     //Maximum priority = 2*(Height-1) + Width in Macroblocks
@@ -656,23 +650,23 @@ void vp8_loop_filter_frame_cl
                 y_offsets, u_offsets, v_offsets, dc_diffs, rows, cols, filter_levels, 
                 offsets
         );
-        if (max_blocks < priority_num_blocks[priority]){
-            max_blocks = priority_num_blocks[priority];
+        if (lf->max_blocks < lf->priority_num_blocks[priority]){
+            lf->max_blocks = lf->priority_num_blocks[priority];
         }
     }
     
-    if (recalculate_offsets == 1){
+    if (lf->recalculate_offsets == 1){
 #if MAP_OFFSETS
-        VP8_CL_UNMAP_BUF(mbd->cl_commands, loop_mem.offsets_mem, offsets,,);
+        VP8_CL_UNMAP_BUF_EV(mbd->cl_commands, lf->mem.offsets_mem, offsets, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE),,);
 #else
-        VP8_CL_SET_BUF(mbd->cl_commands, loop_mem.offsets_mem, offsets_size, offsets, vp8_loop_filter_frame(cm, mbd), )
+        VP8_CL_SET_BUF_EV(mbd->cl_commands, lf->mem.offsets_mem, offsets_size, offsets, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE), vp8_loop_filter_frame(cm, mbd), )
         free(offsets);
         offsets = NULL;
 #endif
         
         //Now re-send the block_offsets/priority_num_blocks buffers
-        VP8_CL_SET_BUF(mbd->cl_commands, loop_mem.priority_num_blocks_mem, sizeof(cl_int)*num_levels, priority_num_blocks, vp8_loop_filter_frame(cm, mbd), )
-        VP8_CL_SET_BUF(mbd->cl_commands, loop_mem.block_offsets_mem, sizeof(cl_int)*num_levels, block_offsets, vp8_loop_filter_frame(cm, mbd), )
+        VP8_CL_SET_BUF_EV(mbd->cl_commands, lf->mem.priority_num_blocks_mem, sizeof(cl_int)*num_levels, lf->priority_num_blocks, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE), vp8_loop_filter_frame(cm, mbd), )
+        VP8_CL_SET_BUF_EV(mbd->cl_commands, lf->mem.block_offsets_mem, sizeof(cl_int)*num_levels, lf->block_offsets, vp8_cl_profile_event(mbd->cl_profile, VP8_CL_PROF_LF_PARAM_WRITE), vp8_loop_filter_frame(cm, mbd), )
     }
     
     //Copy any needed buffer contents to the CL device
@@ -683,9 +677,53 @@ void vp8_loop_filter_frame_cl
         vp8_loop_filter_macroblocks_cl(cm,  mbd, priority, 1, &args);
     }
 
-    //Retrieve buffer contents
-#if 1 || USE_MAPPED_BUFFERS && (!defined(CL_MEM_USE_PERSISTENT_MEM_AMD) || (CL_MEM_USE_PERSISTENT_MEM_AMD != VP8_CL_MEM_ALLOC_TYPE))
-    buf = clEnqueueMapBuffer(mbd->cl_commands, post->buffer_mem, CL_TRUE, CL_MAP_READ, 0, post->frame_size * sizeof(cl_uint), 0, NULL, NULL, &err); \
+    //Queue up the read back of the filtered frame. The map completes once
+    //all of the kernels above have run, and is signalled by *done.
+    buf = clEnqueueMapBuffer(mbd->cl_commands, post->buffer_mem, CL_FALSE, CL_MAP_READ, 0, post->frame_size * sizeof(cl_uint), 0, NULL, done, &err);
+    VP8_CL_CHECK_SUCCESS(mbd->cl_commands, err != CL_SUCCESS,
+        "Error: Failed to read loop filter output!\n",
+        vp8_loop_filter_frame(cm, mbd),
+    );
+
+    lf->post = post;
+    lf->buf = buf;
+    lf->done = done;
+    lf->cq = mbd->cl_commands;
+    lf->profile = mbd->cl_profile;
+
+    //Make sure the device starts working while the host moves on.
+    clFlush(mbd->cl_commands);
+}
+
+/* Waits for the loop filter started by vp8_loop_filter_frame_cl_start() and
+ * copies the filtered frame back into the host frame buffer.
+ * Does nothing if no loop filter is in flight.
+ */
+void vp8_loop_filter_frame_cl_finish(VP8_LOOP_FILTER_CL *lf)
+{
+    YV12_BUFFER_CONFIG *post = lf->post;
+    cl_uint *buf = lf->buf;
+    int err, i;
+
+    if (post == NULL)
+        return;
+
+    lf->post = NULL;
+    lf->buf = NULL;
+
+    err = clWaitForEvents(1, lf->done);
+    if (err == CL_SUCCESS)
+        vp8_cl_profile_record(lf->profile, VP8_CL_PROF_LF_FRAME_READ,
+                              *lf->done);
+    clReleaseEvent(*lf->done);
+    *lf->done = NULL;
+    lf->done = NULL;
+
+    VP8_CL_CHECK_SUCCESS(lf->cq, err != CL_SUCCESS,
+        "Error: Failed to read loop filter output!\n",
+        ,
+    );
+
     if (cl_data.vp8_loop_filter_uint_buffer){
         for (i = 0; i < post->frame_size; i++){
             post->buffer_alloc[i] = (unsigned char)buf[i];
@@ -693,15 +731,38 @@ void vp8_loop_filter_frame_cl
     } else {
         vpx_memcpy(post->buffer_alloc, buf, post->frame_size);
     }
-    VP8_CL_UNMAP_BUF(mbd->cl_commands, post->buffer_mem, buf,,);
-#else
-    err = clEnqueueReadBuffer(mbd->cl_commands, post->buffer_mem, CL_FALSE, 0, post->frame_size, post->buffer_alloc, 0, NULL, NULL);
-#endif
-    
-    VP8_CL_CHECK_SUCCESS(mbd->cl_commands, err != CL_SUCCESS,
-        "Error: Failed to read loop filter output!\n",
-        ,
-    );
+    VP8_CL_UNMAP_BUF(lf->cq, post->buffer_mem, buf,,);
+
+    VP8_CL_FINISH(lf->cq);
+}
+
+int vp8_loop_filter_frame_cl_pending(VP8_LOOP_FILTER_CL *lf)
+{
+    return lf->post != NULL;
+}
+
+/* Finishes the loop filter in flight, if any, and releases the buffers. */
+void vp8_loop_filter_cl_free(VP8_LOOP_FILTER_CL *lf)
+{
+    vp8_loop_filter_frame_cl_finish(lf);
+
+    cl_free_loop_mem(lf);
+
+    if (lf->lfi_mem != NULL){
+        clReleaseMemObject(lf->lfi_mem);
+        lf->lfi_mem = NULL;
+    }
+    lf->frame_num = 0;
+}
+
+void vp8_loop_filter_frame_cl
+(
+    VP8_COMMON *cm,
+    MACROBLOCKD *mbd
+)
+{
+    cl_event done;
 
-    VP8_CL_FINISH(mbd->cl_commands);
+    vp8_loop_filter_frame_cl_start(cm, mbd, &done);
+    vp8_loop_filter_frame_cl_finish(mbd->cl_lf);
 }
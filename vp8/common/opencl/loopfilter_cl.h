@@ -31,6 +31,46 @@ typedef struct VP8_LOOPFILTER_ARGS{
     cl_int frame_type;
 } VP8_LOOPFILTER_ARGS;
 
+typedef struct VP8_LOOP_SETTINGS{
+    int y_stride;
+    int uv_stride;
+    LOOPFILTERTYPE filter_type;
+    int mbrows;
+    int mbcols;
+} VP8_LOOP_SETTINGS;
+
+typedef struct VP8_LOOP_MEM{
+    cl_int num_blocks;
+    cl_mem offsets_mem;
+    cl_mem pitches_mem;
+    cl_mem filters_mem;
+    
+    cl_mem block_offsets_mem;
+    cl_mem priority_num_blocks_mem;
+} VP8_LOOP_MEM;
+
+//Loop filter state of one decoder. The device buffers are reused from frame
+//to frame, so each decoder needs its own copy. A zeroed struct is ready for
+//use, and vp8_loop_filter_cl_free() releases it.
+typedef struct VP8_LOOP_FILTER_CL{
+    VP8_LOOP_MEM mem;
+    cl_mem lfi_mem;
+
+    VP8_LOOP_SETTINGS prior_settings;
+    int frame_num;
+    cl_int *block_offsets;
+    cl_int *priority_num_blocks;
+    int recalculate_offsets;
+    int max_blocks;
+
+    //Loop filter that has been enqueued but whose output hasn't been read back.
+    YV12_BUFFER_CONFIG *post;
+    cl_uint *buf;
+    cl_event *done;     //Owned by the caller, signalled once buf is valid
+    cl_command_queue cq;
+    struct VP8_CL_PROFILE *profile;
+} VP8_LOOP_FILTER_CL;
+
 #define prototype_loopfilter_cl(sym) \
     void sym(MACROBLOCKD *x, VP8_LOOPFILTER_ARGS *args, \
                 int num_planes, int num_blocks)\
@@ -39,14 +79,40 @@ typedef struct VP8_LOOPFILTER_ARGS{
     void sym(MACROBLOCKD*, unsigned char *y, unsigned char *u, unsigned char *v,\
              int ystride, int uv_stride, loop_filter_info *lfi, int filter_level)
 
+//Loop filter kernel variants. combine_planes and uint_buffer are passed to
+//the kernels as build options, so changing them requires rebuilding the
+//program. group_planes only changes the work-group size used to enqueue.
+typedef struct VP8_CL_LF_TUNING{
+    int combine_planes; //1 = one 32-wide work-group filters U and V together
+    int uint_buffer;    //1 = frame is stored as uint on the device, 0 = uchar
+    int group_planes;   //1 = one 16x3 work-group filters all planes of a block
+                        //(only used when combine_planes == 0)
+} VP8_CL_LF_TUNING;
+
 void vp8_loop_filter_filters_init();
 
+extern int cl_init_loop_filter_tuning(const VP8_CL_LF_TUNING *tuning);
+extern void cl_destroy_loop_filter();
+
+extern int vp8_cl_loop_filter_read_tuning(VP8_CL_LF_TUNING *tuning);
+extern int vp8_cl_loop_filter_autotune(int verbose);
+
 extern void vp8_loop_filter_frame_cl
 (
     VP8_COMMON *cm,
     MACROBLOCKD *mbd
 );
 
+extern void vp8_loop_filter_frame_cl_start
+(
+    VP8_COMMON *cm,
+    MACROBLOCKD *mbd,
+    cl_event *done
+);
+extern void vp8_loop_filter_frame_cl_finish(VP8_LOOP_FILTER_CL *lf);
+extern int vp8_loop_filter_frame_cl_pending(VP8_LOOP_FILTER_CL *lf);
+extern void vp8_loop_filter_cl_free(VP8_LOOP_FILTER_CL *lf);
+
 extern prototype_loopfilter_block_cl(vp8_lf_normal_mb_v_cl);
 extern prototype_loopfilter_block_cl(vp8_lf_normal_b_v_cl);
 extern prototype_loopfilter_block_cl(vp8_lf_normal_mb_h_cl);
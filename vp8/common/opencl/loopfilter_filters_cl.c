@@ -16,6 +16,7 @@
 #include "vp8_opencl.h"
 #include "blockd_cl.h"
 #include "loopfilter_cl.h"
+#include "profile_cl.h"
 
 typedef unsigned char uc;
 
@@ -51,12 +52,14 @@ void vp8_loop_filter_filters_init()
 
 static int vp8_loop_filter_cl_run(
     cl_command_queue cq,
+    VP8_CL_PROFILE *prof,
     cl_kernel kernel,
     size_t max_local_size,
     VP8_LOOPFILTER_ARGS *args,
     int num_planes,
     int num_blocks,
-    VP8_LOOPFILTER_ARGS *current_args
+    VP8_LOOPFILTER_ARGS *current_args,
+    VP8_CL_PROFILE_ID prof_id
 ){
 
     size_t global[3], local[3];
@@ -83,6 +86,11 @@ static int vp8_loop_filter_cl_run(
                 local[0] = 1; //drop to 1 thread per group if necessary.
                               //At this point it'd be better to probably disable CL
         }
+    } else if (cl_data.vp8_loop_filter_group_planes && global[1] > 1 &&
+            max_local_size >= local[0] * global[1]){
+        //All planes of a block share a work-group. They use the same filter
+        //level and edges, so the values cached by the first thread still hold.
+        local[1] = global[1];
     }
     
     err = 0;
@@ -102,7 +110,8 @@ static int vp8_loop_filter_cl_run(
     );
 
     /* Execute the kernel */
-    err = clEnqueueNDRangeKernel(cq, kernel, 3, NULL, global, local , 0, NULL, NULL);
+    err = clEnqueueNDRangeKernel(cq, kernel, 3, NULL, global, local , 0, NULL,
+            vp8_cl_profile_event(prof, prof_id));
     
     VP8_CL_CHECK_SUCCESS( cq, err != CL_SUCCESS,
         "Error: Failed to execute kernel!\n",
@@ -136,9 +145,10 @@ void vp8_loop_filter_all_edges_cl
         return;
     }
 
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_all_edges_kernel, 
-        local, args, num_planes, num_blocks, &filter_args[0]
+        local, args, num_planes, num_blocks, &filter_args[0],
+        VP8_CL_PROF_LF_ALL_EDGES
     );
 }
 
@@ -152,10 +162,11 @@ void vp8_loop_filter_horizontal_edges_cl
     int num_blocks
 )
 {
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_horizontal_edges_kernel, 
         cl_data.vp8_loop_filter_horizontal_edges_kernel_size, 
-        args, num_planes, num_blocks, &filter_args[1]
+        args, num_planes, num_blocks, &filter_args[1],
+        VP8_CL_PROF_LF_HORIZONTAL_EDGES
     );
 }
 
@@ -168,10 +179,11 @@ void vp8_loop_filter_vertical_edges_cl
     int num_blocks
 )
 {
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_vertical_edges_kernel, 
         cl_data.vp8_loop_filter_vertical_edges_kernel_size, 
-        args, num_planes, num_blocks, &filter_args[2]
+        args, num_planes, num_blocks, &filter_args[2],
+        VP8_CL_PROF_LF_VERTICAL_EDGES
     );
 }
 
@@ -198,9 +210,10 @@ void vp8_loop_filter_simple_all_edges_cl
         return;
     }
     
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_simple_all_edges_kernel, 
-        local, args, num_planes, num_blocks, &filter_args[3]
+        local, args, num_planes, num_blocks, &filter_args[3],
+        VP8_CL_PROF_LF_SIMPLE_ALL_EDGES
     );
 }
 
@@ -214,10 +227,11 @@ void vp8_loop_filter_simple_horizontal_edges_cl
     int num_blocks
 )
 {
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_simple_horizontal_edges_kernel, 
         cl_data.vp8_loop_filter_simple_horizontal_edges_kernel_size, 
-        args, num_planes, num_blocks, &filter_args[4]
+        args, num_planes, num_blocks, &filter_args[4],
+        VP8_CL_PROF_LF_SIMPLE_HORIZONTAL_EDGES
     );
 }
 
@@ -230,9 +244,10 @@ void vp8_loop_filter_simple_vertical_edges_cl
     int num_blocks
 )
 {
-    vp8_loop_filter_cl_run(x->cl_commands,
+    vp8_loop_filter_cl_run(x->cl_commands, x->cl_profile,
         cl_data.vp8_loop_filter_simple_vertical_edges_kernel, 
         cl_data.vp8_loop_filter_simple_vertical_edges_kernel_size, 
-        args, num_planes, num_blocks, &filter_args[5]
+        args, num_planes, num_blocks, &filter_args[5],
+        VP8_CL_PROF_LF_SIMPLE_VERTICAL_EDGES
     );
 }
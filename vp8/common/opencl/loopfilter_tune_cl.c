@@ -0,0 +1,274 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vpx_config.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/vpx_timer.h"
+#include "vp8_opencl.h"
+#include "loopfilter_cl.h"
+#include "../alloccommon.h"
+
+//Size of the synthetic frame used for timing, and number of timed runs.
+#define TUNE_WIDTH 1280
+#define TUNE_HEIGHT 720
+#define TUNE_FILTER_LEVEL 32
+#define TUNE_RUNS 8
+
+extern const char *loop_filter_cl_file_name;
+
+//Build options crossed with the work-group shape. group_planes has no effect
+//on the combined plane kernels, so it is only tried without them.
+static const VP8_CL_LF_TUNING lf_candidates[] = {
+    {0, 0, 0},
+    {0, 0, 1},
+    {0, 1, 0},
+    {0, 1, 1},
+    {1, 0, 0},
+    {1, 1, 0}
+};
+
+#define NUM_CANDIDATES (sizeof(lf_candidates) / sizeof(lf_candidates[0]))
+
+//The tuning is keyed by the kernel source as well as the device, so that it
+//is redone when the kernels change.
+static char *lf_tuning_file(){
+    char *src;
+    char *file;
+
+    src = cl_get_program_source(loop_filter_cl_file_name);
+    if (src == NULL)
+        return NULL;
+
+    file = cl_get_cache_file(loop_filter_cl_file_name, src, NULL, ".tune");
+    free(src);
+    return file;
+}
+
+//Reads the settings stored by vp8_cl_loop_filter_autotune() for the current
+//device. Returns 1 if tuning was found, 0 otherwise.
+int vp8_cl_loop_filter_read_tuning(VP8_CL_LF_TUNING *tuning){
+    VP8_CL_LF_TUNING t;
+    char *file;
+    FILE *f;
+    int ret = 0;
+
+    file = lf_tuning_file();
+    if (file == NULL)
+        return 0;
+
+    f = fopen(file, "r");
+    free(file);
+    if (f == NULL)
+        return 0;
+
+    if (fscanf(f, "combine_planes=%d uint_buffer=%d group_planes=%d",
+            &t.combine_planes, &t.uint_buffer, &t.group_planes) == 3){
+        *tuning = t;
+        ret = 1;
+    }
+
+    fclose(f);
+    return ret;
+}
+
+static int lf_write_tuning(const VP8_CL_LF_TUNING *tuning){
+    char buf[64];
+    char *file;
+    int ret;
+
+    file = lf_tuning_file();
+    if (file == NULL)
+        return -1;
+
+    sprintf(buf, "combine_planes=%d uint_buffer=%d group_planes=%d\n",
+            tuning->combine_planes, tuning->uint_buffer, tuning->group_planes);
+    ret = cl_write_cache_file(file, buf, strlen(buf));
+
+    free(file);
+    return ret;
+}
+
+static void lf_print_tuning(const VP8_CL_LF_TUNING *tuning){
+    printf("combine_planes=%d uint_buffer=%d group_planes=%d",
+           tuning->combine_planes, tuning->uint_buffer, tuning->group_planes);
+}
+
+//Fills the frame with a gradient plus noise, so that most edges fall within
+//the filter thresholds and take the full filter path.
+static void lf_fill_frame(unsigned char *buf, int size){
+    unsigned int seed = 0x12345678;
+    int i;
+
+    for (i = 0; i < size; i++){
+        seed = seed * 1103515245 + 12345;
+        buf[i] = (unsigned char)(64 + ((i >> 4) & 63) + ((seed >> 16) & 7));
+    }
+}
+
+//Times the currently built loop filter program. Returns the fastest of
+//TUNE_RUNS runs in microseconds, or -1 if OpenCL failed along the way.
+static long lf_time_frame(VP8_COMMON *cm, MACROBLOCKD *mbd, const unsigned char *src){
+    YV12_BUFFER_CONFIG *post = cm->frame_to_show;
+    struct vpx_usec_timer timer;
+    long best = -1;
+    long elapsed;
+    int run;
+
+    //The first run also uploads the offsets, so it isn't timed.
+    for (run = 0; run <= TUNE_RUNS; run++){
+        vpx_memcpy(post->buffer_alloc, src, post->frame_size);
+
+        vpx_usec_timer_start(&timer);
+        vp8_loop_filter_frame_cl(cm, mbd);
+        vpx_usec_timer_mark(&timer);
+
+        if (cl_initialized != CL_SUCCESS)
+            return -1;
+
+        elapsed = vpx_usec_timer_elapsed(&timer);
+        if (run > 0 && (best < 0 || elapsed < best))
+            best = elapsed;
+    }
+
+    return best;
+}
+
+//Times every loop filter variant on a synthetic frame, stores the fastest
+//one in the cache directory and leaves the loop filter built with it.
+//Variants whose output differs from the first one are rejected.
+int vp8_cl_loop_filter_autotune(int verbose){
+    VP8_COMMON cm;
+    MACROBLOCKD mbd;
+    VP8_LOOP_FILTER_CL lf;
+    YV12_BUFFER_CONFIG *post;
+    unsigned char *src = NULL;
+    unsigned char *ref = NULL;
+    long times[NUM_CANDIDATES];
+    int supported;
+    int best = -1;
+    int err;
+    unsigned int i;
+
+    vpx_memset(&cm, 0, sizeof(cm));
+    vpx_memset(&mbd, 0, sizeof(mbd));
+    vpx_memset(&lf, 0, sizeof(lf));
+    mbd.cl_lf = &lf;
+
+    //Sets up OpenCL as a side effect
+    vp8_create_common(&cm);
+    if (cl_initialized != CL_SUCCESS){
+        fprintf(stderr, "OpenCL is not available\n");
+        return VP8_CL_TRIED_BUT_FAILED;
+    }
+
+    if (vp8_alloc_frame_buffers(&cm, TUNE_WIDTH, TUNE_HEIGHT)){
+        vp8_remove_common(&cm);
+        return VP8_CL_TRIED_BUT_FAILED;
+    }
+
+    //All macroblocks are intra coded DC_PRED (zeroed mode info), so every
+    //edge gets filtered.
+    cm.frame_type = KEY_FRAME;
+    cm.filter_type = NORMAL_LOOPFILTER;
+    cm.filter_level = TUNE_FILTER_LEVEL;
+    cm.sharpness_level = 0;
+    vp8_loop_filter_init(&cm);
+    cm.frame_to_show = &cm.yv12_fb[cm.new_fb_idx];
+    post = cm.frame_to_show;
+
+    mbd.cl_commands = clCreateCommandQueue(cl_data.context, cl_data.device_id, 0, &err);
+    src = malloc(post->frame_size);
+    ref = malloc(post->frame_size);
+    if (!mbd.cl_commands || err != CL_SUCCESS || src == NULL || ref == NULL){
+        err = VP8_CL_TRIED_BUT_FAILED;
+        goto done;
+    }
+
+    lf_fill_frame(src, post->frame_size);
+
+    for (i = 0; i < NUM_CANDIDATES; i++){
+        times[i] = -1;
+
+        supported = 1;
+
+        vp8_loop_filter_cl_free(&lf);
+        cl_destroy_loop_filter();
+        if (cl_init_loop_filter_tuning(&lf_candidates[i]) == CL_SUCCESS){
+            //Plane groups need room for 16 threads for each of the 3 planes,
+            //otherwise the run would just repeat the ungrouped candidate.
+            if (lf_candidates[i].group_planes &&
+                    cl_data.vp8_loop_filter_all_edges_kernel_size < 16 * 3)
+                supported = 0;
+            else
+                times[i] = lf_time_frame(&cm, &mbd, src);
+        }
+
+        //A failure may have torn down the whole OpenCL context
+        if (cl_initialized != CL_SUCCESS){
+            err = VP8_CL_TRIED_BUT_FAILED;
+            goto done;
+        }
+
+        if (times[i] >= 0){
+            if (best < 0){
+                vpx_memcpy(ref, post->buffer_alloc, post->frame_size);
+            } else if (memcmp(ref, post->buffer_alloc, post->frame_size)){
+                times[i] = -1;
+            }
+        }
+
+        if (times[i] >= 0 && (best < 0 || times[i] < times[best]))
+            best = i;
+
+        if (verbose){
+            lf_print_tuning(&lf_candidates[i]);
+            if (!supported)
+                printf(": unsupported\n");
+            else if (times[i] >= 0)
+                printf(": %ld us\n", times[i]);
+            else
+                printf(": failed\n");
+        }
+    }
+
+    if (best < 0){
+        err = VP8_CL_TRIED_BUT_FAILED;
+        goto done;
+    }
+
+    if (verbose){
+        printf("Best: ");
+        lf_print_tuning(&lf_candidates[best]);
+        printf("\n");
+    }
+
+    if (lf_write_tuning(&lf_candidates[best]) && verbose)
+        printf("Couldn't save loop filter tuning\n");
+
+    vp8_loop_filter_cl_free(&lf);
+    cl_destroy_loop_filter();
+    err = cl_init_loop_filter_tuning(&lf_candidates[best]);
+
+done:
+    vp8_loop_filter_cl_free(&lf);
+    free(src);
+    free(ref);
+    if (mbd.cl_commands){
+        VP8_CL_FINISH(mbd.cl_commands);
+        clReleaseCommandQueue(mbd.cl_commands);
+    }
+    vp8_remove_common(&cm);
+
+    return err;
+}
@@ -0,0 +1,102 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "vpx_config.h"
+#include "profile_cl.h"
+
+static const struct {
+    const char *name;
+    vp8_cl_profile_kind_t kind;
+} prof_info[VP8_CL_PROF_NUM] = {
+    {"loop filter frame upload",        VP8_CL_PROFILE_WRITE},
+    {"loop filter parameter upload",    VP8_CL_PROFILE_WRITE},
+    {"loop_filter_all_edges",           VP8_CL_PROFILE_KERNEL},
+    {"loop_filter_horizontal_edges",    VP8_CL_PROFILE_KERNEL},
+    {"loop_filter_vertical_edges",      VP8_CL_PROFILE_KERNEL},
+    {"loop_filter_simple_all_edges",    VP8_CL_PROFILE_KERNEL},
+    {"loop_filter_simple_horizontal_edges", VP8_CL_PROFILE_KERNEL},
+    {"loop_filter_simple_vertical_edges", VP8_CL_PROFILE_KERNEL},
+    {"loop filter frame read back",     VP8_CL_PROFILE_READ}
+};
+
+void vp8_cl_profile_enable(VP8_CL_PROFILE *prof, int enable){
+    memset(prof, 0, sizeof(*prof));
+    prof->enabled = enable;
+}
+
+int vp8_cl_profile_enabled(VP8_CL_PROFILE *prof){
+    return prof != NULL && prof->enabled;
+}
+
+cl_event *vp8_cl_profile_event(VP8_CL_PROFILE *prof, VP8_CL_PROFILE_ID id){
+    if (!vp8_cl_profile_enabled(prof) ||
+            prof->num_pending == VP8_CL_PROFILE_MAX_PENDING)
+        return NULL;
+
+    prof->pending[prof->num_pending].id = id;
+    prof->pending[prof->num_pending].event = NULL;
+    return &prof->pending[prof->num_pending++].event;
+}
+
+void vp8_cl_profile_record(VP8_CL_PROFILE *prof, VP8_CL_PROFILE_ID id, cl_event event){
+    cl_ulong start, end;
+
+    if (!vp8_cl_profile_enabled(prof) || event == NULL)
+        return;
+
+    if (clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(start), &start, NULL) != CL_SUCCESS ||
+        clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(end), &end, NULL) != CL_SUCCESS)
+        return;
+
+    prof->count[id]++;
+    prof->frame_ns[id] += end - start;
+}
+
+void vp8_cl_profile_frame_done(VP8_CL_PROFILE *prof){
+    int i;
+
+    if (!vp8_cl_profile_enabled(prof))
+        return;
+
+    for (i = 0; i < prof->num_pending; i++){
+        //The enqueue may have failed and left no event behind
+        if (prof->pending[i].event != NULL){
+            vp8_cl_profile_record(prof, prof->pending[i].id, prof->pending[i].event);
+            clReleaseEvent(prof->pending[i].event);
+        }
+    }
+    prof->num_pending = 0;
+
+    for (i = 0; i < VP8_CL_PROF_NUM; i++){
+        prof->last_frame_ns[i] = prof->frame_ns[i];
+        prof->total_ns[i] += prof->frame_ns[i];
+        prof->frame_ns[i] = 0;
+    }
+    prof->frames++;
+}
+
+void vp8_cl_profile_get(VP8_CL_PROFILE *prof, vp8_cl_profile_t *profile){
+    int i;
+
+    memset(profile, 0, sizeof(*profile));
+    profile->frames = prof->frames;
+
+    for (i = 0; i < VP8_CL_PROF_NUM && i < VP8_CL_PROFILE_MAX_ENTRIES; i++){
+        profile->entries[i].name = prof_info[i].name;
+        profile->entries[i].kind = prof_info[i].kind;
+        profile->entries[i].count = prof->count[i];
+        profile->entries[i].last_frame_ns = prof->last_frame_ns[i];
+        profile->entries[i].total_ns = prof->total_ns[i];
+    }
+    profile->num_entries = i;
+}
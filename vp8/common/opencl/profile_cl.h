@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef PROFILE_CL_H
+#define PROFILE_CL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "vpx/vpx_decoder.h"
+#include "vpx/vp8dx.h"
+#include "vp8_opencl.h"
+
+//Commands that are timed when profiling is enabled
+typedef enum {
+    VP8_CL_PROF_LF_FRAME_WRITE,
+    VP8_CL_PROF_LF_PARAM_WRITE,
+    VP8_CL_PROF_LF_ALL_EDGES,
+    VP8_CL_PROF_LF_HORIZONTAL_EDGES,
+    VP8_CL_PROF_LF_VERTICAL_EDGES,
+    VP8_CL_PROF_LF_SIMPLE_ALL_EDGES,
+    VP8_CL_PROF_LF_SIMPLE_HORIZONTAL_EDGES,
+    VP8_CL_PROF_LF_SIMPLE_VERTICAL_EDGES,
+    VP8_CL_PROF_LF_FRAME_READ,
+    VP8_CL_PROF_NUM
+} VP8_CL_PROFILE_ID;
+
+//Commands per frame that can be timed. Anything beyond this is not counted.
+#define VP8_CL_PROFILE_MAX_PENDING 4096
+
+typedef struct VP8_CL_PENDING_EVENT{
+    VP8_CL_PROFILE_ID id;
+    cl_event event;
+} VP8_CL_PENDING_EVENT;
+
+//Profiling state of one decoder. It times the commands enqueued on that
+//decoder's command queue, which must be created with
+//CL_QUEUE_PROFILING_ENABLE. The functions below treat a NULL profile as
+//profiling being off.
+typedef struct VP8_CL_PROFILE{
+    int enabled;
+    VP8_CL_PENDING_EVENT pending[VP8_CL_PROFILE_MAX_PENDING];
+    int num_pending;
+
+    unsigned int frames;
+    unsigned int count[VP8_CL_PROF_NUM];
+    uint64_t frame_ns[VP8_CL_PROF_NUM];
+    uint64_t last_frame_ns[VP8_CL_PROF_NUM];
+    uint64_t total_ns[VP8_CL_PROF_NUM];
+} VP8_CL_PROFILE;
+
+extern void vp8_cl_profile_enable(VP8_CL_PROFILE *prof, int enable);
+extern int vp8_cl_profile_enabled(VP8_CL_PROFILE *prof);
+
+//Returns where to store the event of a command that is about to be enqueued,
+//or NULL if profiling is off. The event is read and released by
+//vp8_cl_profile_frame_done().
+extern cl_event *vp8_cl_profile_event(VP8_CL_PROFILE *prof, VP8_CL_PROFILE_ID id);
+
+//Adds the timing of an already completed command. The caller keeps
+//ownership of the event.
+extern void vp8_cl_profile_record(VP8_CL_PROFILE *prof, VP8_CL_PROFILE_ID id, cl_event event);
+
+//Collects the events of the current frame. All commands enqueued with
+//vp8_cl_profile_event() must have completed.
+extern void vp8_cl_profile_frame_done(VP8_CL_PROFILE *prof);
+
+extern void vp8_cl_profile_get(VP8_CL_PROFILE *prof, vp8_cl_profile_t *profile);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROFILE_CL_H */
@@ -12,8 +12,20 @@
 #include <string.h>
 #include <stdlib.h>
 #include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define CL_MKDIR(dir) _mkdir(dir)
+#define CL_GETPID() _getpid()
+#else
+#include <unistd.h>
+#define CL_MKDIR(dir) mkdir(dir, 0755)
+#define CL_GETPID() getpid()
+#endif
 
+#include "vpx/vpx_integer.h"
 #include "vp8_opencl.h"
+#include "vp8_cl_sources.h"
 
 int cl_initialized = VP8_CL_NOT_INITIALIZED;
 VP8_COMMON_CL cl_data;
@@ -373,153 +385,285 @@ void show_build_log(cl_program *prog_ref){
     free(buffer);
 }
 
-cl_int vp8_cl_save_binary(const char *file_name, const char *ext, cl_program *prog_ref, const char *prog_opts){
-    int err;
-    char *binary;
-    size_t size;
-    FILE *out;
-    
-    char *bin_file = malloc(strlen(file_name)+strlen(ext)+1);
-    if (bin_file == NULL){
-        return VP8_CL_TRIED_BUT_FAILED;
+//Directory used to cache compiled program binaries. VPX_CL_CACHE_DIR
+//overrides the default location, and setting it to an empty string disables
+//the cache. Returns NULL if no usable directory was found.
+static char *cl_get_cache_dir(){
+    const char *env = getenv("VPX_CL_CACHE_DIR");
+    const char *base;
+    const char *sub;
+    char *dir;
+
+    if (env != NULL){
+        if (*env == '\0')
+            return NULL;
+        base = env;
+        sub = "";
+    } else if ((base = getenv("XDG_CACHE_HOME")) != NULL && *base != '\0'){
+        sub = "/libvpx-opencl";
+    } else if ((base = getenv("HOME")) != NULL && *base != '\0'){
+        sub = "/.cache/libvpx-opencl";
+    } else {
+        return NULL;
     }
-    strcpy(bin_file, file_name);
-    strcat(bin_file, ext);
-    
-    err = clBuildProgram(*prog_ref, 0, NULL, prog_opts, NULL, NULL);
-    clGetProgramInfo( *prog_ref, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL );
 
-    binary = (char *)malloc(size);
-    if (binary == NULL){
-        free(bin_file);
-        printf("Couldn't allocate memory to save binary kernel\n");
-        return VP8_CL_TRIED_BUT_FAILED;
+    dir = malloc(strlen(base) + strlen(sub) + 1);
+    if (dir == NULL)
+        return NULL;
+    strcpy(dir, base);
+    strcat(dir, sub);
+
+    //Create each missing component of the path. Failures show up as a
+    //failure to write the binary later on, which is harmless.
+    {
+        char *p;
+        for (p = dir + 1; *p; p++){
+            if (*p == '/'){
+                *p = '\0';
+                CL_MKDIR(dir);
+                *p = '/';
+            }
+        }
+        CL_MKDIR(dir);
     }
 
-    err = clGetProgramInfo( *prog_ref, CL_PROGRAM_BINARIES, sizeof(char**), &binary, NULL );
-    VP8_CL_CHECK_SUCCESS(NULL, err != CL_SUCCESS, "Couldn't get program info\n", , VP8_CL_TRIED_BUT_FAILED);
-    
-    out = fopen( bin_file, "wb" );
-    if (out != NULL){
-        fwrite( binary, sizeof(char), size, out );
-        fclose( out );
-    } else {
-        //printf("Couldn't save binary kernel\n");
+    return dir;
+}
+
+//64-bit FNV-1a, used to key cached binaries.
+static void cl_hash_bytes(uint64_t *hash, const void *data, size_t len){
+    const unsigned char *bytes = (const unsigned char *)data;
+    size_t i;
+
+    for (i = 0; i < len; i++){
+        *hash ^= bytes[i];
+        *hash *= 0x100000001b3ULL;
     }
-    
-    free(bin_file);
-    
-    return CL_SUCCESS;
+    //Separate consecutive fields so that "ab"+"c" != "a"+"bc"
+    *hash ^= 0xff;
+    *hash *= 0x100000001b3ULL;
 }
 
-int cl_use_binary_kernel(char *src_file, char *bin_file){
-    int ret;
+static void cl_hash_device_info(uint64_t *hash, cl_device_info param){
+    char buf[1024];
+    size_t len;
 
-    struct stat src_stat;
-    struct stat bin_stat;
-    
-    ret = (bin_file != NULL);
-    if (bin_file == NULL){
-        return ret;
+    if (clGetDeviceInfo(cl_data.device_id, param, sizeof(buf), buf, &len) != CL_SUCCESS)
+        len = 0;
+    if (len > sizeof(buf))
+        len = sizeof(buf);
+    cl_hash_bytes(hash, buf, len);
+}
+
+//Allocates and returns the path of the cache file with extension ext for the
+//given program source and build options on the current device, or NULL if
+//there is no cache directory.
+char *cl_get_cache_file(const char *file_name, const char *src, const char *opts, const char *ext){
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const char *base_name;
+    char *cache_dir;
+    char *bin_file;
+
+    cache_dir = cl_get_cache_dir();
+    if (cache_dir == NULL)
+        return NULL;
+
+    cl_hash_bytes(&hash, src, strlen(src));
+    cl_hash_bytes(&hash, opts != NULL ? opts : "", opts != NULL ? strlen(opts) : 0);
+    cl_hash_device_info(&hash, CL_DEVICE_VENDOR);
+    cl_hash_device_info(&hash, CL_DEVICE_NAME);
+    cl_hash_device_info(&hash, CL_DEVICE_VERSION);
+    cl_hash_device_info(&hash, CL_DRIVER_VERSION);
+
+    base_name = strrchr(file_name, '/');
+    base_name = base_name != NULL ? base_name + 1 : file_name;
+
+    //dir + '/' + name + '-' + 16 hex digits + ext
+    bin_file = malloc(strlen(cache_dir) + strlen(base_name) + strlen(ext) + 19);
+    if (bin_file != NULL){
+        sprintf(bin_file, "%s/%s-%08x%08x%s", cache_dir, base_name,
+                (unsigned int)(hash >> 32), (unsigned int)hash, ext);
     }
-    
-    //Stat the two files. If either fails, use current return code
-    //Note: Useful if you have source or binary kernels, but not both
-    if (stat(src_file, &src_stat) || stat(bin_file, &bin_stat)){
+
+    free(cache_dir);
+    return bin_file;
+}
+
+//Writes data to file_name. The data is written to a temporary file which is
+//then renamed, so that concurrent processes never see a partially written
+//file.
+int cl_write_cache_file(const char *file_name, const void *data, size_t size){
+    int ret = -1;
+    size_t written;
+    char *tmp_file;
+    FILE *out;
+
+    tmp_file = malloc(strlen(file_name) + 16);
+    if (tmp_file == NULL)
         return ret;
-    }
-        
-    //Get the modified date for each, and make sure that binary is newer than src
-#ifdef __APPLE__
-    ret = bin_stat.st_mtime > src_stat.st_mtime;
-#else
-    ret = bin_stat.st_mtim.tv_sec > src_stat.st_mtim.tv_sec;
+    sprintf(tmp_file, "%s.%u.tmp", file_name, (unsigned int)CL_GETPID());
+
+    out = fopen(tmp_file, "wb");
+    if (out != NULL){
+        written = fwrite(data, 1, size, out);
+        if (fclose(out) == 0 && written == size){
+#ifdef _WIN32
+            //rename() doesn't replace existing files on Windows
+            remove(file_name);
 #endif
-    
+            ret = rename(tmp_file, file_name);
+        }
+        if (ret != 0)
+            remove(tmp_file);
+    }
+
+    free(tmp_file);
     return ret;
 }
 
+//Writes the binary of a built program to bin_file.
+static void cl_save_binary(cl_program prog, const char *bin_file){
+    int err;
+    unsigned char *binary;
+    size_t size;
+
+    err = clGetProgramInfo(prog, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL);
+    if (err != CL_SUCCESS || size == 0)
+        return;
+
+    binary = malloc(size);
+    if (binary == NULL)
+        return;
+
+    err = clGetProgramInfo(prog, CL_PROGRAM_BINARIES, sizeof(binary), &binary, NULL);
+    if (err != CL_SUCCESS){
+        free(binary);
+        return;
+    }
+
+    cl_write_cache_file(bin_file, binary, size);
+    free(binary);
+}
+
+//Creates and builds a program from a cached binary. Returns NULL if the
+//binary is missing or can't be used on this device.
+static cl_program cl_load_binary(const char *bin_file, const char *opts){
+    int err;
+    cl_int status;
+    cl_program prog;
+    char *kernel_bin;
+    size_t size;
+    FILE *f;
+
+    //Avoid the error message printed by cl_read_file on a cache miss
+    f = fopen(bin_file, "rb");
+    if (f == NULL)
+        return NULL;
+    fclose(f);
+
+    kernel_bin = cl_read_binary_file(bin_file, &size);
+    if (kernel_bin == NULL)
+        return NULL;
+
+    prog = clCreateProgramWithBinary(cl_data.context, 1, &(cl_data.device_id), &size, (const unsigned char**)&kernel_bin, &status, &err);
+    free(kernel_bin);
+
+    if (prog != NULL && (status != CL_SUCCESS || err != CL_SUCCESS ||
+            clBuildProgram(prog, 0, NULL, opts, NULL, NULL) != CL_SUCCESS)){
+        //Stale or corrupt binary. It gets replaced after the source build.
+        clReleaseProgram(prog);
+        prog = NULL;
+    }
+
+    return prog;
+}
+
+//Allocates and returns the kernel source for file_name. The sources are
+//embedded in the library at build time. For kernel development,
+//VPX_CL_SOURCE_DIR can point at a source tree to read the .cl files from.
+char *cl_get_program_source(const char *file_name){
+    const char *src_dir = getenv("VPX_CL_SOURCE_DIR");
+    char *src_file;
+    char *src;
+    size_t size;
+    int i;
+
+    if (src_dir != NULL && *src_dir != '\0'){
+        src_file = malloc(strlen(src_dir) + strlen(file_name) + 5);
+        if (src_file == NULL)
+            return NULL;
+        sprintf(src_file, "%s/%s.cl", src_dir, file_name);
+        src = cl_read_source_file(src_file, &size);
+        free(src_file);
+        return src;
+    }
+
+    for (i = 0; vp8_cl_sources[i].name != NULL; i++){
+        if (!strcmp(vp8_cl_sources[i].name, file_name)){
+            src = malloc(strlen(vp8_cl_sources[i].src) + 1);
+            if (src != NULL)
+                strcpy(src, vp8_cl_sources[i].src);
+            return src;
+        }
+    }
+
+    //Not embedded, look for the file in the CWD and library directory
+    src_file = cl_get_file_path(file_name, ".cl");
+    src = cl_read_source_file(src_file, &size);
+    free(src_file);
+    return src;
+}
+
 int cl_load_program(cl_program *prog_ref, const char *file_name, const char *opts) {
 
     int err;
-    char *src_file = NULL;
-    char *bin_file = NULL;
+    char *bin_file;
     char *kernel_src;
-    char *kernel_bin;
-    size_t size; //Size of loaded kernel src/bin file
-    
+
     *prog_ref = NULL;
 
-    src_file = cl_get_file_path(file_name, ".cl");
-    bin_file = cl_get_file_path(file_name, ".bin");
-
-    if (cl_use_binary_kernel(src_file, bin_file)){
-        //Attempt to load binary kernel first
-        kernel_bin = cl_read_binary_file(bin_file, &size);
-        if (kernel_bin != NULL){
-            cl_int status;
-            *prog_ref = clCreateProgramWithBinary(cl_data.context, 1, &(cl_data.device_id), &size, (const unsigned char**)&kernel_bin, &status, &err);
-            if (status == CL_SUCCESS && err == CL_SUCCESS){
-                err = clBuildProgram(*prog_ref, 0, NULL, opts, NULL, NULL);
-                if (err != CL_SUCCESS || *prog_ref == NULL){
-                    //This block gets executed if binary was for wrong device type
-                    clReleaseProgram(*prog_ref);
-                    *prog_ref = NULL;
-                } else {
-                    //Binary loaded successfully. Free bin_file.
-                    free(bin_file);
-                }
-            } else {
-                if (*prog_ref != NULL){
-                    //The loaded binary was not a valid program at all...
-                    //This might mean it was from a different platform?
-                    //printf("Failed to create program from binary\n");
-                    clReleaseProgram(*prog_ref);
-                    *prog_ref = NULL;
-                }
-            }
-            free(kernel_bin);
-        }
+    kernel_src = cl_get_program_source(file_name);
+
+    if (kernel_src == NULL) {
+        cl_destroy(NULL, VP8_CL_TRIED_BUT_FAILED);
+        printf("Couldn't find OpenCL source files. \nUsing software path.\n");
+        return VP8_CL_TRIED_BUT_FAILED;
     }
-   
-    //Binary kernel failed, compile source instead
+
+    //The cache key covers everything that affects the compiled program, so a
+    //hit can be used without further checks.
+    bin_file = cl_get_cache_file(file_name, kernel_src, opts, ".bin");
+    if (bin_file != NULL)
+        *prog_ref = cl_load_binary(bin_file, opts);
+
+    //Cache miss, compile source instead
     if (*prog_ref == NULL){
-        kernel_src = cl_read_source_file(src_file, &size);
-        free(src_file);
+        const char *src = kernel_src;
+        *prog_ref = clCreateProgramWithSource(cl_data.context, 1, &src, NULL, &err);
 
-        if (kernel_src != NULL) {
-            const char *src = kernel_src;
-            *prog_ref = clCreateProgramWithSource(cl_data.context, 1, &src, NULL, &err);
+        if (*prog_ref == NULL || err != CL_SUCCESS) {
+            printf("Error: Couldn't create program: %d\n", err);
             free(kernel_src);
+            free(bin_file);
+            return VP8_CL_TRIED_BUT_FAILED;
+        }
 
-            if (err != CL_SUCCESS) {
-                printf("Error creating program: %d\n", err);
-            }
-            
-            //Attempt to save program binary
-            if (*prog_ref != NULL){
-                vp8_cl_save_binary(file_name, ".bin", prog_ref, opts);
-                free(bin_file);
-                
-                /* Build the program executable */
-                err = clBuildProgram(*prog_ref, 0, NULL, opts, NULL, NULL);
-                if (err != CL_SUCCESS) {
-                    printf("Error: Failed to build program executable for %s!\n", file_name);
-                    show_build_log(prog_ref);
-                    return VP8_CL_TRIED_BUT_FAILED;
-                }
-            } else {
-                printf("Error: Couldn't create program\n");
-                free(bin_file);
-                return VP8_CL_TRIED_BUT_FAILED;
-            }
-        } else {
-            cl_destroy(NULL, VP8_CL_TRIED_BUT_FAILED);
+        /* Build the program executable */
+        err = clBuildProgram(*prog_ref, 0, NULL, opts, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to build program executable for %s!\n", file_name);
+            show_build_log(prog_ref);
+            free(kernel_src);
             free(bin_file);
-            printf("Couldn't find OpenCL source files. \nUsing software path.\n");
             return VP8_CL_TRIED_BUT_FAILED;
         }
+
+        if (bin_file != NULL)
+            cl_save_binary(*prog_ref, bin_file);
     }
 
+    free(kernel_src);
+    free(bin_file);
+
     return CL_SUCCESS;
 }
@@ -53,6 +53,9 @@ extern "C" {
 extern int cl_common_init();
 extern void cl_destroy(cl_command_queue cq, int new_status);
 extern int cl_load_program(cl_program *prog_ref, const char *file_name, const char *opts);
+extern char *cl_get_program_source(const char *file_name);
+extern char *cl_get_cache_file(const char *file_name, const char *src, const char *opts, const char *ext);
+extern int cl_write_cache_file(const char *file_name, const void *data, size_t size);
 
 #define MAX_NUM_PLATFORMS 4
 #define MAX_NUM_DEVICES 10
@@ -130,9 +133,13 @@ extern const char *vpx_codec_lib_dir(void);
     ); \
 
 #define VP8_CL_SET_BUF(cq, bufRef, bufSize, dataPtr, altPath, retCode) \
+    VP8_CL_SET_BUF_EV(cq, bufRef, bufSize, dataPtr, NULL, altPath, retCode)
+
+//Same as VP8_CL_SET_BUF, but also returns an event for the write.
+#define VP8_CL_SET_BUF_EV(cq, bufRef, bufSize, dataPtr, event, altPath, retCode) \
     { \
         err = clEnqueueWriteBuffer(cq, bufRef, CL_TRUE, 0, \
-            bufSize, dataPtr, 0, NULL, NULL); \
+            bufSize, dataPtr, 0, NULL, event); \
         \
         VP8_CL_CHECK_SUCCESS(cq, err != CL_SUCCESS, \
             "Error: Failed to write to buffer!\n", \
@@ -156,7 +163,11 @@ extern const char *vpx_codec_lib_dir(void);
     ); \
 
 #define VP8_CL_UNMAP_BUF(cq, pinnedBufRef, dataPtr, altPath, retCode) \
-    err = clEnqueueUnmapMemObject(cq, pinnedBufRef, dataPtr, 0, NULL, NULL ); \
+    VP8_CL_UNMAP_BUF_EV(cq, pinnedBufRef, dataPtr, NULL, altPath, retCode)
+
+//Same as VP8_CL_UNMAP_BUF, but also returns an event for the unmap.
+#define VP8_CL_UNMAP_BUF_EV(cq, pinnedBufRef, dataPtr, event, altPath, retCode) \
+    err = clEnqueueUnmapMemObject(cq, pinnedBufRef, dataPtr, 0, NULL, event ); \
     VP8_CL_CHECK_SUCCESS(cq, err != CL_SUCCESS, \
         "Error: Failed to unmap buffer!\n", \
         altPath, retCode\
@@ -251,6 +262,7 @@ typedef struct VP8_COMMON_CL {
     
     int vp8_loop_filter_combine_planes;
     int vp8_loop_filter_uint_buffer;
+    int vp8_loop_filter_group_planes;
     
     cl_program dequant_program;
     cl_kernel vp8_dequant_dc_idct_add_kernel;
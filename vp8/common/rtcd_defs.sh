@@ -376,6 +376,15 @@ specialize vp8_sad16x8x4d sse3
 prototype void vp8_sad16x16x4d "const unsigned char *src_ptr, int source_stride, unsigned char *ref_ptr[4], int  ref_stride, unsigned int *sad_array"
 specialize vp8_sad16x16x4d sse3
 
+#
+# Sum of absolute Hadamard transformed differences (SATD)
+#
+prototype unsigned int vp8_satd4x4 "const unsigned char *src_ptr, int source_stride, const unsigned char *ref_ptr, int ref_stride"
+specialize vp8_satd4x4 sse2
+
+prototype unsigned int vp8_satd8x8 "const unsigned char *src_ptr, int source_stride, const unsigned char *ref_ptr, int ref_stride"
+specialize vp8_satd8x8 sse2
+
 #
 # Block copy
 #
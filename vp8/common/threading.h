@@ -82,6 +82,18 @@
 
 #endif
 
+#ifdef _WIN32
+/* Atomic add, returns the previous value */
+#define sync_fetch_and_add(ptr, val) InterlockedExchangeAdd((volatile LONG *)(ptr), (val))
+/* Atomic compare and swap, returns whether *ptr was oldval and got replaced */
+#define sync_bool_compare_and_swap(ptr, oldval, newval) (InterlockedCompareExchange((volatile LONG *)(ptr), (newval), (oldval)) == (oldval))
+#else
+/* Atomic add, returns the previous value */
+#define sync_fetch_and_add(ptr, val) __sync_fetch_and_add((ptr), (val))
+/* Atomic compare and swap, returns whether *ptr was oldval and got replaced */
+#define sync_bool_compare_and_swap(ptr, oldval, newval) __sync_bool_compare_and_swap((ptr), (oldval), (newval))
+#endif
+
 #if ARCH_X86 || ARCH_X86_64
 #include "vpx_ports/x86.h"
 #else
@@ -410,6 +410,13 @@ decode_mb_row(VP8D_COMP *pbi, VP8_COMMON *pc, int mb_row, MACROBLOCKD *xd)
         {
             /* propagate errors from reference frames */
             xd->corrupted |= pc->yv12_fb[ref_fb_idx].corrupted;
+
+#if CONFIG_OPENCL
+            /* The reference may still be loop filtered on the OpenCL
+             * device; everything up to here overlapped with it.
+             */
+            vp8_decode_frame_cl_wait_reference(pbi, ref_fb_idx);
+#endif
         }
 
         decode_macroblock(pbi, xd, mb_row * pc->mb_cols  + mb_col);
@@ -786,6 +793,13 @@ int vp8_decode_frame(VP8D_COMP *pbi)
                                        "Invalid frame height");
                 }
 
+#if CONFIG_OPENCL
+                /* A frame still queued for output lives in one of the
+                 * buffers about to be reallocated.
+                 */
+                vp8_decode_frame_cl_flush_delayed(pbi, Width, Height);
+#endif
+
                 if (vp8_alloc_frame_buffers(pc, pc->Width, pc->Height))
                     vpx_internal_error(&pc->error, VPX_CODEC_MEM_ERROR,
                                        "Failed to allocate frame buffers");
@@ -1100,6 +1114,10 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     {
         int i;
         pbi->frame_corrupt_residual = 0;
+#if CONFIG_OPENCL
+        /* The threads read the reference frames right away. */
+        vp8_decode_frame_cl_wait_loop_filter(pbi);
+#endif
         vp8mt_decode_mb_rows(pbi, xd);
         vp8_yv12_extend_frame_borders_ptr(&pc->yv12_fb[pc->new_fb_idx]);    /*cm->frame_to_show);*/
         for (i = 0; i < pbi->decoding_thread_count; ++i)
@@ -41,7 +41,9 @@
 #if CONFIG_OPENCL
 #include "vp8/common/opencl/blockd_cl.h"
 #include "vp8/common/opencl/vp8_opencl.h"
-static cl_command_queue cl_commands = NULL;
+#include "vp8/common/opencl/loopfilter_cl.h"
+#include "opencl/decodframe_cl.h"
+#include "vp8/common/opencl/profile_cl.h"
 #endif
 
 extern void vp8_init_loop_filter(VP8_COMMON *cm);
@@ -129,6 +131,16 @@ struct VP8D_COMP * vp8dx_create_decompressor(VP8D_CONFIG *oxcf)
      */
     pbi->independent_partitions = 0;
 
+#if CONFIG_OPENCL
+    pbi->cl_async_lf = oxcf->async_loopfilter;
+    pbi->cl_delayed_idx = -1;
+    pbi->cl_output_idx = -1;
+
+    /* Profiling needs to be set up before the command queue is created. */
+    pbi->cl_commands = NULL;
+    vp8_cl_profile_enable(&pbi->cl_profile, oxcf->cl_profiling);
+#endif
+
     return pbi;
 }
 
@@ -139,8 +151,11 @@ void vp8dx_remove_decompressor(VP8D_COMP *pbi)
         return;
 
 #if CONFIG_OPENCL
-    if (cl_initialized == CL_SUCCESS){
-        clReleaseCommandQueue(cl_commands);
+    vp8_decode_frame_cl_wait_loop_filter(pbi);
+    vp8_loop_filter_cl_free(&pbi->cl_lf);
+    vp8_yv12_de_alloc_frame_buffer(&pbi->cl_flush_frame);
+    if (cl_initialized == CL_SUCCESS && pbi->cl_commands != NULL){
+        clReleaseCommandQueue(pbi->cl_commands);
     }
 #endif
     
@@ -175,6 +190,10 @@ vpx_codec_err_t vp8dx_get_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
         return pbi->common.error.error_code;
     }
 
+#if CONFIG_OPENCL
+    vp8_decode_frame_cl_wait_loop_filter(pbi);
+#endif
+
     if(cm->yv12_fb[ref_fb_idx].y_height != sd->y_height ||
         cm->yv12_fb[ref_fb_idx].y_width != sd->y_width ||
         cm->yv12_fb[ref_fb_idx].uv_height != sd->uv_height ||
@@ -207,6 +226,10 @@ vpx_codec_err_t vp8dx_set_reference(VP8D_COMP *pbi, VP8_REFFRAME ref_frame_flag,
         return pbi->common.error.error_code;
     }
 
+#if CONFIG_OPENCL
+    vp8_decode_frame_cl_wait_loop_filter(pbi);
+#endif
+
     if(cm->yv12_fb[*ref_fb_ptr].y_height != sd->y_height ||
         cm->yv12_fb[*ref_fb_ptr].y_width != sd->y_width ||
         cm->yv12_fb[*ref_fb_ptr].uv_height != sd->uv_height ||
@@ -257,6 +280,66 @@ static void ref_cnt_fb (int *buf, int *idx, int new_idx)
     buf[new_idx]++;
 }
 
+#if CONFIG_OPENCL
+/* Makes the frame waiting to be output the output of this call. */
+static void cl_output_delayed_frame(VP8D_COMP *pbi)
+{
+    if (pbi->cl_delayed_idx >= 0)
+        vp8_decode_frame_cl_wait_reference(pbi, pbi->cl_delayed_idx);
+
+    pbi->cl_output_idx = pbi->cl_delayed_idx;
+    pbi->cl_output_flushed = pbi->cl_delayed_flushed;
+    pbi->cl_output_show = pbi->cl_delayed_show;
+    pbi->cl_output_time_stamp = pbi->cl_delayed_time_stamp;
+    pbi->cl_delayed_idx = -1;
+    pbi->cl_delayed_flushed = 0;
+}
+
+/* Starts the loop filter of the frame just decoded on the OpenCL device
+ * without waiting for it, and makes the previously decoded frame the output
+ * of this call. The filter is waited for by the first macroblock of a later
+ * frame that predicts from it. A frame the multithreaded decoder has already
+ * filtered only goes through the output delay.
+ */
+static void cl_async_loop_filter_frame(VP8D_COMP *pbi, int64_t time_stamp,
+                                       int filtered)
+{
+    VP8_COMMON *cm = &pbi->common;
+    int idx = cm->frame_to_show - cm->yv12_fb;
+
+    /* Only one frame can be filtered at a time. */
+    vp8_decode_frame_cl_wait_loop_filter(pbi);
+    cl_output_delayed_frame(pbi);
+
+    /* Keep the new frame alive until it has been handed out. */
+    cm->fb_idx_ref_cnt[idx]++;
+    pbi->cl_delayed_idx = idx;
+    pbi->cl_delayed_show = cm->show_frame;
+    pbi->cl_delayed_time_stamp = time_stamp;
+
+    if (filtered)
+        return;
+
+    if (cm->filter_level)
+    {
+#if ENABLE_CL_LOOPFILTER
+        if (cl_initialized == CL_SUCCESS)
+        {
+            vp8_loop_filter_frame_cl_start(cm, &pbi->mb,
+                                           &pbi->cl_lf_done[idx]);
+            if (pbi->cl_lf_done[idx] != NULL)
+                return;
+        }
+        else
+#endif
+        vp8_loop_filter_frame(cm, &pbi->mb);
+    }
+
+    vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+    vp8_cl_profile_frame_done(&pbi->cl_profile);
+}
+#endif
+
 /* If any buffer copy / swapping is signalled it should be done here. */
 static int swap_frame_buffers (VP8_COMMON *cm)
 {
@@ -372,6 +455,30 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
         pbi->fragment_sizes[0] = 0;
     }
 
+#if CONFIG_OPENCL
+    if (pbi->cl_async_lf)
+    {
+        /* The application is done with the frame returned last time. */
+        if (pbi->cl_output_idx >= 0)
+        {
+            cm->fb_idx_ref_cnt[pbi->cl_output_idx]--;
+            pbi->cl_output_idx = -1;
+        }
+        pbi->cl_output_flushed = 0;
+
+        /* An empty buffer flushes out the last decoded frame. */
+        if (pbi->num_fragments <= 1 && pbi->fragment_sizes[0] == 0 &&
+            (pbi->cl_delayed_idx >= 0 || pbi->cl_delayed_flushed))
+        {
+            cl_output_delayed_frame(pbi);
+
+            pbi->ready_for_new_data = 0;
+            pbi->num_fragments = 0;
+            return 0;
+        }
+    }
+#endif
+
     if (!pbi->ec_active &&
         pbi->num_fragments <= 1 && pbi->fragment_sizes[0] == 0)
     {
@@ -444,18 +551,23 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
 
 #if CONFIG_OPENCL
     pbi->mb.cl_commands = NULL;
+    pbi->mb.cl_profile = NULL;
+    pbi->mb.cl_lf = NULL;
     if (cl_initialized == CL_SUCCESS){
         int err;
-        if (cl_commands == NULL){
+        if (pbi->cl_commands == NULL){
             //Create command queue for macroblock.
-            cl_commands = clCreateCommandQueue(cl_data.context, cl_data.device_id, 0, &err);
-            if (!cl_commands || err != CL_SUCCESS) {
+            pbi->cl_commands = clCreateCommandQueue(cl_data.context, cl_data.device_id,
+                vp8_cl_profile_enabled(&pbi->cl_profile) ? CL_QUEUE_PROFILING_ENABLE : 0, &err);
+            if (!pbi->cl_commands || err != CL_SUCCESS) {
                 printf("Error: Failed to create a command queue!\n");
                 cl_destroy(NULL, VP8_CL_TRIED_BUT_FAILED);
             }
         }
         
-        pbi->mb.cl_commands = cl_commands;
+        pbi->mb.cl_commands = pbi->cl_commands;
+        pbi->mb.cl_profile = &pbi->cl_profile;
+        pbi->mb.cl_lf = &pbi->cl_lf;
         pbi->mb.cl_predictor_mem = NULL;
         pbi->mb.cl_qcoeff_mem = NULL;
         pbi->mb.cl_dqcoeff_mem = NULL;
@@ -554,6 +666,12 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
             pbi->num_fragments = 0;
             return -1;
         }
+
+#if CONFIG_OPENCL
+        /* The threads have already loop filtered the frame. */
+        if (pbi->cl_async_lf)
+            cl_async_loop_filter_frame(pbi, time_stamp, 1);
+#endif
     } else
 #endif
     {
@@ -573,6 +691,12 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
             return -1;
         }
 
+#if CONFIG_OPENCL
+        if (pbi->cl_async_lf)
+            cl_async_loop_filter_frame(pbi, time_stamp, 0);
+        else
+#endif
+        {
         if(cm->filter_level)
         {
 
@@ -605,6 +729,10 @@ int vp8dx_receive_compressed_data(VP8D_COMP *pbi, unsigned long size, const unsi
         }
 #endif
         vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+#if CONFIG_OPENCL
+        vp8_cl_profile_frame_done(&pbi->cl_profile);
+#endif
+        }
     }
 
 #if CONFIG_OPENCL && ENABLE_CL_SUBPIXEL
@@ -711,6 +839,35 @@ int vp8dx_get_raw_frame(VP8D_COMP *pbi, YV12_BUFFER_CONFIG *sd, int64_t *time_st
     if (pbi->ready_for_new_data == 1)
         return ret;
 
+#if CONFIG_OPENCL
+    if (pbi->cl_async_lf)
+    {
+        /* Hand out the frame that was finished during the last call. */
+        if ((pbi->cl_output_idx < 0 && !pbi->cl_output_flushed) ||
+            !pbi->cl_output_show)
+            return ret;
+
+        pbi->ready_for_new_data = 1;
+        *time_stamp = pbi->cl_output_time_stamp;
+        *time_end_stamp = 0;
+
+        if (pbi->cl_output_flushed)
+        {
+            *sd = pbi->cl_flush_frame;
+            sd->y_width = pbi->cl_flush_width;
+            sd->y_height = pbi->cl_flush_height;
+            sd->uv_height = pbi->cl_flush_height / 2;
+            return 0;
+        }
+
+        *sd = pbi->common.yv12_fb[pbi->cl_output_idx];
+        sd->y_width = pbi->common.Width;
+        sd->y_height = pbi->common.Height;
+        sd->uv_height = pbi->common.Height / 2;
+        return 0;
+    }
+#endif
+
     /* ie no raw frame to show!!! */
     if (pbi->common.show_frame == 0)
         return ret;
@@ -20,6 +20,10 @@
 #if CONFIG_ERROR_CONCEALMENT
 #include "ec_types.h"
 #endif
+#if CONFIG_OPENCL
+#include "vp8/common/opencl/profile_cl.h"
+#include "vp8/common/opencl/loopfilter_cl.h"
+#endif
 
 typedef struct
 {
@@ -110,6 +114,34 @@ typedef struct VP8D_COMP
     int independent_partitions;
     int frame_corrupt_residual;
 
+#if CONFIG_OPENCL
+    cl_command_queue cl_commands;
+    VP8_CL_PROFILE cl_profile; /* timing of the commands on cl_commands */
+    VP8_LOOP_FILTER_CL cl_lf;  /* loop filter buffers and frame in flight */
+
+    /* Asynchronous loop filter: a frame is filtered on the OpenCL device
+     * while the next one is parsed, and handed out one call later.
+     */
+    int cl_async_lf;
+    cl_event cl_lf_done[NUM_YV12_BUFFERS]; /* filter of each frame buffer
+                                            * still running, or NULL */
+    int cl_delayed_idx;        /* decoded frame waiting to be output, or -1 */
+    int cl_delayed_flushed;    /* ... or it is in cl_flush_frame */
+    int cl_delayed_show;
+    int64_t cl_delayed_time_stamp;
+    int cl_output_idx;         /* frame returned by vp8dx_get_raw_frame, or -1 */
+    int cl_output_flushed;     /* ... or it is in cl_flush_frame */
+    int cl_output_show;
+    int64_t cl_output_time_stamp;
+
+    /* Copy of the frame waiting to be output when the frame buffers are
+     * reallocated for a new resolution, and its size.
+     */
+    YV12_BUFFER_CONFIG cl_flush_frame;
+    int cl_flush_width;
+    int cl_flush_height;
+#endif
+
 } VP8D_COMP;
 
 int vp8_decode_frame(VP8D_COMP *cpi);
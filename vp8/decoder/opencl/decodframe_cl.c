@@ -24,7 +24,10 @@
 #include "vp8/common/opencl/blockd_cl.h"
 #include "vp8/common/opencl/reconinter_cl.h"
 #include "vp8/common/opencl/dequantize_cl.h"
+#include "vp8/common/opencl/loopfilter_cl.h"
+#include "vp8/common/opencl/profile_cl.h"
 #endif
+#include "vpx_scale/yv12extend.h"
 
 #define PROFILE_OUTPUT 0
 
@@ -287,3 +290,55 @@ void vp8_decode_frame_cl_finish(VP8D_COMP *pbi){
 #endif
     }
 }
+
+/* Waits for the asynchronous loop filter of frame buffer idx, if it is still
+ * running, and finishes the frame so that it can be used for prediction or
+ * output.
+ */
+void vp8_decode_frame_cl_wait_reference(VP8D_COMP *pbi, int idx){
+    VP8_COMMON *cm = &pbi->common;
+
+    if (pbi->cl_lf_done[idx] == NULL)
+        return;
+
+    vp8_loop_filter_frame_cl_finish(&pbi->cl_lf);
+    vp8_cl_profile_frame_done(&pbi->cl_profile);
+    vp8_yv12_extend_frame_borders_ptr(&cm->yv12_fb[idx]);
+}
+
+/* Waits for the asynchronous loop filters of all frame buffers. */
+void vp8_decode_frame_cl_wait_loop_filter(VP8D_COMP *pbi){
+    int i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        vp8_decode_frame_cl_wait_reference(pbi, i);
+}
+
+/* Copies the frame waiting to be output out of the frame buffers, which are
+ * about to be reallocated for a new resolution, so that it is not lost.
+ * width and height are the size of the frame before the change.
+ */
+void vp8_decode_frame_cl_flush_delayed(VP8D_COMP *pbi, int width, int height){
+    VP8_COMMON *cm = &pbi->common;
+    YV12_BUFFER_CONFIG *src;
+
+    vp8_decode_frame_cl_wait_loop_filter(pbi);
+
+    if (pbi->cl_delayed_idx < 0)
+        return;
+
+    src = &cm->yv12_fb[pbi->cl_delayed_idx];
+
+    vp8_yv12_de_alloc_frame_buffer(&pbi->cl_flush_frame);
+    if (vp8_yv12_alloc_frame_buffer(&pbi->cl_flush_frame, src->y_width,
+                                    src->y_height, src->border))
+        vpx_internal_error(&cm->error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate flush frame buffer");
+
+    vp8_yv12_copy_frame_ptr(src, &pbi->cl_flush_frame);
+    pbi->cl_flush_width = width;
+    pbi->cl_flush_height = height;
+
+    pbi->cl_delayed_idx = -1;
+    pbi->cl_delayed_flushed = 1;
+}
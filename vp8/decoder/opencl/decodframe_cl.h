@@ -22,6 +22,10 @@ extern "C" {
 extern void mb_init_dequantizer_cl(MACROBLOCKD *xd);
 extern void vp8_decode_frame_cl_finish(VP8D_COMP *pbi);
 extern void vp8_decode_macroblock_cl(VP8D_COMP *pbi, MACROBLOCKD *xd, int eobtotal);
+extern void vp8_decode_frame_cl_wait_reference(VP8D_COMP *pbi, int idx);
+extern void vp8_decode_frame_cl_wait_loop_filter(VP8D_COMP *pbi);
+extern void vp8_decode_frame_cl_flush_delayed(VP8D_COMP *pbi, int width,
+                                              int height);
 
 
 #ifdef  __cplusplus
@@ -374,55 +374,109 @@ static void write_partition_size(unsigned char *cx_data, int size)
 
 }
 
-static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
-                                          unsigned char * cx_data_end,
-                                          int num_part)
+/* Packs the tokens of every num_part'th MB row, starting at first_row */
+static void pack_partition_tokens_c(VP8_COMP *cpi, vp8_writer *w,
+                                    int first_row, int num_part)
 {
-
-    int i;
-    unsigned char *ptr = cx_data;
-    unsigned char *ptr_end = cx_data_end;
+    unsigned int split;
+    int count = w->count;
+    unsigned int range = w->range;
+    unsigned int lowvalue = w->lowvalue;
     unsigned int shift;
-    vp8_writer *w;
-    ptr = cx_data;
+    int mb_row;
 
-    for (i = 0; i < num_part; i++)
+    for (mb_row = first_row; mb_row < cpi->common.mb_rows; mb_row += num_part)
     {
-        w = cpi->bc + i + 1;
-        vp8_start_encode(w, ptr, ptr_end);
+        TOKENEXTRA *p    = cpi->tplist[mb_row].start;
+        TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
+
+        while (p < stop)
         {
-            unsigned int split;
-            int count = w->count;
-            unsigned int range = w->range;
-            unsigned int lowvalue = w->lowvalue;
-            int mb_row;
+            const int t = p->Token;
+            vp8_token *const a = vp8_coef_encodings + t;
+            const vp8_extra_bit_struct *const b = vp8_extra_bits + t;
+            int i = 0;
+            const unsigned char *pp = p->context_tree;
+            int v = a->value;
+            int n = a->Len;
+
+            if (p->skip_eob_node)
+            {
+                n--;
+                i = 2;
+            }
 
-            for (mb_row = i; mb_row < cpi->common.mb_rows; mb_row += num_part)
+            do
             {
-                TOKENEXTRA *p    = cpi->tplist[mb_row].start;
-                TOKENEXTRA *stop = cpi->tplist[mb_row].stop;
+                const int bb = (v >> --n) & 1;
+                split = 1 + (((range - 1) * pp[i>>1]) >> 8);
+                i = vp8_coef_tree[i+bb];
 
-                while (p < stop)
+                if (bb)
                 {
-                    const int t = p->Token;
-                    vp8_token *const a = vp8_coef_encodings + t;
-                    const vp8_extra_bit_struct *const b = vp8_extra_bits + t;
-                    int i = 0;
-                    const unsigned char *pp = p->context_tree;
-                    int v = a->value;
-                    int n = a->Len;
+                    lowvalue += split;
+                    range = range - split;
+                }
+                else
+                {
+                    range = split;
+                }
+
+                shift = vp8_norm[range];
+                range <<= shift;
+                count += shift;
 
-                    if (p->skip_eob_node)
+                if (count >= 0)
+                {
+                    int offset = shift - count;
+
+                    if ((lowvalue << (offset - 1)) & 0x80000000)
                     {
-                        n--;
-                        i = 2;
+                        int x = w->pos - 1;
+
+                        while (x >= 0 && w->buffer[x] == 0xff)
+                        {
+                            w->buffer[x] = (unsigned char)0;
+                            x--;
+                        }
+
+                        w->buffer[x] += 1;
                     }
 
+                    validate_buffer(w->buffer + w->pos,
+                                    1,
+                                    w->buffer_end,
+                                    w->error);
+
+                    w->buffer[w->pos++] = (lowvalue >> (24 - offset));
+
+                    lowvalue <<= offset;
+                    shift = count;
+                    lowvalue &= 0xffffff;
+                    count -= 8 ;
+                }
+
+                lowvalue <<= shift;
+            }
+            while (n);
+
+
+            if (b->base_val)
+            {
+                const int e = p->Extra, L = b->Len;
+
+                if (L)
+                {
+                    const unsigned char *pp = b->prob;
+                    int v = e >> 1;
+                    int n = L;              /* number of bits in v, assumed nonzero */
+                    int i = 0;
+
                     do
                     {
                         const int bb = (v >> --n) & 1;
                         split = 1 + (((range - 1) * pp[i>>1]) >> 8);
-                        i = vp8_coef_tree[i+bb];
+                        i = b->tree[i+bb];
 
                         if (bb)
                         {
@@ -457,10 +511,11 @@ static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
 
                             validate_buffer(w->buffer + w->pos,
                                             1,
-                                            cx_data_end,
-                                            &cpi->common.error);
+                                            w->buffer_end,
+                                            w->error);
 
-                            w->buffer[w->pos++] = (lowvalue >> (24 - offset));
+                            w->buffer[w->pos++] =
+                                (lowvalue >> (24 - offset));
 
                             lowvalue <<= offset;
                             shift = count;
@@ -471,137 +526,278 @@ static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
                         lowvalue <<= shift;
                     }
                     while (n);
+                }
+
+                {
+                    split = (range + 1) >> 1;
+
+                    if (e & 1)
+                    {
+                        lowvalue += split;
+                        range = range - split;
+                    }
+                    else
+                    {
+                        range = split;
+                    }
 
+                    range <<= 1;
 
-                    if (b->base_val)
+                    if ((lowvalue & 0x80000000))
                     {
-                        const int e = p->Extra, L = b->Len;
+                        int x = w->pos - 1;
 
-                        if (L)
+                        while (x >= 0 && w->buffer[x] == 0xff)
                         {
-                            const unsigned char *pp = b->prob;
-                            int v = e >> 1;
-                            int n = L;              /* number of bits in v, assumed nonzero */
-                            int i = 0;
+                            w->buffer[x] = (unsigned char)0;
+                            x--;
+                        }
 
-                            do
-                            {
-                                const int bb = (v >> --n) & 1;
-                                split = 1 + (((range - 1) * pp[i>>1]) >> 8);
-                                i = b->tree[i+bb];
+                        w->buffer[x] += 1;
 
-                                if (bb)
-                                {
-                                    lowvalue += split;
-                                    range = range - split;
-                                }
-                                else
-                                {
-                                    range = split;
-                                }
+                    }
 
-                                shift = vp8_norm[range];
-                                range <<= shift;
-                                count += shift;
+                    lowvalue  <<= 1;
 
-                                if (count >= 0)
-                                {
-                                    int offset = shift - count;
+                    if (!++count)
+                    {
+                        count = -8;
+                        validate_buffer(w->buffer + w->pos,
+                                        1,
+                                        w->buffer_end,
+                                        w->error);
 
-                                    if ((lowvalue << (offset - 1)) & 0x80000000)
-                                    {
-                                        int x = w->pos - 1;
+                        w->buffer[w->pos++] = (lowvalue >> 24);
 
-                                        while (x >= 0 && w->buffer[x] == 0xff)
-                                        {
-                                            w->buffer[x] = (unsigned char)0;
-                                            x--;
-                                        }
+                        lowvalue &= 0xffffff;
+                    }
+                }
 
-                                        w->buffer[x] += 1;
-                                    }
+            }
 
-                                    validate_buffer(w->buffer + w->pos,
-                                                    1,
-                                                    cx_data_end,
-                                                    &cpi->common.error);
+            ++p;
+        }
+    }
 
-                                    w->buffer[w->pos++] =
-                                        (lowvalue >> (24 - offset));
+    w->count    = count;
+    w->lowvalue = lowvalue;
+    w->range    = range;
+}
 
-                                    lowvalue <<= offset;
-                                    shift = count;
-                                    lowvalue &= 0xffffff;
-                                    count -= 8 ;
-                                }
+static void pack_tokens_into_partitions_c(VP8_COMP *cpi, unsigned char *cx_data,
+                                          unsigned char * cx_data_end,
+                                          int num_part)
+{
 
-                                lowvalue <<= shift;
-                            }
-                            while (n);
-                        }
+    int i;
+    unsigned char *ptr = cx_data;
+    unsigned char *ptr_end = cx_data_end;
+    vp8_writer *w;
 
-                        {
-                            split = (range + 1) >> 1;
+    for (i = 0; i < num_part; i++)
+    {
+        w = cpi->bc + i + 1;
+        vp8_start_encode(w, ptr, ptr_end);
+        pack_partition_tokens_c(cpi, w, i, num_part);
+        vp8_stop_encode(w);
+        ptr += w->pos;
+    }
+}
 
-                            if (e & 1)
-                            {
-                                lowvalue += split;
-                                range = range - split;
-                            }
-                            else
-                            {
-                                range = split;
-                            }
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+extern void vp8cx_wait_pack_thread(VP8_COMP *cpi);
 
-                            range <<= 1;
+typedef struct
+{
+    int num_part;
+    unsigned char *buf[MAX_PARTITIONS];
+    unsigned char *buf_end[MAX_PARTITIONS];
+    int failed[MAX_PARTITIONS];
+} PACK_PARTITIONS_JOB;
+
+/* Running out of space longjmps back here rather than to the application's
+ * handler, which was set up on another thread.
+ */
+static int pack_partition_mt(VP8_COMP *cpi, PACK_PARTITIONS_JOB *job, int i)
+{
+    struct vpx_internal_error_info error;
+    vp8_writer *w = cpi->bc + i + 1;
 
-                            if ((lowvalue & 0x80000000))
-                            {
-                                int x = w->pos - 1;
+    if (setjmp(error.jmp))
+        return 1;
 
-                                while (x >= 0 && w->buffer[x] == 0xff)
-                                {
-                                    w->buffer[x] = (unsigned char)0;
-                                    x--;
-                                }
+    error.setjmp = 1;
+    w->error = &error;
 
-                                w->buffer[x] += 1;
+    vp8_start_encode(w, job->buf[i], job->buf_end[i]);
+    pack_partition_tokens_c(cpi, w, i, job->num_part);
+    vp8_stop_encode(w);
 
-                            }
+    return 0;
+}
 
-                            lowvalue  <<= 1;
+static void pack_partitions_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread,
+                                 void *data)
+{
+    PACK_PARTITIONS_JOB *job = (PACK_PARTITIONS_JOB *)data;
+    int i;
+    (void) x;
 
-                            if (!++count)
-                            {
-                                count = -8;
-                                validate_buffer(w->buffer + w->pos,
-                                                1,
-                                                cx_data_end,
-                                                &cpi->common.error);
+    for (i = ithread; i < job->num_part; i += cpi->encoding_thread_count + 1)
+        job->failed[i] = pack_partition_mt(cpi, job, i);
+}
 
-                                w->buffer[w->pos++] = (lowvalue >> 24);
+/* Frees all the partition scratch buffers. */
+void vp8cx_free_partition_bufs(VP8_COMP *cpi)
+{
+    int i;
 
-                                lowvalue &= 0xffffff;
-                            }
-                        }
+    for (i = 0; i < MAX_PARTITIONS; i++)
+    {
+        vpx_free(cpi->partition_buf[i]);
+        cpi->partition_buf[i] = NULL;
+    }
 
-                    }
+    cpi->partition_buf_sz = 0;
+}
 
-                    ++p;
-                }
-            }
+/* Makes sure there are num_bufs partition scratch buffers of at least
+ * buf_sz bytes.
+ */
+void vp8cx_alloc_partition_bufs(VP8_COMP *cpi, unsigned int buf_sz,
+                                int num_bufs)
+{
+    int i;
+
+    if (cpi->partition_buf_sz < buf_sz)
+    {
+        vp8cx_free_partition_bufs(cpi);
+        cpi->partition_buf_sz = buf_sz;
+    }
+
+    for (i = 0; i < num_bufs; i++)
+    {
+        if (!cpi->partition_buf[i])
+            CHECK_MEM_ERROR(cpi->partition_buf[i],
+                            vpx_malloc(cpi->partition_buf_sz));
+    }
+}
+
+/* Copies the partitions that were packed elsewhere to their place after one
+ * another from cx_data on.
+ */
+static void place_partitions(VP8_COMP *cpi, unsigned char *cx_data,
+                             unsigned char * cx_data_end, int num_part)
+{
+    unsigned char *ptr = cx_data;
+    int i;
 
-            w->count    = count;
-            w->lowvalue = lowvalue;
-            w->range    = range;
+    for (i = 0; i < num_part; i++)
+    {
+        vp8_writer *w = cpi->bc + i + 1;
 
+        if (w->buffer != ptr)
+        {
+            validate_buffer(ptr, w->pos, cx_data_end, &cpi->common.error);
+            vpx_memcpy(ptr, w->buffer, w->pos);
+            w->buffer = ptr;
         }
 
-        vp8_stop_encode(w);
         ptr += w->pos;
     }
 }
 
+/* Packs the partitions at the same time. The first one goes straight to
+ * cx_data, the others to scratch buffers as large as the space left, which
+ * are then copied in behind it.
+ */
+static void pack_tokens_into_partitions_mt(VP8_COMP *cpi, unsigned char *cx_data,
+                                           unsigned char * cx_data_end,
+                                           int num_part)
+{
+    VP8_COMMON *pc = &cpi->common;
+    PACK_PARTITIONS_JOB job;
+    unsigned int buf_sz = cx_data_end - cx_data;
+    int i;
+
+    vp8cx_alloc_partition_bufs(cpi, buf_sz, num_part - 1);
+
+    job.num_part = num_part;
+    job.buf[0] = cx_data;
+    job.buf_end[0] = cx_data_end;
+
+    for (i = 1; i < num_part; i++)
+    {
+        job.buf[i] = cpi->partition_buf[i - 1];
+        job.buf_end[i] = cpi->partition_buf[i - 1] + buf_sz;
+    }
+
+    vp8cx_mt_run_job(cpi, pack_partitions_rows, &job);
+
+    for (i = 0; i < num_part; i++)
+    {
+        cpi->bc[i + 1].error = &pc->error;
+
+        if (job.failed[i])
+            vpx_internal_error(&pc->error, VPX_CODEC_CORRUPT_FRAME,
+                               "Truncated packet or corrupt partition ");
+    }
+
+    place_partitions(cpi, cx_data, cx_data_end, num_part);
+}
+
+/* Run on the packing thread while the frame is encoded, with token_row_sync.
+ * Each MB row is packed into its partition as soon as the encoder is done
+ * with its last MB, so that only the first partition is left to write when
+ * the frame is done. Partition i goes to partition_buf[i].
+ */
+void vp8cx_pack_tokens_row_sync(VP8_COMP *cpi)
+{
+    const int num_part = 1 << cpi->common.multi_token_partition;
+    struct vpx_internal_error_info error;
+    int mb_row;
+    int i;
+
+    /* see pack_partition_mt() */
+    if (setjmp(error.jmp))
+    {
+        cpi->token_row_sync_failed = 1;
+        return;
+    }
+
+    error.setjmp = 1;
+    cpi->token_row_sync_failed = 0;
+
+    for (i = 0; i < num_part; i++)
+    {
+        vp8_writer *w = cpi->bc + i + 1;
+
+        w->error = &error;
+        vp8_start_encode(w, cpi->partition_buf[i],
+                         cpi->partition_buf[i] + cpi->partition_buf_sz);
+    }
+
+    for (mb_row = 0; mb_row < cpi->common.mb_rows; mb_row++)
+    {
+        volatile const int *mb_col = &cpi->mt_current_mb_col[mb_row];
+
+        while (*mb_col < cpi->common.mb_cols - 1)
+        {
+            x86_pause_hint();
+            thread_sleep(0);
+        }
+
+        /* a row step of mb_rows packs just this row */
+        pack_partition_tokens_c(cpi, cpi->bc + 1 + (mb_row & (num_part - 1)),
+                                mb_row, cpi->common.mb_rows);
+    }
+
+    for (i = 0; i < num_part; i++)
+        vp8_stop_encode(cpi->bc + i + 1);
+}
+#endif
+
 
 static void pack_mb_row_tokens_c(VP8_COMP *cpi, vp8_writer *w)
 {
@@ -1422,20 +1618,35 @@ int vp8_estimate_entropy_savings(VP8_COMP *cpi)
         savings += (oldtotal - newtotal) / 256;
     }
 
+    {
+        /* also sets up frame_coef_probs and frame_branch_ct */
+        int coef_savings;
 
-    if (cpi->oxcf.error_resilient_mode & VPX_ERROR_RESILIENT_PARTITIONS)
-        savings += independent_coef_context_savings(cpi);
-    else
-        savings += default_coef_context_savings(cpi);
+        if (cpi->oxcf.error_resilient_mode & VPX_ERROR_RESILIENT_PARTITIONS)
+            coef_savings = independent_coef_context_savings(cpi);
+        else
+            coef_savings = default_coef_context_savings(cpi);
+
+#if CONFIG_MULTITHREAD
+        /* these updates only go out with the next frame, see
+         * vp8cx_pick_coef_probs_row_sync() */
+        if (cpi->token_row_sync)
+            coef_savings = 0;
+#endif
+
+        savings += coef_savings;
+    }
 
 
     return savings;
 }
 
-static void update_coef_probs(VP8_COMP *cpi)
+/* Decides which coefficient probabilities to update from frame_coef_probs
+ * and applies them. The updates are written to w unless it is NULL.
+ */
+static void update_coef_probs(VP8_COMP *cpi, vp8_writer *const w)
 {
     int i = 0;
-    vp8_writer *const w = cpi->bc;
     int savings = 0;
 
     vp8_clear_system_state(); //__asm emms;
@@ -1515,7 +1726,8 @@ static void update_coef_probs(VP8_COMP *cpi)
                         cpi->common.frame_type == KEY_FRAME && newp != *Pold)
                         u = 1;
 
-                    vp8_write(w, u, upd);
+                    if (w)
+                        vp8_write(w, u, upd);
 
 
 #ifdef ENTROPY_STATS
@@ -1527,7 +1739,9 @@ static void update_coef_probs(VP8_COMP *cpi)
                         /* send/use new probability */
 
                         *Pold = newp;
-                        vp8_write_literal(w, newp, 8);
+
+                        if (w)
+                            vp8_write_literal(w, newp, 8);
 
                         savings += s;
 
@@ -1556,6 +1770,40 @@ static void update_coef_probs(VP8_COMP *cpi)
     while (++i < BLOCK_TYPES);
 
 }
+
+#if CONFIG_MULTITHREAD
+/* With token_row_sync the tokens are packed while the frame is encoded, so
+ * the coefficient probabilities have to be settled before that. They are
+ * updated from the statistics of the previous frame instead of this one.
+ */
+void vp8cx_pick_coef_probs_row_sync(VP8_COMP *cpi)
+{
+    vpx_memcpy(cpi->coef_probs_row_sync, cpi->common.fc.coef_probs,
+               sizeof(cpi->coef_probs_row_sync));
+
+    update_coef_probs(cpi, NULL);
+}
+
+/* Writes the updates made by vp8cx_pick_coef_probs_row_sync() */
+static void write_coef_probs_row_sync(VP8_COMP *cpi, vp8_writer *const w)
+{
+    int i, j, k, t;
+
+    for (i = 0; i < BLOCK_TYPES; i++)
+        for (j = 0; j < COEF_BANDS; j++)
+            for (k = 0; k < PREV_COEF_CONTEXTS; k++)
+                for (t = 0; t < ENTROPY_NODES; t++)
+                {
+                    const vp8_prob newp = cpi->common.fc.coef_probs[i][j][k][t];
+                    const int u = newp != cpi->coef_probs_row_sync[i][j][k][t];
+
+                    vp8_write(w, u, vp8_coef_update_probs[i][j][k][t]);
+
+                    if (u)
+                        vp8_write_literal(w, newp, 8);
+                }
+}
+#endif
 #ifdef PACKET_TESTING
 FILE *vpxlogc = 0;
 #endif
@@ -1598,6 +1846,21 @@ void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned char * dest
 
     bc[0].error = &pc->error;
 
+#if CONFIG_MULTITHREAD
+    if (cpi->token_row_sync && cpi->b_multi_threaded)
+    {
+        /* token partitions were packed along with the MB rows */
+        vp8cx_wait_pack_thread(cpi);
+
+        for (i = 1; i < MAX_PARTITIONS; i++)
+            cpi->bc[i].error = &pc->error;
+
+        if (cpi->token_row_sync_failed)
+            vpx_internal_error(&pc->error, VPX_CODEC_CORRUPT_FRAME,
+                               "Truncated packet or corrupt partition ");
+    }
+#endif
+
     validate_buffer(cx_data, 3, cx_data_end, &cpi->common.error);
     cx_data += 3;
 
@@ -1848,7 +2111,19 @@ void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned char * dest
         vpx_memcpy(&cpi->common.lfc, &cpi->common.fc, sizeof(cpi->common.fc));
     }
 
-    update_coef_probs(cpi);
+#if CONFIG_MULTITHREAD
+    if (cpi->token_row_sync)
+    {
+        write_coef_probs_row_sync(cpi, bc);
+
+        // the updates were already applied to fc
+        if (pc->refresh_entropy_probs == 0)
+            vpx_memcpy(cpi->common.lfc.coef_probs, cpi->coef_probs_row_sync,
+                       sizeof(cpi->coef_probs_row_sync));
+    }
+    else
+#endif
+        update_coef_probs(cpi, bc);
 
 #ifdef ENTROPY_STATS
     active_section = 2;
@@ -1912,8 +2187,17 @@ void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned char * dest
             cpi->bc[i].error = &pc->error;
         }
 
-        pack_tokens_into_partitions(cpi, cx_data + 3 * (num_part - 1),
-                                    cx_data_end, num_part);
+#if CONFIG_MULTITHREAD
+        if (cpi->token_row_sync && cpi->b_multi_threaded)
+            place_partitions(cpi, cx_data + 3 * (num_part - 1),
+                             cx_data_end, num_part);
+        else if (cpi->b_multi_threaded)
+            pack_tokens_into_partitions_mt(cpi, cx_data + 3 * (num_part - 1),
+                                           cx_data_end, num_part);
+        else
+#endif
+            pack_tokens_into_partitions(cpi, cx_data + 3 * (num_part - 1),
+                                        cx_data_end, num_part);
 
         for(i = 1; i < num_part; i++)
         {
@@ -1931,16 +2215,23 @@ void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned char * dest
     {
         bc[1].error = &pc->error;
 
-        vp8_start_encode(&cpi->bc[1], cx_data, cx_data_end);
-
 #if CONFIG_MULTITHREAD
-        if (cpi->b_multi_threaded)
-            pack_mb_row_tokens(cpi, &cpi->bc[1]);
+        if (cpi->token_row_sync && cpi->b_multi_threaded)
+            place_partitions(cpi, cx_data, cx_data_end, 1);
         else
 #endif
-            pack_tokens(&cpi->bc[1], cpi->tok, cpi->tok_count);
+        {
+            vp8_start_encode(&cpi->bc[1], cx_data, cx_data_end);
 
-        vp8_stop_encode(&cpi->bc[1]);
+#if CONFIG_MULTITHREAD
+            if (cpi->b_multi_threaded)
+                pack_mb_row_tokens(cpi, &cpi->bc[1]);
+            else
+#endif
+                pack_tokens(&cpi->bc[1], cpi->tok, cpi->tok_count);
+
+            vp8_stop_encode(&cpi->bc[1]);
+        }
 
         *size += cpi->bc[1].pos;
         cpi->partition_sz[1] = cpi->bc[1].pos;
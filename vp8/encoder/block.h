@@ -103,6 +103,14 @@ typedef struct macroblock
     int mv_row_min;
     int mv_row_max;
 
+    // Half pel h, v and hv planes of the reference being searched, at the
+    // position of xd->pre.y_buffer. Null when they were not precomputed.
+    unsigned char *halfpel[3];
+
+    // 2x2 and 4x4 block sums of the same reference at xd->pre.y_buffer, to
+    // prune the full search with. Null when there are none.
+    unsigned short *block_sums[2];
+
     int skip;
 
     int encode_breakout;
@@ -0,0 +1,182 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "onyx_int.h"
+#include "blocksum.h"
+#include "vpx_mem/vpx_mem.h"
+
+void vp8_block_sums_free(VP8_COMP *cpi)
+{
+    int i, j;
+
+    for (i = 0; i < BLOCK_SUMS_MAX_SETS; i++)
+    {
+        for (j = 0; j < 2; j++)
+        {
+            vpx_free(cpi->block_sums[i].alloc[j]);
+            cpi->block_sums[i].alloc[j] = 0;
+            cpi->block_sums[i].buf[j] = 0;
+        }
+
+        cpi->block_sums[i].fb_idx = -1;
+    }
+
+    cpi->block_sums_sets = 0;
+    cpi->block_sums_size = 0;
+}
+
+void vp8_block_sums_alloc(VP8_COMP *cpi)
+{
+    YV12_BUFFER_CONFIG *fb = &cpi->common.yv12_fb[0];
+    int size = fb->y_stride * (fb->y_height + 2 * fb->border);
+    int sets = 0;
+    int i, j;
+
+    // Only rd_pick_best_mbsegmentation() in best quality uses full search
+    if (fb->y_width && cpi->compressor_speed == 0)
+        sets = BLOCK_SUMS_MAX_SETS;
+
+    if (sets != cpi->block_sums_sets || size != cpi->block_sums_size)
+    {
+        vp8_block_sums_free(cpi);
+
+        for (i = 0; i < sets; i++)
+            for (j = 0; j < 2; j++)
+            {
+                // The last rows and columns are never read
+                CHECK_MEM_ERROR(cpi->block_sums[i].alloc[j],
+                                vpx_calloc(size, sizeof(unsigned short)));
+                cpi->block_sums[i].buf[j] = cpi->block_sums[i].alloc[j] +
+                                            fb->border * fb->y_stride +
+                                            fb->border;
+            }
+
+        cpi->block_sums_sets = sets;
+        cpi->block_sums_size = size;
+
+        for (i = 0; i < MAX_REF_FRAMES; i++)
+            cpi->block_sums_ref[i] = 0;
+    }
+}
+
+void vp8_block_sums_invalidate(VP8_COMP *cpi, int fb_idx)
+{
+    int i;
+
+    for (i = 0; i < cpi->block_sums_sets; i++)
+        if (cpi->block_sums[i].fb_idx == fb_idx)
+            cpi->block_sums[i].fb_idx = -1;
+}
+
+static void build_sums(VP8_COMP *cpi, BLOCK_SUMS *sums, int fb_idx)
+{
+    YV12_BUFFER_CONFIG *src = &cpi->common.yv12_fb[fb_idx];
+    int stride = src->y_stride;
+    int rows = src->y_height + 2 * src->border;
+    int offset = src->border * stride + src->border;
+    int r, c;
+
+    // All 2x2 blocks of the bordered plane, borders included
+    for (r = 0; r < rows - 1; r++)
+    {
+        const unsigned char *s = src->y_buffer - offset + r * stride;
+        unsigned short *sum2 = sums->buf[0] - offset + r * stride;
+
+        for (c = 0; c < stride - 1; c++)
+            sum2[c] = s[c] + s[c+1] + s[c+stride] + s[c+stride+1];
+    }
+
+    // And the 4x4 blocks, from four 2x2 ones
+    for (r = 0; r < rows - 3; r++)
+    {
+        const unsigned short *sum2 = sums->buf[0] - offset + r * stride;
+        unsigned short *sum4 = sums->buf[1] - offset + r * stride;
+
+        for (c = 0; c < stride - 3; c++)
+            sum4[c] = sum2[c] + sum2[c+2] +
+                      sum2[c+2*stride] + sum2[c+2*stride+2];
+    }
+
+    sums->fb_idx = fb_idx;
+}
+
+void vp8_block_sums_prepare(VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+    static const int flags[MAX_REF_FRAMES] =
+    {
+        0, VP8_LAST_FLAG, VP8_GOLD_FLAG, VP8_ALT_FLAG
+    };
+    int fb_idx[MAX_REF_FRAMES];
+    int used[BLOCK_SUMS_MAX_SETS] = {0};
+    int ref, i;
+
+    fb_idx[LAST_FRAME] = cm->lst_fb_idx;
+    fb_idx[GOLDEN_FRAME] = cm->gld_fb_idx;
+    fb_idx[ALTREF_FRAME] = cm->alt_fb_idx;
+
+    // The frame is reconstructed into new_fb_idx, which is no reference
+    vp8_block_sums_invalidate(cpi, cm->new_fb_idx);
+
+    for (ref = 0; ref < MAX_REF_FRAMES; ref++)
+        cpi->block_sums_ref[ref] = 0;
+
+    if (cm->frame_type == KEY_FRAME)
+        return;
+
+    // Keep the sets already built from a reference in use
+    for (ref = LAST_FRAME; ref < MAX_REF_FRAMES; ref++)
+    {
+        if (!(cpi->ref_frame_flags & flags[ref]))
+            continue;
+
+        for (i = 0; i < cpi->block_sums_sets; i++)
+            if (cpi->block_sums[i].fb_idx == fb_idx[ref])
+            {
+                cpi->block_sums_ref[ref] = &cpi->block_sums[i];
+                used[i] = 1;
+            }
+    }
+
+    // There is a set for every reference, so the others can all be built
+    for (ref = LAST_FRAME; ref < MAX_REF_FRAMES; ref++)
+    {
+        if (!(cpi->ref_frame_flags & flags[ref]) || cpi->block_sums_ref[ref])
+            continue;
+
+        // Golden and altref may share a buffer built for a previous ref
+        for (i = 0; i < cpi->block_sums_sets; i++)
+            if (cpi->block_sums[i].fb_idx == fb_idx[ref])
+                break;
+
+        if (i == cpi->block_sums_sets)
+        {
+            for (i = 0; i < cpi->block_sums_sets; i++)
+                if (!used[i])
+                    break;
+
+            build_sums(cpi, &cpi->block_sums[i], fb_idx[ref]);
+        }
+
+        cpi->block_sums_ref[ref] = &cpi->block_sums[i];
+        used[i] = 1;
+    }
+}
+
+void vp8_block_sums_setup_mb(VP8_COMP *cpi, MACROBLOCK *x, int ref_frame,
+                             int recon_yoffset)
+{
+    BLOCK_SUMS *sums = cpi->block_sums_ref[ref_frame];
+    int i;
+
+    for (i = 0; i < 2; i++)
+        x->block_sums[i] = sums ? sums->buf[i] + recon_yoffset : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_BLOCKSUM_H
+#define __INC_BLOCKSUM_H
+
+/* One set of planes per reference frame */
+#define BLOCK_SUMS_MAX_SETS 3
+
+/* The sum of the 2x2 and of the 4x4 block of the luma of a reference frame
+ * at each pixel, with the same stride and border as the frame, for the
+ * successive elimination in the full search. These are what an integral
+ * image would give with four loads each, for one load.
+ */
+typedef struct
+{
+    unsigned short *alloc[2];
+    unsigned short *buf[2];   // origin of the 2x2 and 4x4 planes
+    int fb_idx;               // frame buffer they were built from, -1 if none
+} BLOCK_SUMS;
+
+struct VP8_COMP;
+struct macroblock;
+
+/* (Re)allocates the sets when the full search may be used, best quality
+ * only, and frees them otherwise. */
+extern void vp8_block_sums_alloc(struct VP8_COMP *cpi);
+extern void vp8_block_sums_free(struct VP8_COMP *cpi);
+
+/* Marks the planes built from frame buffer fb_idx as stale */
+extern void vp8_block_sums_invalidate(struct VP8_COMP *cpi, int fb_idx);
+
+/* Builds the planes of the references used by the frame about to be
+ * encoded where needed, and points cpi->block_sums_ref at them. */
+extern void vp8_block_sums_prepare(struct VP8_COMP *cpi);
+
+/* Points x->block_sums at the planes of ref_frame for the MB at
+ * recon_yoffset, or clears it when the reference has none. */
+extern void vp8_block_sums_setup_mb(struct VP8_COMP *cpi,
+                                    struct macroblock *x,
+                                    int ref_frame, int recon_yoffset);
+
+#endif
@@ -28,6 +28,9 @@
 #include <limits.h>
 #include "vp8/common/invtrans.h"
 #include "vpx_ports/vpx_timer.h"
+#if CONFIG_MULTI_RES_ENCODING
+#include "mr_dissim.h"
+#endif
 
 extern void vp8_stuff_mb(VP8_COMP *cpi, MACROBLOCKD *x, TOKENEXTRA **t) ;
 extern void vp8_calc_ref_frame_costs(int *ref_frame_cost,
@@ -38,6 +41,11 @@ extern void vp8_calc_ref_frame_costs(int *ref_frame_cost,
 extern void vp8_convert_rfct_to_prob(VP8_COMP *const cpi);
 extern void vp8cx_initialize_me_consts(VP8_COMP *cpi, int QIndex);
 extern void vp8_auto_select_speed(VP8_COMP *cpi);
+extern int vp8cx_claim_mb_row(VP8_COMP *cpi, MACROBLOCK *x);
+extern void vp8cx_start_encoding_threads(VP8_COMP *cpi);
+extern void vp8cx_run_queued_encoding_tasks(VP8_COMP *cpi);
+extern void vp8cx_start_lpf_thread(VP8_COMP *cpi);
+extern void vp8cx_start_pack_thread(VP8_COMP *cpi);
 extern void vp8cx_init_mbrthread_data(VP8_COMP *cpi,
                                       MACROBLOCK *x,
                                       MB_ROW_COMP *mbr_ei,
@@ -565,13 +573,6 @@ void encode_mb_row(VP8_COMP *cpi,
     // this is to account for the border
     xd->mode_info_context++;
     x->partition_info++;
-
-#if CONFIG_MULTITHREAD
-    if ((cpi->b_multi_threaded != 0) && (mb_row == cm->mb_rows - 1))
-    {
-        sem_post(&cpi->h_event_end_encoding); /* signal frame encoding end */
-    }
-#endif
 }
 
 void init_encode_frame_mb_context(VP8_COMP *cpi)
@@ -728,6 +729,18 @@ void vp8_encode_frame(VP8_COMP *cpi)
         build_activity_map(cpi);
     }
 
+    // Coarse motion to seed the MB searches with
+    if (cpi->sf.me_pyramid && cm->frame_type != KEY_FRAME)
+        vp8_me_pyramid_frame(cpi);
+
+    // Half pel planes of the references, reused by later frames
+    if (cpi->halfpel_sets)
+        vp8_halfpel_prepare(cpi);
+
+    // Block sums of the references to prune the full search with
+    if (cpi->block_sums_sets)
+        vp8_block_sums_prepare(cpi);
+
     // re-initencode frame context.
     init_encode_frame_mb_context(cpi);
 
@@ -745,31 +758,39 @@ void vp8_encode_frame(VP8_COMP *cpi)
             for (i = 0; i < cm->mb_rows; i++)
                 cpi->mt_current_mb_col[i] = -1;
 
-            for (i = 0; i < cpi->encoding_thread_count; i++)
-            {
-                sem_post(&cpi->h_event_start_encoding[i]);
-            }
+            cpi->mt_next_mb_row = 0;
 
-            for (mb_row = 0; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
+            if (cpi->lf_row_sync)
+                vp8cx_start_lpf_thread(cpi); /* filter rows as they are done */
+
+            if (cpi->token_row_sync)
+                vp8cx_start_pack_thread(cpi); /* pack rows as they are done */
+
+            vp8cx_start_encoding_threads(cpi);
+
+            while ((mb_row = vp8cx_claim_mb_row(cpi, x)) < cm->mb_rows)
             {
                 vp8_zero(cm->left_context)
 
                 tp = cpi->tok + mb_row * (cm->mb_cols * 16 * 24);
 
                 encode_mb_row(cpi, cm, mb_row, x, xd, &tp, segment_counts, &totalrate);
+#if CONFIG_MULTI_RES_ENCODING
+                if (cpi->mr_row_publish)
+                    vp8_mr_publish_rows(cpi, 0);
+#endif
+            }
 
-                // adjust to the next row of mbs
-                x->src.y_buffer += 16 * x->src.y_stride * (cpi->encoding_thread_count + 1) - 16 * cm->mb_cols;
-                x->src.u_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
-                x->src.v_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
-
-                xd->mode_info_context += xd->mode_info_stride * cpi->encoding_thread_count;
-                x->partition_info  += xd->mode_info_stride * cpi->encoding_thread_count;
-                x->gf_active_ptr   += cm->mb_cols * cpi->encoding_thread_count;
+            /* wait for other threads to finish */
+            vp8cx_run_queued_encoding_tasks(cpi);
 
-            }
+            for (i = 0; i < cpi->encoding_thread_count; i++)
+                sem_wait(&cpi->h_event_end_encoding);
 
-            sem_wait(&cpi->h_event_end_encoding); /* wait for other threads to finish */
+#if CONFIG_MULTI_RES_ENCODING
+            if (cpi->mr_row_publish)
+                vp8_mr_publish_rows(cpi, cm->mb_rows);
+#endif
 
             cpi->tok_count = 0;
 
@@ -810,6 +831,12 @@ void vp8_encode_frame(VP8_COMP *cpi)
 
                 encode_mb_row(cpi, cm, mb_row, x, xd, &tp, segment_counts, &totalrate);
 
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+                // let the next resolution up start on this row
+                if (cpi->mr_row_publish)
+                    vp8_mr_publish_rows(cpi, mb_row + 1);
+#endif
+
                 // adjust to the next row of mbs
                 x->src.y_buffer += 16 * x->src.y_stride - 16 * cm->mb_cols;
                 x->src.u_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
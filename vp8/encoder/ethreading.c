@@ -12,12 +12,16 @@
 #include "vp8/common/threading.h"
 #include "vp8/common/common.h"
 #include "vp8/common/extend.h"
+#if CONFIG_MULTI_RES_ENCODING
+#include "mr_dissim.h"
+#endif
 
 #if CONFIG_MULTITHREAD
 
 extern int vp8cx_encode_inter_macroblock(VP8_COMP *cpi, MACROBLOCK *x,
                                          TOKENEXTRA **t, int recon_yoffset,
-                                         int recon_uvoffset);
+                                         int recon_uvoffset, int mb_row,
+                                         int mb_col);
 extern int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x,
                                           TOKENEXTRA **t);
 extern void vp8cx_mb_init_quantizer(VP8_COMP *cpi, MACROBLOCK *x, int ok_to_skip);
@@ -25,11 +29,21 @@ extern void vp8_build_block_offsets(MACROBLOCK *x);
 extern void vp8_setup_block_ptrs(MACROBLOCK *x);
 
 extern void loopfilter_frame(VP8_COMP *cpi, VP8_COMMON *cm);
+extern void vp8cx_pack_tokens_row_sync(VP8_COMP *cpi);
+extern void vp8cx_free_partition_bufs(VP8_COMP *cpi);
+
+static void loopfilter_thread_run(VP8_COMP *cpi, int ithread)
+{
+    (void) ithread;
+
+    loopfilter_frame(cpi, &cpi->common);
+
+    sem_post(&cpi->h_event_end_lpf);
+}
 
 static THREAD_FUNCTION loopfilter_thread(void *p_data)
 {
     VP8_COMP *cpi = (VP8_COMP *)(((LPFTHREAD_DATA *)p_data)->ptr1);
-    VP8_COMMON *cm = &cpi->common;
 
     while (1)
     {
@@ -41,240 +55,301 @@ static THREAD_FUNCTION loopfilter_thread(void *p_data)
             if (cpi->b_multi_threaded == 0) // we're shutting down
                 break;
 
-            loopfilter_frame(cpi, cm);
-
-            sem_post(&cpi->h_event_end_lpf);
+            loopfilter_thread_run(cpi, 0);
         }
     }
 
     return 0;
 }
 
-static
-THREAD_FUNCTION thread_encoding_proc(void *p_data)
+static void pack_thread_run(VP8_COMP *cpi, int ithread)
 {
-    int ithread = ((ENCODETHREAD_DATA *)p_data)->ithread;
-    VP8_COMP *cpi = (VP8_COMP *)(((ENCODETHREAD_DATA *)p_data)->ptr1);
-    MB_ROW_COMP *mbri = (MB_ROW_COMP *)(((ENCODETHREAD_DATA *)p_data)->ptr2);
-    ENTROPY_CONTEXT_PLANES mb_row_left_context;
+    (void) ithread;
 
-    const int nsync = cpi->mt_sync_range;
-    //printf("Started thread %d\n", ithread);
+    vp8cx_pack_tokens_row_sync(cpi);
+
+    sem_post(&cpi->h_event_end_pack);
+}
+
+static THREAD_FUNCTION pack_thread(void *p_data)
+{
+    VP8_COMP *cpi = (VP8_COMP *)(((LPFTHREAD_DATA *)p_data)->ptr1);
 
     while (1)
     {
         if (cpi->b_multi_threaded == 0)
             break;
 
-        //if(WaitForSingleObject(cpi->h_event_mbrencoding[ithread], INFINITE) == WAIT_OBJECT_0)
-        if (sem_wait(&cpi->h_event_start_encoding[ithread]) == 0)
+        if (sem_wait(&cpi->h_event_start_pack) == 0)
         {
-            VP8_COMMON *cm = &cpi->common;
-            int mb_row;
-            MACROBLOCK *x = &mbri->mb;
-            MACROBLOCKD *xd = &x->e_mbd;
-            TOKENEXTRA *tp ;
-
-            int *segment_counts = mbri->segment_counts;
-            int *totalrate = &mbri->totalrate;
-
             if (cpi->b_multi_threaded == 0) // we're shutting down
                 break;
 
-            for (mb_row = ithread + 1; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
-            {
+            pack_thread_run(cpi, 0);
+        }
+    }
+
+    return 0;
+}
+
+/* Rows are handed out in order to whichever thread asks first, instead of
+ * round robin, so that a thread that got cheap rows goes on with the next
+ * one rather than waiting at the column sync. Each row still waits for the
+ * one above it to be mt_sync_range columns ahead. Returns the row and
+ * points x at it, or returns mb_rows when the frame is done.
+ */
+int vp8cx_claim_mb_row(VP8_COMP *cpi, MACROBLOCK *x)
+{
+    VP8_COMMON *const cm = &cpi->common;
+    MACROBLOCKD *const xd = &x->e_mbd;
+    int mb_row = sync_fetch_and_add(&cpi->mt_next_mb_row, 1);
+
+    if (mb_row >= cm->mb_rows)
+        return cm->mb_rows;
+
+    x->src.y_buffer = cpi->Source->y_buffer + 16 * mb_row * x->src.y_stride;
+    x->src.u_buffer = cpi->Source->u_buffer + 8 * mb_row * x->src.uv_stride;
+    x->src.v_buffer = cpi->Source->v_buffer + 8 * mb_row * x->src.uv_stride;
+
+    xd->mode_info_context = cm->mi + mb_row * xd->mode_info_stride;
+    x->partition_info = cpi->mb.pi + mb_row * xd->mode_info_stride;
+    x->gf_active_ptr = (signed char *)cpi->gf_active_flags + mb_row * cm->mb_cols;
+
+    return mb_row;
+}
 
-                int recon_yoffset, recon_uvoffset;
-                int mb_col;
-                int ref_fb_idx = cm->lst_fb_idx;
-                int dst_fb_idx = cm->new_fb_idx;
-                int recon_y_stride = cm->yv12_fb[ref_fb_idx].y_stride;
-                int recon_uv_stride = cm->yv12_fb[ref_fb_idx].uv_stride;
-                int map_index = (mb_row * cm->mb_cols);
-                volatile int *last_row_current_mb_col;
+// Does the work of encoding thread ithread for one start: its part of the
+// current job, or MB rows until there are none left.
+static void encoding_thread_run(VP8_COMP *cpi, int ithread)
+{
+    MB_ROW_COMP *mbri = &cpi->mb_row_ei[ithread];
+    ENTROPY_CONTEXT_PLANES mb_row_left_context;
+
+    const int nsync = cpi->mt_sync_range;
+    VP8_COMMON *cm = &cpi->common;
+    int mb_row;
+    MACROBLOCK *x = &mbri->mb;
+    MACROBLOCKD *xd = &x->e_mbd;
+    TOKENEXTRA *tp ;
 
-                tp = cpi->tok + (mb_row * (cm->mb_cols * 16 * 24));
+    int *segment_counts = mbri->segment_counts;
+    int *totalrate = &mbri->totalrate;
+
+    if (cpi->mt_job)
+    {
+        cpi->mt_job(cpi, x, ithread + 1, cpi->mt_job_data);
+        sem_post(&cpi->h_event_end_job);
+        return;
+    }
+
+    while ((mb_row = vp8cx_claim_mb_row(cpi, x)) < cm->mb_rows)
+    {
 
-                last_row_current_mb_col = &cpi->mt_current_mb_col[mb_row - 1];
+        int recon_yoffset, recon_uvoffset;
+        int mb_col;
+        int ref_fb_idx = cm->lst_fb_idx;
+        int dst_fb_idx = cm->new_fb_idx;
+        int recon_y_stride = cm->yv12_fb[ref_fb_idx].y_stride;
+        int recon_uv_stride = cm->yv12_fb[ref_fb_idx].uv_stride;
+        int map_index = (mb_row * cm->mb_cols);
+        const int rightmost_col = cm->mb_cols - 1;
+        volatile const int *last_row_current_mb_col;
 
-                // reset above block coeffs
-                xd->above_context = cm->above_context;
-                xd->left_context = &mb_row_left_context;
+        tp = cpi->tok + (mb_row * (cm->mb_cols * 16 * 24));
 
-                vp8_zero(mb_row_left_context);
+        if (mb_row != 0)
+            last_row_current_mb_col = &cpi->mt_current_mb_col[mb_row - 1];
+        else
+            last_row_current_mb_col = &rightmost_col;
 
-                xd->up_available = (mb_row != 0);
-                recon_yoffset = (mb_row * recon_y_stride * 16);
-                recon_uvoffset = (mb_row * recon_uv_stride * 8);
+        // reset above block coeffs
+        xd->above_context = cm->above_context;
+        xd->left_context = &mb_row_left_context;
 
-                cpi->tplist[mb_row].start = tp;
+        vp8_zero(mb_row_left_context);
 
-                //printf("Thread mb_row = %d\n", mb_row);
+        xd->up_available = (mb_row != 0);
+        recon_yoffset = (mb_row * recon_y_stride * 16);
+        recon_uvoffset = (mb_row * recon_uv_stride * 8);
 
-                // Set the mb activity pointer to the start of the row.
-                x->mb_activity_ptr = &cpi->mb_activity_map[map_index];
+        cpi->tplist[mb_row].start = tp;
 
-                // for each macroblock col in image
-                for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+        //printf("Thread mb_row = %d\n", mb_row);
+
+        // Set the mb activity pointer to the start of the row.
+        x->mb_activity_ptr = &cpi->mb_activity_map[map_index];
+
+        // for each macroblock col in image
+        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+        {
+            if ((mb_col & (nsync - 1)) == 0)
+            {
+                while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != cm->mb_cols - 1)
                 {
-                    if ((mb_col & (nsync - 1)) == 0)
-                    {
-                        while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != cm->mb_cols - 1)
-                        {
-                            x86_pause_hint();
-                            thread_sleep(0);
-                        }
-                    }
+                    x86_pause_hint();
+                    thread_sleep(0);
+                }
+            }
 
-                    // Distance of Mb to the various image edges.
-                    // These specified to 8th pel as they are always compared to values that are in 1/8th pel units
-                    xd->mb_to_left_edge = -((mb_col * 16) << 3);
-                    xd->mb_to_right_edge = ((cm->mb_cols - 1 - mb_col) * 16) << 3;
-                    xd->mb_to_top_edge = -((mb_row * 16) << 3);
-                    xd->mb_to_bottom_edge = ((cm->mb_rows - 1 - mb_row) * 16) << 3;
+            // Distance of Mb to the various image edges.
+            // These specified to 8th pel as they are always compared to values that are in 1/8th pel units
+            xd->mb_to_left_edge = -((mb_col * 16) << 3);
+            xd->mb_to_right_edge = ((cm->mb_cols - 1 - mb_col) * 16) << 3;
+            xd->mb_to_top_edge = -((mb_row * 16) << 3);
+            xd->mb_to_bottom_edge = ((cm->mb_rows - 1 - mb_row) * 16) << 3;
 
-                    // Set up limit values for motion vectors used to prevent them extending outside the UMV borders
-                    x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
-                    x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
-                    x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
-                    x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
+            // Set up limit values for motion vectors used to prevent them extending outside the UMV borders
+            x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
+            x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
+            x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
+            x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
 
-                    xd->dst.y_buffer = cm->yv12_fb[dst_fb_idx].y_buffer + recon_yoffset;
-                    xd->dst.u_buffer = cm->yv12_fb[dst_fb_idx].u_buffer + recon_uvoffset;
-                    xd->dst.v_buffer = cm->yv12_fb[dst_fb_idx].v_buffer + recon_uvoffset;
-                    xd->left_available = (mb_col != 0);
+            xd->dst.y_buffer = cm->yv12_fb[dst_fb_idx].y_buffer + recon_yoffset;
+            xd->dst.u_buffer = cm->yv12_fb[dst_fb_idx].u_buffer + recon_uvoffset;
+            xd->dst.v_buffer = cm->yv12_fb[dst_fb_idx].v_buffer + recon_uvoffset;
+            xd->left_available = (mb_col != 0);
 
-                    x->rddiv = cpi->RDDIV;
-                    x->rdmult = cpi->RDMULT;
+            x->rddiv = cpi->RDDIV;
+            x->rdmult = cpi->RDMULT;
 
-                    //Copy current mb to a buffer
-                    vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
+            //Copy current mb to a buffer
+            vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
 
-                    if (cpi->oxcf.tuning == VP8_TUNE_SSIM)
-                        vp8_activity_masking(cpi, x);
+            if (cpi->oxcf.tuning == VP8_TUNE_SSIM)
+                vp8_activity_masking(cpi, x);
 
-                    // Is segmentation enabled
-                    // MB level adjutment to quantizer
-                    if (xd->segmentation_enabled)
-                    {
-                        // Code to set segment id in xd->mbmi.segment_id for current MB (with range checking)
-                        if (cpi->segmentation_map[map_index + mb_col] <= 3)
-                            xd->mode_info_context->mbmi.segment_id = cpi->segmentation_map[map_index + mb_col];
-                        else
-                            xd->mode_info_context->mbmi.segment_id = 0;
+            // Is segmentation enabled
+            // MB level adjutment to quantizer
+            if (xd->segmentation_enabled)
+            {
+                // Code to set segment id in xd->mbmi.segment_id for current MB (with range checking)
+                if (cpi->segmentation_map[map_index + mb_col] <= 3)
+                    xd->mode_info_context->mbmi.segment_id = cpi->segmentation_map[map_index + mb_col];
+                else
+                    xd->mode_info_context->mbmi.segment_id = 0;
 
-                        vp8cx_mb_init_quantizer(cpi, x, 1);
-                    }
-                    else
-                        xd->mode_info_context->mbmi.segment_id = 0; // Set to Segment 0 by default
+                vp8cx_mb_init_quantizer(cpi, x, 1);
+            }
+            else
+                xd->mode_info_context->mbmi.segment_id = 0; // Set to Segment 0 by default
 
-                    x->active_ptr = cpi->active_map + map_index + mb_col;
+            x->active_ptr = cpi->active_map + map_index + mb_col;
 
-                    if (cm->frame_type == KEY_FRAME)
-                    {
-                        *totalrate += vp8cx_encode_intra_macro_block(cpi, x, &tp);
+            if (cm->frame_type == KEY_FRAME)
+            {
+                *totalrate += vp8cx_encode_intra_macro_block(cpi, x, &tp);
 #ifdef MODE_STATS
-                        y_modes[xd->mbmi.mode] ++;
+                y_modes[xd->mbmi.mode] ++;
 #endif
-                    }
-                    else
-                    {
-                        *totalrate += vp8cx_encode_inter_macroblock(cpi, x, &tp, recon_yoffset, recon_uvoffset);
+            }
+            else
+            {
+                *totalrate += vp8cx_encode_inter_macroblock(cpi, x, &tp, recon_yoffset, recon_uvoffset, mb_row, mb_col);
 
 #ifdef MODE_STATS
-                        inter_y_modes[xd->mbmi.mode] ++;
+                inter_y_modes[xd->mbmi.mode] ++;
 
-                        if (xd->mbmi.mode == SPLITMV)
-                        {
-                            int b;
+                if (xd->mbmi.mode == SPLITMV)
+                {
+                    int b;
 
-                            for (b = 0; b < xd->mbmi.partition_count; b++)
-                            {
-                                inter_b_modes[x->partition->bmi[b].mode] ++;
-                            }
-                        }
+                    for (b = 0; b < xd->mbmi.partition_count; b++)
+                    {
+                        inter_b_modes[x->partition->bmi[b].mode] ++;
+                    }
+                }
 
 #endif
 
-                        // Count of last ref frame 0,0 useage
-                        if ((xd->mode_info_context->mbmi.mode == ZEROMV) && (xd->mode_info_context->mbmi.ref_frame == LAST_FRAME))
-                            cpi->inter_zz_count++;
-
-                        // Special case code for cyclic refresh
-                        // If cyclic update enabled then copy xd->mbmi.segment_id; (which may have been updated based on mode
-                        // during vp8cx_encode_inter_macroblock()) back into the global sgmentation map
-                        if (cpi->cyclic_refresh_mode_enabled && xd->segmentation_enabled)
-                        {
-                            const MB_MODE_INFO * mbmi = &xd->mode_info_context->mbmi;
-                            cpi->segmentation_map[map_index + mb_col] = mbmi->segment_id;
-
-                            // If the block has been refreshed mark it as clean (the magnitude of the -ve influences how long it will be before we consider another refresh):
-                            // Else if it was coded (last frame 0,0) and has not already been refreshed then mark it as a candidate for cleanup next time (marked 0)
-                            // else mark it as dirty (1).
-                            if (mbmi->segment_id)
-                                cpi->cyclic_refresh_map[map_index + mb_col] = -1;
-                            else if ((mbmi->mode == ZEROMV) && (mbmi->ref_frame == LAST_FRAME))
-                            {
-                                if (cpi->cyclic_refresh_map[map_index + mb_col] == 1)
-                                    cpi->cyclic_refresh_map[map_index + mb_col] = 0;
-                            }
-                            else
-                                cpi->cyclic_refresh_map[map_index + mb_col] = 1;
-
-                        }
+                // Count of last ref frame 0,0 useage
+                if ((xd->mode_info_context->mbmi.mode == ZEROMV) && (xd->mode_info_context->mbmi.ref_frame == LAST_FRAME))
+                    cpi->inter_zz_count++;
+
+                // Special case code for cyclic refresh
+                // If cyclic update enabled then copy xd->mbmi.segment_id; (which may have been updated based on mode
+                // during vp8cx_encode_inter_macroblock()) back into the global sgmentation map
+                if (cpi->cyclic_refresh_mode_enabled && xd->segmentation_enabled)
+                {
+                    const MB_MODE_INFO * mbmi = &xd->mode_info_context->mbmi;
+                    cpi->segmentation_map[map_index + mb_col] = mbmi->segment_id;
+
+                    // If the block has been refreshed mark it as clean (the magnitude of the -ve influences how long it will be before we consider another refresh):
+                    // Else if it was coded (last frame 0,0) and has not already been refreshed then mark it as a candidate for cleanup next time (marked 0)
+                    // else mark it as dirty (1).
+                    if (mbmi->segment_id)
+                        cpi->cyclic_refresh_map[map_index + mb_col] = -1;
+                    else if ((mbmi->mode == ZEROMV) && (mbmi->ref_frame == LAST_FRAME))
+                    {
+                        if (cpi->cyclic_refresh_map[map_index + mb_col] == 1)
+                            cpi->cyclic_refresh_map[map_index + mb_col] = 0;
                     }
-                    cpi->tplist[mb_row].stop = tp;
+                    else
+                        cpi->cyclic_refresh_map[map_index + mb_col] = 1;
 
-                    // Increment pointer into gf useage flags structure.
-                    x->gf_active_ptr++;
+                }
+            }
+            cpi->tplist[mb_row].stop = tp;
 
-                    // Increment the activity mask pointers.
-                    x->mb_activity_ptr++;
+            // Increment pointer into gf useage flags structure.
+            x->gf_active_ptr++;
 
-                    // adjust to the next column of macroblocks
-                    x->src.y_buffer += 16;
-                    x->src.u_buffer += 8;
-                    x->src.v_buffer += 8;
+            // Increment the activity mask pointers.
+            x->mb_activity_ptr++;
 
-                    recon_yoffset += 16;
-                    recon_uvoffset += 8;
+            // adjust to the next column of macroblocks
+            x->src.y_buffer += 16;
+            x->src.u_buffer += 8;
+            x->src.v_buffer += 8;
 
-                    // Keep track of segment useage
-                    segment_counts[xd->mode_info_context->mbmi.segment_id]++;
+            recon_yoffset += 16;
+            recon_uvoffset += 8;
 
-                    // skip to next mb
-                    xd->mode_info_context++;
-                    x->partition_info++;
-                    xd->above_context++;
+            // Keep track of segment useage
+            segment_counts[xd->mode_info_context->mbmi.segment_id]++;
 
-                    cpi->mt_current_mb_col[mb_row] = mb_col;
-                }
+            // skip to next mb
+            xd->mode_info_context++;
+            x->partition_info++;
+            xd->above_context++;
 
-                //extend the recon for intra prediction
-                vp8_extend_mb_row(
-                    &cm->yv12_fb[dst_fb_idx],
-                    xd->dst.y_buffer + 16,
-                    xd->dst.u_buffer + 8,
-                    xd->dst.v_buffer + 8);
+            cpi->mt_current_mb_col[mb_row] = mb_col;
+        }
 
-                // this is to account for the border
-                xd->mode_info_context++;
-                x->partition_info++;
+        //extend the recon for intra prediction
+        vp8_extend_mb_row(
+            &cm->yv12_fb[dst_fb_idx],
+            xd->dst.y_buffer + 16,
+            xd->dst.u_buffer + 8,
+            xd->dst.v_buffer + 8);
 
-                x->src.y_buffer += 16 * x->src.y_stride * (cpi->encoding_thread_count + 1) - 16 * cm->mb_cols;
-                x->src.u_buffer += 8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
-                x->src.v_buffer += 8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
+#if CONFIG_MULTI_RES_ENCODING
+        if (cpi->mr_row_publish)
+            vp8_mr_publish_rows(cpi, 0);
+#endif
+    }
 
-                xd->mode_info_context += xd->mode_info_stride * cpi->encoding_thread_count;
-                x->partition_info += xd->mode_info_stride * cpi->encoding_thread_count;
-                x->gf_active_ptr   += cm->mb_cols * cpi->encoding_thread_count;
+    // no rows left to claim
+    sem_post(&cpi->h_event_end_encoding);
+}
 
-                if (mb_row == cm->mb_rows - 1)
-                {
-                    //SetEvent(cpi->h_event_main);
-                    sem_post(&cpi->h_event_end_encoding); /* signal frame encoding end */
-                }
-            }
+static
+THREAD_FUNCTION thread_encoding_proc(void *p_data)
+{
+    int ithread = ((ENCODETHREAD_DATA *)p_data)->ithread;
+    VP8_COMP *cpi = (VP8_COMP *)(((ENCODETHREAD_DATA *)p_data)->ptr1);
+
+    while (1)
+    {
+        if (cpi->b_multi_threaded == 0)
+            break;
+
+        //if(WaitForSingleObject(cpi->h_event_mbrencoding[ithread], INFINITE) == WAIT_OBJECT_0)
+        if (sem_wait(&cpi->h_event_start_encoding[ithread]) == 0)
+        {
+            if (cpi->b_multi_threaded == 0) // we're shutting down
+                break;
+
+            encoding_thread_run(cpi, ithread);
         }
     }
 
@@ -465,6 +540,389 @@ void vp8cx_init_mbrthread_data(VP8_COMP *cpi,
     }
 }
 
+/* The process wide thread pool used by encoders with oxcf.pool_threads set.
+ * Instead of waking up threads of their own, such encoders queue a task for
+ * each encoding thread, and for the loop filter and packing threads, which
+ * any pool thread may run. The tasks only wait for MB rows being encoded,
+ * and whoever waits for an encoder's encoding tasks first takes back the ones
+ * no pool thread has started and runs them itself, so a small pool is slow
+ * but doesn't deadlock.
+ */
+#define MAX_POOL_THREADS 64
+
+static struct
+{
+    int lock;               // guards the queue
+    int users_lock;         // guards starting and stopping the threads
+    int users;
+    int thread_count;
+    int stopping;
+    pthread_t threads[MAX_POOL_THREADS];
+    sem_t task_ready;       // one count per queued task
+    VP8_POOL_TASK *head;
+    VP8_POOL_TASK *tail;
+} pool;
+
+static void pool_lock(int *lock)
+{
+    while (!sync_bool_compare_and_swap(lock, 0, 1))
+    {
+        x86_pause_hint();
+        thread_sleep(0);
+    }
+}
+
+static void pool_unlock(int *lock)
+{
+    sync_fetch_and_add(lock, -1);
+}
+
+static THREAD_FUNCTION pool_thread(void *p_data)
+{
+    (void) p_data;
+
+    while (1)
+    {
+        VP8_POOL_TASK *task;
+
+        if (sem_wait(&pool.task_ready) != 0)
+            continue;
+
+        pool_lock(&pool.lock);
+        task = pool.head;
+
+        if (task)
+        {
+            pool.head = task->next;
+
+            if (!pool.head)
+                pool.tail = NULL;
+        }
+
+        pool_unlock(&pool.lock);
+
+        // the task was taken back by its encoder, or the pool is stopping
+        if (!task)
+        {
+            if (pool.stopping)
+                break;
+
+            continue;
+        }
+
+        task->run(task->cpi, task->ithread);
+    }
+
+    return 0;
+}
+
+// Starts the pool, or grows it to thread_count threads, for a new user.
+static void pool_acquire(int thread_count)
+{
+    pool_lock(&pool.users_lock);
+
+    if (pool.users++ == 0)
+        sem_init(&pool.task_ready, 0, 0);
+
+    if (thread_count > MAX_POOL_THREADS)
+        thread_count = MAX_POOL_THREADS;
+
+    while (pool.thread_count < thread_count)
+    {
+        if (pthread_create(&pool.threads[pool.thread_count], 0, pool_thread, NULL))
+            break;
+
+        pool.thread_count++;
+    }
+
+    pool_unlock(&pool.users_lock);
+}
+
+// Stops the pool once its last user is gone. Users have no tasks left.
+static void pool_release(void)
+{
+    pool_lock(&pool.users_lock);
+
+    if (--pool.users == 0)
+    {
+        int i;
+
+        pool.stopping = 1;
+
+        for (i = 0; i < pool.thread_count; i++)
+            sem_post(&pool.task_ready);
+
+        for (i = 0; i < pool.thread_count; i++)
+            pthread_join(pool.threads[i], 0);
+
+        sem_destroy(&pool.task_ready);
+        pool.thread_count = 0;
+        pool.stopping = 0;
+    }
+
+    pool_unlock(&pool.users_lock);
+}
+
+static void pool_submit(VP8_POOL_TASK *task)
+{
+    pool_lock(&pool.lock);
+
+    task->next = NULL;
+
+    if (pool.tail)
+        pool.tail->next = task;
+    else
+        pool.head = task;
+
+    pool.tail = task;
+
+    pool_unlock(&pool.lock);
+
+    sem_post(&pool.task_ready);
+}
+
+// Takes task off the queue if no pool thread has picked it up yet.
+static int pool_reclaim(VP8_POOL_TASK *task)
+{
+    VP8_POOL_TASK **pp;
+    VP8_POOL_TASK *prev = NULL;
+    int found = 0;
+
+    pool_lock(&pool.lock);
+
+    for (pp = &pool.head; *pp; prev = *pp, pp = &(*pp)->next)
+    {
+        if (*pp == task)
+        {
+            *pp = task->next;
+
+            if (pool.tail == task)
+                pool.tail = prev;
+
+            found = 1;
+            break;
+        }
+    }
+
+    pool_unlock(&pool.lock);
+
+    return found;
+}
+
+// Runs task on the calling thread if no pool thread has picked it up yet.
+static void pool_run_queued(VP8_POOL_TASK *task)
+{
+    if (pool_reclaim(task))
+        task->run(task->cpi, task->ithread);
+}
+
+// The pool tasks of an encoder: one per encoding thread, then the loop filter
+// and the packing tasks.
+#define POOL_TASK_LPF(cpi)  (&(cpi)->pool_tasks[(cpi)->encoding_thread_count])
+#define POOL_TASK_PACK(cpi) (&(cpi)->pool_tasks[(cpi)->encoding_thread_count + 1])
+
+void vp8cx_start_encoding_threads(VP8_COMP *cpi)
+{
+    int i;
+
+    for (i = 0; i < cpi->encoding_thread_count; i++)
+    {
+        if (cpi->pool_tasks)
+            pool_submit(&cpi->pool_tasks[i]);
+        else
+            sem_post(&cpi->h_event_start_encoding[i]);
+    }
+}
+
+// Runs the encoding tasks still waiting in the pool queue on the calling
+// thread. Called before waiting for the encoding threads, so a pool thread
+// that waits for them can't end up waiting for itself.
+void vp8cx_run_queued_encoding_tasks(VP8_COMP *cpi)
+{
+    int i;
+
+    if (!cpi->pool_tasks)
+        return;
+
+    for (i = 0; i < cpi->encoding_thread_count; i++)
+        pool_run_queued(&cpi->pool_tasks[i]);
+}
+
+void vp8cx_start_lpf_thread(VP8_COMP *cpi)
+{
+    if (cpi->pool_tasks)
+        pool_submit(POOL_TASK_LPF(cpi));
+    else
+        sem_post(&cpi->h_event_start_lpf);
+}
+
+// Only token_row_sync packs on its own thread, so the thread and its events
+// are set up the first time a frame needs them.
+static void create_pack_thread(VP8_COMP *cpi)
+{
+    sem_init(&cpi->h_event_end_pack, 0, 0);
+    cpi->b_pack_thread = 1;
+
+    if (cpi->pool_tasks)
+        return;
+
+    sem_init(&cpi->h_event_start_pack, 0, 0);
+    cpi->pack_thread_data.ptr1 = (void *)cpi;
+    pthread_create(&cpi->h_pack_thread, 0, pack_thread, &cpi->pack_thread_data);
+}
+
+void vp8cx_start_pack_thread(VP8_COMP *cpi)
+{
+    if (!cpi->b_pack_thread)
+        create_pack_thread(cpi);
+
+    if (cpi->pool_tasks)
+        pool_submit(POOL_TASK_PACK(cpi));
+    else
+        sem_post(&cpi->h_event_start_pack);
+}
+
+// Waits for the next h_event_end_lpf post of the loop filter thread. Like
+// the encoding tasks, a loop filter task still in the pool queue is run here.
+void vp8cx_wait_lpf_thread(VP8_COMP *cpi)
+{
+    if (cpi->pool_tasks)
+        pool_run_queued(POOL_TASK_LPF(cpi));
+
+    sem_wait(&cpi->h_event_end_lpf);
+}
+
+void vp8cx_wait_pack_thread(VP8_COMP *cpi)
+{
+    if (cpi->pool_tasks)
+        pool_run_queued(POOL_TASK_PACK(cpi));
+
+    sem_wait(&cpi->h_event_end_pack);
+}
+
+// Runs job on the main thread and on each encoding thread, and returns once
+// all of them are done with it.
+void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data)
+{
+    int i;
+
+    cpi->mt_job = job;
+    cpi->mt_job_data = data;
+
+    vp8cx_start_encoding_threads(cpi);
+
+    job(cpi, &cpi->mb, 0, data);
+
+    vp8cx_run_queued_encoding_tasks(cpi);
+
+    for (i = 0; i < cpi->encoding_thread_count; i++)
+        sem_wait(&cpi->h_event_end_job);
+
+    cpi->mt_job = NULL;
+}
+
+static void async_run(VP8_COMP *cpi, int ithread)
+{
+    (void) ithread;
+
+    cpi->async_res = cpi->async_fn(cpi->async_data);
+    sem_post(&cpi->h_event_end_async);
+}
+
+static THREAD_FUNCTION thread_async(void *p_data)
+{
+    VP8_COMP *cpi = (VP8_COMP *)p_data;
+
+    while (1)
+    {
+        if (sem_wait(&cpi->h_event_start_async) == 0)
+        {
+            if (!cpi->b_async_thread)
+                break;
+
+            async_run(cpi, 0);
+        }
+    }
+
+    return 0;
+}
+
+// Runs fn(data) on a thread of its own, or on the shared pool if the encoder
+// uses it, and returns right away. vp8cx_finish_async() waits for it.
+void vp8cx_start_async(VP8_COMP *cpi, vp8cx_async_fn fn, void *data)
+{
+    cpi->async_fn = fn;
+    cpi->async_data = data;
+
+    if (!cpi->b_async_thread && !cpi->async_pool)
+    {
+        sem_init(&cpi->h_event_end_async, 0, 0);
+
+        if (cpi->oxcf.pool_threads > 0)
+        {
+            cpi->async_task.run = async_run;
+            cpi->async_task.cpi = cpi;
+            pool_acquire(cpi->oxcf.pool_threads);
+            cpi->async_pool = 1;
+        }
+        else
+        {
+            sem_init(&cpi->h_event_start_async, 0, 0);
+            cpi->b_async_thread = 1;
+
+            if (pthread_create(&cpi->h_async_thread, 0, thread_async, cpi))
+            {
+                // no thread, so run it here instead
+                cpi->b_async_thread = 0;
+                sem_destroy(&cpi->h_event_start_async);
+                async_run(cpi, 0);
+                return;
+            }
+        }
+    }
+
+    if (cpi->async_pool)
+        pool_submit(&cpi->async_task);
+    else if (cpi->b_async_thread)
+        sem_post(&cpi->h_event_start_async);
+    else
+        async_run(cpi, 0);
+}
+
+// Waits for the work started by vp8cx_start_async() and returns its result,
+// or 0 if there's none.
+int vp8cx_finish_async(VP8_COMP *cpi)
+{
+    if (!cpi->async_fn)
+        return 0;
+
+    if (cpi->async_pool && pool_reclaim(&cpi->async_task))
+        async_run(cpi, 0);
+
+    sem_wait(&cpi->h_event_end_async);
+    cpi->async_fn = NULL;
+
+    return cpi->async_res;
+}
+
+void vp8cx_remove_async_thread(VP8_COMP *cpi)
+{
+    if (cpi->b_async_thread)
+    {
+        cpi->b_async_thread = 0;
+        sem_post(&cpi->h_event_start_async);
+        pthread_join(cpi->h_async_thread, 0);
+        sem_destroy(&cpi->h_event_start_async);
+        sem_destroy(&cpi->h_event_end_async);
+    }
+    else if (cpi->async_pool)
+    {
+        pool_release();
+        cpi->async_pool = 0;
+        sem_destroy(&cpi->h_event_end_async);
+    }
+}
+
 void vp8cx_create_encoder_threads(VP8_COMP *cpi)
 {
     const VP8_COMMON * cm = &cpi->common;
@@ -481,6 +939,10 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
         if (cpi->oxcf.multi_threaded > cm->processor_core_count)
             th_count = cm->processor_core_count - 1;
 
+        /* nor more than the shared pool has */
+        if (cpi->oxcf.pool_threads > 0 && th_count > cpi->oxcf.pool_threads)
+            th_count = cpi->oxcf.pool_threads;
+
         /* we have th_count + 1 (main) threads processing one row each */
         /* no point to have more threads than the sync range allows */
         if(th_count > ((cm->mb_cols / cpi->mt_sync_range) - 1))
@@ -501,6 +963,8 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
                         vpx_malloc(sizeof(*cpi->mt_current_mb_col) * cm->mb_rows));
 
         sem_init(&cpi->h_event_end_encoding, 0, 0);
+        sem_init(&cpi->h_event_end_job, 0, 0);
+        cpi->mt_job = NULL;
 
         cpi->b_multi_threaded = 1;
         cpi->encoding_thread_count = th_count;
@@ -510,6 +974,30 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
                (cpi->encoding_thread_count +1));
         */
 
+        sem_init(&cpi->h_event_end_lpf, 0, 0);
+        cpi->b_pack_thread = 0;
+
+        if (cpi->oxcf.pool_threads > 0)
+        {
+            CHECK_MEM_ERROR(cpi->pool_tasks,
+                            vpx_calloc(th_count + 2, sizeof(VP8_POOL_TASK)));
+
+            for (ithread = 0; ithread < th_count; ithread++)
+            {
+                cpi->pool_tasks[ithread].run = encoding_thread_run;
+                cpi->pool_tasks[ithread].cpi = cpi;
+                cpi->pool_tasks[ithread].ithread = ithread;
+            }
+
+            POOL_TASK_LPF(cpi)->run = loopfilter_thread_run;
+            POOL_TASK_LPF(cpi)->cpi = cpi;
+            POOL_TASK_PACK(cpi)->run = pack_thread_run;
+            POOL_TASK_PACK(cpi)->cpi = cpi;
+
+            pool_acquire(cpi->oxcf.pool_threads);
+            return;
+        }
+
         for (ithread = 0; ithread < th_count; ithread++)
         {
             ENCODETHREAD_DATA * ethd = &cpi->en_thread_data[ithread];
@@ -526,7 +1014,6 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
             LPFTHREAD_DATA * lpfthd = &cpi->lpf_thread_data;
 
             sem_init(&cpi->h_event_start_lpf, 0, 0);
-            sem_init(&cpi->h_event_end_lpf, 0, 0);
 
             lpfthd->ptr1 = (void *)cpi;
             pthread_create(&cpi->h_filter_thread, 0, loopfilter_thread, lpfthd);
@@ -541,6 +1028,14 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
     {
         //shutdown other threads
         cpi->b_multi_threaded = 0;
+
+        if (cpi->pool_tasks)
+        {
+            pool_release();
+            vpx_free(cpi->pool_tasks);
+            cpi->pool_tasks = NULL;
+        }
+        else
         {
             int i;
 
@@ -555,11 +1050,26 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
 
             sem_post(&cpi->h_event_start_lpf);
             pthread_join(cpi->h_filter_thread, 0);
+
+            if (cpi->b_pack_thread)
+            {
+                sem_post(&cpi->h_event_start_pack);
+                pthread_join(cpi->h_pack_thread, 0);
+                sem_destroy(&cpi->h_event_start_pack);
+            }
+
+            sem_destroy(&cpi->h_event_start_lpf);
+        }
+
+        if (cpi->b_pack_thread)
+        {
+            cpi->b_pack_thread = 0;
+            sem_destroy(&cpi->h_event_end_pack);
         }
 
         sem_destroy(&cpi->h_event_end_encoding);
+        sem_destroy(&cpi->h_event_end_job);
         sem_destroy(&cpi->h_event_end_lpf);
-        sem_destroy(&cpi->h_event_start_lpf);
 
         //free thread related resources
         vpx_free(cpi->h_event_start_encoding);
@@ -567,6 +1077,8 @@ void vp8cx_remove_encoder_threads(VP8_COMP *cpi)
         vpx_free(cpi->mb_row_ei);
         vpx_free(cpi->en_thread_data);
         vpx_free(cpi->mt_current_mb_col);
+
+        vp8cx_free_partition_bufs(cpi);
     }
 }
 #endif
@@ -377,6 +377,32 @@ static int frame_max_bits(VP8_COMP *cpi)
     return max_bits;
 }
 
+#if CONFIG_SPATIAL_RESAMPLING
+// Converts stats gathered on the downscaled source to full size units: the
+// error sums and mv counts grow with the number of MBs, mv components with
+// the scale factor and their variances with its square.
+static void scale_up_stats(VP8_COMP *cpi, FIRSTPASS_STATS *fps)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int full_mbs = ((cpi->oxcf.Width + 15) >> 4) * ((cpi->oxcf.Height + 15) >> 4);
+    double mb_scale = (double)full_mbs / cm->MBs;
+    double h_scale = (double)cpi->oxcf.Width / cm->Width;
+    double v_scale = (double)cpi->oxcf.Height / cm->Height;
+
+    fps->intra_error *= mb_scale;
+    fps->coded_error *= mb_scale;
+    fps->ssim_weighted_pred_err *= mb_scale;
+    fps->new_mv_count *= mb_scale;
+
+    fps->MVr *= v_scale;
+    fps->mvr_abs *= v_scale;
+    fps->MVc *= h_scale;
+    fps->mvc_abs *= h_scale;
+    fps->MVrv *= v_scale * v_scale;
+    fps->MVcv *= h_scale * h_scale;
+}
+#endif
+
 void vp8_init_first_pass(VP8_COMP *cpi)
 {
     zero_stats(&cpi->twopass.total_stats);
@@ -478,10 +504,10 @@ static void first_pass_motion_search(VP8_COMP *cpi, MACROBLOCK *x,
     }
 }
 
-void vp8_first_pass(VP8_COMP *cpi)
+static void first_pass_row(VP8_COMP *cpi, MACROBLOCK *x, int mb_row,
+                           FIRSTPASS_ROW_STATS *stats)
 {
-    int mb_row, mb_col;
-    MACROBLOCK *const x = & cpi->mb;
+    int mb_col;
     VP8_COMMON *const cm = & cpi->common;
     MACROBLOCKD *const xd = & x->e_mbd;
 
@@ -491,6 +517,294 @@ void vp8_first_pass(VP8_COMP *cpi)
     YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
     int recon_y_stride = lst_yv12->y_stride;
     int recon_uv_stride = lst_yv12->uv_stride;
+    int intrapenalty = 256;
+    int_mv best_ref_mv;
+    int_mv zero_ref_mv;
+
+#if CONFIG_MULTITHREAD
+    const int nsync = cpi->mt_sync_range;
+    const int rightmost_col = cm->mb_cols - 1;
+    volatile const int *last_row_current_mb_col;
+
+    if ((cpi->b_multi_threaded != 0) && (mb_row != 0))
+        last_row_current_mb_col = &cpi->mt_current_mb_col[mb_row - 1];
+    else
+        last_row_current_mb_col = &rightmost_col;
+#endif
+
+    vpx_memset(stats, 0, sizeof(*stats));
+
+    zero_ref_mv.as_int = 0;
+    best_ref_mv.as_int = 0;
+
+    // reset above block coeffs
+    xd->up_available = (mb_row != 0);
+    recon_yoffset = (mb_row * recon_y_stride * 16);
+    recon_uvoffset = (mb_row * recon_uv_stride * 8);
+
+    x->src.y_buffer = cpi->Source->y_buffer + mb_row * 16 * x->src.y_stride;
+    x->src.u_buffer = cpi->Source->u_buffer + mb_row * 8 * x->src.uv_stride;
+    x->src.v_buffer = cpi->Source->v_buffer + mb_row * 8 * x->src.uv_stride;
+
+    // Set up limit values for motion vectors to prevent them extending outside the UMV borders
+    x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
+    x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
+
+
+    // for each macroblock col in image
+    for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+    {
+        int this_error;
+        int gf_motion_error = INT_MAX;
+        int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
+
+        xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
+        xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
+        xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
+        xd->left_available = (mb_col != 0);
+
+        //Copy current mb to a buffer
+        vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
+
+#if CONFIG_MULTITHREAD
+        if ((cpi->b_multi_threaded != 0) && (mb_row != 0))
+        {
+            if ((mb_col & (nsync - 1)) == 0)
+            {
+                while (mb_col > (*last_row_current_mb_col - nsync)
+                        && (*last_row_current_mb_col) != (cm->mb_cols - 1))
+                {
+                    x86_pause_hint();
+                    thread_sleep(0);
+                }
+            }
+        }
+#endif
+
+        // do intra 16x16 prediction
+        this_error = vp8_encode_intra(cpi, x, use_dc_pred);
+
+        // "intrapenalty" below deals with situations where the intra and inter error scores are very low (eg a plain black frame)
+        // We do not have special cases in first pass for 0,0 and nearest etc so all inter modes carry an overhead cost estimate fot the mv.
+        // When the error score is very low this causes us to pick all or lots of INTRA modes and throw lots of key frames.
+        // This penalty adds a cost matching that of a 0,0 mv to the intra case.
+        this_error += intrapenalty;
+
+        // Cumulative intra error total
+        stats->intra_error += (int64_t)this_error;
+
+        // Set up limit values for motion vectors to prevent them extending outside the UMV borders
+        x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
+        x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
+
+        // Other than for the first frame do a motion search
+        if (cm->current_video_frame > 0)
+        {
+            BLOCKD *d = &x->e_mbd.block[0];
+            MV tmp_mv = {0, 0};
+            int tmp_err;
+            int motion_error = INT_MAX;
+
+            // Simple 0,0 motion with no mv overhead
+            zz_motion_search( cpi, x, lst_yv12, &motion_error, recon_yoffset );
+            d->bmi.mv.as_mv.row = 0;
+            d->bmi.mv.as_mv.col = 0;
+
+            // Test last reference frame using the previous best mv as the
+            // starting point (best reference) for the search
+            first_pass_motion_search(cpi, x, &best_ref_mv,
+                                    &d->bmi.mv.as_mv, lst_yv12,
+                                    &motion_error, recon_yoffset);
+
+            // If the current best reference mv is not centred on 0,0 then do a 0,0 based search as well
+            if (best_ref_mv.as_int)
+            {
+               tmp_err = INT_MAX;
+               first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv,
+                                 lst_yv12, &tmp_err, recon_yoffset);
+
+               if ( tmp_err < motion_error )
+               {
+                    motion_error = tmp_err;
+                    d->bmi.mv.as_mv.row = tmp_mv.row;
+                    d->bmi.mv.as_mv.col = tmp_mv.col;
+               }
+            }
+
+            // Experimental search in a second reference frame ((0,0) based only)
+            if (cm->current_video_frame > 1)
+            {
+                first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12, &gf_motion_error, recon_yoffset);
+
+                if ((gf_motion_error < motion_error) && (gf_motion_error < this_error))
+                {
+                    stats->second_ref_count++;
+                    //motion_error = gf_motion_error;
+                    //d->bmi.mv.as_mv.row = tmp_mv.row;
+                    //d->bmi.mv.as_mv.col = tmp_mv.col;
+                }
+                /*else
+                {
+                    xd->pre.y_buffer = cm->last_frame.y_buffer + recon_yoffset;
+                    xd->pre.u_buffer = cm->last_frame.u_buffer + recon_uvoffset;
+                    xd->pre.v_buffer = cm->last_frame.v_buffer + recon_uvoffset;
+                }*/
+
+
+                // Reset to last frame as reference buffer
+                xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
+                xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
+                xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
+            }
+
+            /* Intra assumed best */
+            best_ref_mv.as_int = 0;
+
+            if (motion_error <= this_error)
+            {
+                // Keep a count of cases where the inter and intra were
+                // very close and very low. This helps with scene cut
+                // detection for example in cropped clips with black bars
+                // at the sides or top and bottom.
+                if( (((this_error-intrapenalty) * 9) <=
+                     (motion_error*10)) &&
+                    (this_error < (2*intrapenalty)) )
+                {
+                    stats->neutral_count++;
+                }
+
+                d->bmi.mv.as_mv.row <<= 3;
+                d->bmi.mv.as_mv.col <<= 3;
+                this_error = motion_error;
+                vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
+                vp8_encode_inter16x16y(x);
+                stats->sum_mvr += d->bmi.mv.as_mv.row;
+                stats->sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
+                stats->sum_mvc += d->bmi.mv.as_mv.col;
+                stats->sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
+                stats->sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
+                stats->sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
+                stats->intercount++;
+
+                best_ref_mv.as_int = d->bmi.mv.as_int;
+
+                // Was the vector non-zero
+                if (d->bmi.mv.as_int)
+                {
+                    // Was it different from the last non zero vector.
+                    // Whether the first one in the row is new depends
+                    // on the rows above, see vp8_first_pass().
+                    if (!stats->mvcount)
+                        stats->first_mv_as_int = d->bmi.mv.as_int;
+                    else if ( d->bmi.mv.as_int != stats->last_mv_as_int )
+                        stats->new_mv_count++;
+                    stats->last_mv_as_int = d->bmi.mv.as_int;
+
+                    stats->mvcount++;
+
+                    // Does the Row vector point inwards or outwards
+                    if (mb_row < cm->mb_rows / 2)
+                    {
+                        if (d->bmi.mv.as_mv.row > 0)
+                            stats->sum_in_vectors--;
+                        else if (d->bmi.mv.as_mv.row < 0)
+                            stats->sum_in_vectors++;
+                    }
+                    else if (mb_row > cm->mb_rows / 2)
+                    {
+                        if (d->bmi.mv.as_mv.row > 0)
+                            stats->sum_in_vectors++;
+                        else if (d->bmi.mv.as_mv.row < 0)
+                            stats->sum_in_vectors--;
+                    }
+
+                    // Does the Row vector point inwards or outwards
+                    if (mb_col < cm->mb_cols / 2)
+                    {
+                        if (d->bmi.mv.as_mv.col > 0)
+                            stats->sum_in_vectors--;
+                        else if (d->bmi.mv.as_mv.col < 0)
+                            stats->sum_in_vectors++;
+                    }
+                    else if (mb_col > cm->mb_cols / 2)
+                    {
+                        if (d->bmi.mv.as_mv.col > 0)
+                            stats->sum_in_vectors++;
+                        else if (d->bmi.mv.as_mv.col < 0)
+                            stats->sum_in_vectors--;
+                    }
+                }
+            }
+        }
+
+        stats->coded_error += (int64_t)this_error;
+
+        // adjust to the next column of macroblocks
+        x->src.y_buffer += 16;
+        x->src.u_buffer += 8;
+        x->src.v_buffer += 8;
+
+        recon_yoffset += 16;
+        recon_uvoffset += 8;
+
+#if CONFIG_MULTITHREAD
+        if (cpi->b_multi_threaded != 0)
+            cpi->mt_current_mb_col[mb_row] = mb_col;
+#endif
+    }
+
+    //extend the recon for intra prediction
+    vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
+    vp8_clear_system_state();  //__asm emms;
+}
+
+typedef struct
+{
+    FIRSTPASS_ROW_STATS *row_stats;
+    int next_row;
+} FIRSTPASS_JOB;
+
+static void first_pass_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread,
+                            void *data)
+{
+    FIRSTPASS_JOB *job = (FIRSTPASS_JOB *)data;
+    int mb_row;
+
+    (void) ithread;
+
+#if CONFIG_MULTITHREAD
+    // The threads take the next row as they get to it, like
+    // vp8cx_claim_mb_row() does.
+    if (cpi->b_multi_threaded)
+    {
+        while ((mb_row = sync_fetch_and_add(&job->next_row, 1)) < cpi->common.mb_rows)
+            first_pass_row(cpi, x, mb_row, &job->row_stats[mb_row]);
+
+        return;
+    }
+#endif
+
+    for (mb_row = 0; mb_row < cpi->common.mb_rows; mb_row++)
+        first_pass_row(cpi, x, mb_row, &job->row_stats[mb_row]);
+}
+
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+extern void vp8cx_init_mbrthread_data(VP8_COMP *cpi, MACROBLOCK *x,
+                                      MB_ROW_COMP *mbr_ei, int mb_row,
+                                      int count);
+#endif
+
+void vp8_first_pass(VP8_COMP *cpi)
+{
+    int mb_row;
+    MACROBLOCK *const x = & cpi->mb;
+    VP8_COMMON *const cm = & cpi->common;
+    MACROBLOCKD *const xd = & x->e_mbd;
+
+    YV12_BUFFER_CONFIG *lst_yv12 = &cm->yv12_fb[cm->lst_fb_idx];
+    YV12_BUFFER_CONFIG *new_yv12 = &cm->yv12_fb[cm->new_fb_idx];
+    YV12_BUFFER_CONFIG *gld_yv12 = &cm->yv12_fb[cm->gld_fb_idx];
     int64_t intra_error = 0;
     int64_t coded_error = 0;
 
@@ -500,15 +814,12 @@ void vp8_first_pass(VP8_COMP *cpi)
     int mvcount = 0;
     int intercount = 0;
     int second_ref_count = 0;
-    int intrapenalty = 256;
     int neutral_count = 0;
     int new_mv_count = 0;
     int sum_in_vectors = 0;
     uint32_t lastmv_as_int = 0;
 
-    int_mv zero_ref_mv;
-
-    zero_ref_mv.as_int = 0;
+    FIRSTPASS_JOB job;
 
     vp8_clear_system_state();  //__asm emms;
 
@@ -540,209 +851,55 @@ void vp8_first_pass(VP8_COMP *cpi)
         vp8_build_component_cost_table(cpi->mb.mvcost, (const MV_CONTEXT *) cm->fc.mvc, flag);
     }
 
-    // for each macroblock row in image
-    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
-    {
-        int_mv best_ref_mv;
-
-        best_ref_mv.as_int = 0;
-
-        // reset above block coeffs
-        xd->up_available = (mb_row != 0);
-        recon_yoffset = (mb_row * recon_y_stride * 16);
-        recon_uvoffset = (mb_row * recon_uv_stride * 8);
-
-        // Set up limit values for motion vectors to prevent them extending outside the UMV borders
-        x->mv_row_min = -((mb_row * 16) + (VP8BORDERINPIXELS - 16));
-        x->mv_row_max = ((cm->mb_rows - 1 - mb_row) * 16) + (VP8BORDERINPIXELS - 16);
-
-
-        // for each macroblock col in image
-        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
-        {
-            int this_error;
-            int gf_motion_error = INT_MAX;
-            int use_dc_pred = (mb_col || mb_row) && (!mb_col || !mb_row);
+    job.row_stats = cpi->twopass.row_stats;
+    job.next_row = 0;
 
-            xd->dst.y_buffer = new_yv12->y_buffer + recon_yoffset;
-            xd->dst.u_buffer = new_yv12->u_buffer + recon_uvoffset;
-            xd->dst.v_buffer = new_yv12->v_buffer + recon_uvoffset;
-            xd->left_available = (mb_col != 0);
-
-            //Copy current mb to a buffer
-            vp8_copy_mem16x16(x->src.y_buffer, x->src.y_stride, x->thismb, 16);
-
-            // do intra 16x16 prediction
-            this_error = vp8_encode_intra(cpi, x, use_dc_pred);
-
-            // "intrapenalty" below deals with situations where the intra and inter error scores are very low (eg a plain black frame)
-            // We do not have special cases in first pass for 0,0 and nearest etc so all inter modes carry an overhead cost estimate fot the mv.
-            // When the error score is very low this causes us to pick all or lots of INTRA modes and throw lots of key frames.
-            // This penalty adds a cost matching that of a 0,0 mv to the intra case.
-            this_error += intrapenalty;
-
-            // Cumulative intra error total
-            intra_error += (int64_t)this_error;
-
-            // Set up limit values for motion vectors to prevent them extending outside the UMV borders
-            x->mv_col_min = -((mb_col * 16) + (VP8BORDERINPIXELS - 16));
-            x->mv_col_max = ((cm->mb_cols - 1 - mb_col) * 16) + (VP8BORDERINPIXELS - 16);
-
-            // Other than for the first frame do a motion search
-            if (cm->current_video_frame > 0)
-            {
-                BLOCKD *d = &x->e_mbd.block[0];
-                MV tmp_mv = {0, 0};
-                int tmp_err;
-                int motion_error = INT_MAX;
-
-                // Simple 0,0 motion with no mv overhead
-                zz_motion_search( cpi, x, lst_yv12, &motion_error, recon_yoffset );
-                d->bmi.mv.as_mv.row = 0;
-                d->bmi.mv.as_mv.col = 0;
-
-                // Test last reference frame using the previous best mv as the
-                // starting point (best reference) for the search
-                first_pass_motion_search(cpi, x, &best_ref_mv,
-                                        &d->bmi.mv.as_mv, lst_yv12,
-                                        &motion_error, recon_yoffset);
-
-                // If the current best reference mv is not centred on 0,0 then do a 0,0 based search as well
-                if (best_ref_mv.as_int)
-                {
-                   tmp_err = INT_MAX;
-                   first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv,
-                                     lst_yv12, &tmp_err, recon_yoffset);
-
-                   if ( tmp_err < motion_error )
-                   {
-                        motion_error = tmp_err;
-                        d->bmi.mv.as_mv.row = tmp_mv.row;
-                        d->bmi.mv.as_mv.col = tmp_mv.col;
-                   }
-                }
-
-                // Experimental search in a second reference frame ((0,0) based only)
-                if (cm->current_video_frame > 1)
-                {
-                    first_pass_motion_search(cpi, x, &zero_ref_mv, &tmp_mv, gld_yv12, &gf_motion_error, recon_yoffset);
-
-                    if ((gf_motion_error < motion_error) && (gf_motion_error < this_error))
-                    {
-                        second_ref_count++;
-                        //motion_error = gf_motion_error;
-                        //d->bmi.mv.as_mv.row = tmp_mv.row;
-                        //d->bmi.mv.as_mv.col = tmp_mv.col;
-                    }
-                    /*else
-                    {
-                        xd->pre.y_buffer = cm->last_frame.y_buffer + recon_yoffset;
-                        xd->pre.u_buffer = cm->last_frame.u_buffer + recon_uvoffset;
-                        xd->pre.v_buffer = cm->last_frame.v_buffer + recon_uvoffset;
-                    }*/
-
-
-                    // Reset to last frame as reference buffer
-                    xd->pre.y_buffer = lst_yv12->y_buffer + recon_yoffset;
-                    xd->pre.u_buffer = lst_yv12->u_buffer + recon_uvoffset;
-                    xd->pre.v_buffer = lst_yv12->v_buffer + recon_uvoffset;
-                }
-
-                /* Intra assumed best */
-                best_ref_mv.as_int = 0;
-
-                if (motion_error <= this_error)
-                {
-                    // Keep a count of cases where the inter and intra were
-                    // very close and very low. This helps with scene cut
-                    // detection for example in cropped clips with black bars
-                    // at the sides or top and bottom.
-                    if( (((this_error-intrapenalty) * 9) <=
-                         (motion_error*10)) &&
-                        (this_error < (2*intrapenalty)) )
-                    {
-                        neutral_count++;
-                    }
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+    {
+        int i;
 
-                    d->bmi.mv.as_mv.row <<= 3;
-                    d->bmi.mv.as_mv.col <<= 3;
-                    this_error = motion_error;
-                    vp8_set_mbmode_and_mvs(x, NEWMV, &d->bmi.mv);
-                    vp8_encode_inter16x16y(x);
-                    sum_mvr += d->bmi.mv.as_mv.row;
-                    sum_mvr_abs += abs(d->bmi.mv.as_mv.row);
-                    sum_mvc += d->bmi.mv.as_mv.col;
-                    sum_mvc_abs += abs(d->bmi.mv.as_mv.col);
-                    sum_mvrs += d->bmi.mv.as_mv.row * d->bmi.mv.as_mv.row;
-                    sum_mvcs += d->bmi.mv.as_mv.col * d->bmi.mv.as_mv.col;
-                    intercount++;
-
-                    best_ref_mv.as_int = d->bmi.mv.as_int;
-
-                    // Was the vector non-zero
-                    if (d->bmi.mv.as_int)
-                    {
-                        mvcount++;
-
-                        // Was it different from the last non zero vector
-                        if ( d->bmi.mv.as_int != lastmv_as_int )
-                            new_mv_count++;
-                        lastmv_as_int = d->bmi.mv.as_int;
-
-                        // Does the Row vector point inwards or outwards
-                        if (mb_row < cm->mb_rows / 2)
-                        {
-                            if (d->bmi.mv.as_mv.row > 0)
-                                sum_in_vectors--;
-                            else if (d->bmi.mv.as_mv.row < 0)
-                                sum_in_vectors++;
-                        }
-                        else if (mb_row > cm->mb_rows / 2)
-                        {
-                            if (d->bmi.mv.as_mv.row > 0)
-                                sum_in_vectors++;
-                            else if (d->bmi.mv.as_mv.row < 0)
-                                sum_in_vectors--;
-                        }
-
-                        // Does the Row vector point inwards or outwards
-                        if (mb_col < cm->mb_cols / 2)
-                        {
-                            if (d->bmi.mv.as_mv.col > 0)
-                                sum_in_vectors--;
-                            else if (d->bmi.mv.as_mv.col < 0)
-                                sum_in_vectors++;
-                        }
-                        else if (mb_col > cm->mb_cols / 2)
-                        {
-                            if (d->bmi.mv.as_mv.col > 0)
-                                sum_in_vectors++;
-                            else if (d->bmi.mv.as_mv.col < 0)
-                                sum_in_vectors--;
-                        }
-                    }
-                }
-            }
+        // The encoding threads take rows as they get to them, each waiting
+        // for the row above like the MB row encoding does.
+        vp8cx_init_mbrthread_data(cpi, x, cpi->mb_row_ei, 1,
+                                  cpi->encoding_thread_count);
 
-            coded_error += (int64_t)this_error;
+        for (i = 0; i < cm->mb_rows; i++)
+            cpi->mt_current_mb_col[i] = -1;
 
-            // adjust to the next column of macroblocks
-            x->src.y_buffer += 16;
-            x->src.u_buffer += 8;
-            x->src.v_buffer += 8;
+        vp8cx_mt_run_job(cpi, first_pass_rows, &job);
+    }
+    else
+#endif
+        first_pass_rows(cpi, x, 0, &job);
 
-            recon_yoffset += 16;
-            recon_uvoffset += 8;
+    // Add up the row sums in raster order
+    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    {
+        FIRSTPASS_ROW_STATS *stats = &cpi->twopass.row_stats[mb_row];
+
+        intra_error += stats->intra_error;
+        coded_error += stats->coded_error;
+        sum_mvr += stats->sum_mvr;
+        sum_mvc += stats->sum_mvc;
+        sum_mvr_abs += stats->sum_mvr_abs;
+        sum_mvc_abs += stats->sum_mvc_abs;
+        sum_mvrs += stats->sum_mvrs;
+        sum_mvcs += stats->sum_mvcs;
+        intercount += stats->intercount;
+        second_ref_count += stats->second_ref_count;
+        neutral_count += stats->neutral_count;
+        sum_in_vectors += stats->sum_in_vectors;
+
+        if (stats->mvcount)
+        {
+            if (stats->first_mv_as_int != lastmv_as_int)
+                new_mv_count++;
+            lastmv_as_int = stats->last_mv_as_int;
         }
 
-        // adjust to the next row of mbs
-        x->src.y_buffer += 16 * x->src.y_stride - 16 * cm->mb_cols;
-        x->src.u_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-        x->src.v_buffer += 8 * x->src.uv_stride - 8 * cm->mb_cols;
-
-        //extend the recon for intra prediction
-        vp8_extend_mb_row(new_yv12, xd->dst.y_buffer + 16, xd->dst.u_buffer + 8, xd->dst.v_buffer + 8);
-        vp8_clear_system_state();  //__asm emms;
+        mvcount += stats->mvcount;
+        new_mv_count += stats->new_mv_count;
     }
 
     vp8_clear_system_state();  //__asm emms;
@@ -797,6 +954,11 @@ void vp8_first_pass(VP8_COMP *cpi)
         fps.duration = cpi->source->ts_end
                        - cpi->source->ts_start;
 
+#if CONFIG_SPATIAL_RESAMPLING
+        if (cpi->oxcf.first_pass_downscale)
+            scale_up_stats(cpi, &fps);
+#endif
+
         // don't want to do output stats with a stack variable!
         memcpy(&cpi->twopass.this_frame_stats,
                &fps,
@@ -0,0 +1,224 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "onyx_int.h"
+#include "halfpel.h"
+#include "vpx_mem/vpx_mem.h"
+
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+#endif
+
+typedef struct
+{
+    YV12_BUFFER_CONFIG *src;
+    HALFPEL_PLANES *planes;
+    int row_step;
+} HALFPEL_JOB;
+
+void vp8_halfpel_free(VP8_COMP *cpi)
+{
+    int i, j;
+
+    for (i = 0; i < HALFPEL_MAX_SETS; i++)
+    {
+        for (j = 0; j < 3; j++)
+        {
+            vpx_free(cpi->halfpel[i].alloc[j]);
+            cpi->halfpel[i].alloc[j] = 0;
+            cpi->halfpel[i].buf[j] = 0;
+        }
+
+        cpi->halfpel[i].fb_idx = -1;
+    }
+
+    cpi->halfpel_sets = 0;
+    cpi->halfpel_size = 0;
+}
+
+void vp8_halfpel_alloc(VP8_COMP *cpi)
+{
+    YV12_BUFFER_CONFIG *fb = &cpi->common.yv12_fb[0];
+    int size = fb->y_stride * (fb->y_height + 2 * fb->border);
+    int sets = 0;
+    int i, j;
+
+    if (fb->y_width && cpi->oxcf.halfpel_planes_kb > 0)
+        sets = cpi->oxcf.halfpel_planes_kb / ((3 * size + 1023) >> 10);
+
+    if (sets > HALFPEL_MAX_SETS)
+        sets = HALFPEL_MAX_SETS;
+
+    if (sets != cpi->halfpel_sets || size != cpi->halfpel_size)
+    {
+        vp8_halfpel_free(cpi);
+
+        for (i = 0; i < sets; i++)
+            for (j = 0; j < 3; j++)
+            {
+                CHECK_MEM_ERROR(cpi->halfpel[i].alloc[j], vpx_malloc(size));
+                cpi->halfpel[i].buf[j] = cpi->halfpel[i].alloc[j] +
+                                         fb->border * fb->y_stride +
+                                         fb->border;
+            }
+
+        cpi->halfpel_sets = sets;
+        cpi->halfpel_size = size;
+
+        for (i = 0; i < MAX_REF_FRAMES; i++)
+            cpi->halfpel_ref[i] = 0;
+    }
+}
+
+void vp8_halfpel_invalidate(VP8_COMP *cpi, int fb_idx)
+{
+    int i;
+
+    for (i = 0; i < cpi->halfpel_sets; i++)
+        if (cpi->halfpel[i].fb_idx == fb_idx)
+            cpi->halfpel[i].fb_idx = -1;
+}
+
+static void build_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread, void *data)
+{
+    HALFPEL_JOB *job = (HALFPEL_JOB *)data;
+    YV12_BUFFER_CONFIG *src = job->src;
+    int stride = src->y_stride;
+    int rows = src->y_height + 2 * src->border;
+    int offset = src->border * stride + src->border;
+    int r, c;
+
+    (void) cpi;
+    (void) x;
+
+    // All rows of the bordered plane, borders included
+    for (r = ithread; r < rows; r += job->row_step)
+    {
+        const unsigned char *s0 = src->y_buffer - offset + r * stride;
+        const unsigned char *s1 = (r < rows - 1) ? s0 + stride : s0;
+        unsigned char *h = job->planes->buf[0] - offset + r * stride;
+        unsigned char *v = job->planes->buf[1] - offset + r * stride;
+        unsigned char *hv = job->planes->buf[2] - offset + r * stride;
+
+        for (c = 0; c < stride - 1; c++)
+        {
+            int h0 = (s0[c] + s0[c+1] + 1) >> 1;
+            int h1 = (s1[c] + s1[c+1] + 1) >> 1;
+
+            h[c] = h0;
+            v[c] = (s0[c] + s1[c] + 1) >> 1;
+            hv[c] = (h0 + h1 + 1) >> 1;
+        }
+
+        // Never read by the search, which stays well inside the border
+        h[c] = s0[c];
+        v[c] = (s0[c] + s1[c] + 1) >> 1;
+        hv[c] = v[c];
+    }
+}
+
+static void build_planes(VP8_COMP *cpi, HALFPEL_PLANES *planes, int fb_idx)
+{
+    HALFPEL_JOB job;
+
+    job.src = &cpi->common.yv12_fb[fb_idx];
+    job.planes = planes;
+    job.row_step = 1;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+    {
+        job.row_step = cpi->encoding_thread_count + 1;
+        vp8cx_mt_run_job(cpi, build_rows, &job);
+    }
+    else
+#endif
+        build_rows(cpi, &cpi->mb, 0, &job);
+
+    planes->fb_idx = fb_idx;
+}
+
+void vp8_halfpel_prepare(VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+    static const int flags[MAX_REF_FRAMES] =
+    {
+        0, VP8_LAST_FLAG, VP8_GOLD_FLAG, VP8_ALT_FLAG
+    };
+    int fb_idx[MAX_REF_FRAMES];
+    int used[HALFPEL_MAX_SETS] = {0};
+    int ref, i;
+
+    fb_idx[LAST_FRAME] = cm->lst_fb_idx;
+    fb_idx[GOLDEN_FRAME] = cm->gld_fb_idx;
+    fb_idx[ALTREF_FRAME] = cm->alt_fb_idx;
+
+    // The frame is reconstructed into new_fb_idx, which is no reference
+    vp8_halfpel_invalidate(cpi, cm->new_fb_idx);
+
+    for (ref = 0; ref < MAX_REF_FRAMES; ref++)
+        cpi->halfpel_ref[ref] = 0;
+
+    if (cm->frame_type == KEY_FRAME ||
+        cpi->find_fractional_mv_step == vp8_skip_fractional_mv_step)
+        return;
+
+    // Keep the sets already built from a reference in use
+    for (ref = LAST_FRAME; ref < MAX_REF_FRAMES; ref++)
+    {
+        if (!(cpi->ref_frame_flags & flags[ref]))
+            continue;
+
+        for (i = 0; i < cpi->halfpel_sets; i++)
+            if (cpi->halfpel[i].fb_idx == fb_idx[ref])
+            {
+                cpi->halfpel_ref[ref] = &cpi->halfpel[i];
+                used[i] = 1;
+            }
+    }
+
+    // Then build the missing ones in the remaining sets, last frame first
+    for (ref = LAST_FRAME; ref < MAX_REF_FRAMES; ref++)
+    {
+        if (!(cpi->ref_frame_flags & flags[ref]) || cpi->halfpel_ref[ref])
+            continue;
+
+        // Golden and altref may share a buffer built for a previous ref
+        for (i = 0; i < cpi->halfpel_sets; i++)
+            if (cpi->halfpel[i].fb_idx == fb_idx[ref])
+                break;
+
+        if (i == cpi->halfpel_sets)
+        {
+            for (i = 0; i < cpi->halfpel_sets; i++)
+                if (!used[i])
+                    break;
+
+            if (i == cpi->halfpel_sets)
+                break;
+
+            build_planes(cpi, &cpi->halfpel[i], fb_idx[ref]);
+        }
+
+        cpi->halfpel_ref[ref] = &cpi->halfpel[i];
+        used[i] = 1;
+    }
+}
+
+void vp8_halfpel_setup_mb(VP8_COMP *cpi, MACROBLOCK *x, int ref_frame,
+                          int recon_yoffset)
+{
+    HALFPEL_PLANES *planes = cpi->halfpel_ref[ref_frame];
+    int i;
+
+    for (i = 0; i < 3; i++)
+        x->halfpel[i] = planes ? planes->buf[i] + recon_yoffset : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_HALFPEL_H
+#define __INC_HALFPEL_H
+
+/* One set of planes per reference frame at most */
+#define HALFPEL_MAX_SETS 3
+
+/* The luma of a reference frame interpolated half a pel to the right (h),
+ * down (v) and both (hv), with the same stride and border as the frame, so
+ * half pel positions can be read like full pel ones. The planes match the
+ * bilinear filters of the sub pixel variance functions exactly.
+ */
+typedef struct
+{
+    unsigned char *alloc[3];
+    unsigned char *buf[3];    // origin of the h, v and hv planes
+    int fb_idx;               // frame buffer they were built from, -1 if none
+} HALFPEL_PLANES;
+
+struct VP8_COMP;
+struct macroblock;
+
+/* (Re)allocates as many sets as oxcf.halfpel_planes_kb allows, if that
+ * changed. The sets kept still hold the planes they were built from. */
+extern void vp8_halfpel_alloc(struct VP8_COMP *cpi);
+extern void vp8_halfpel_free(struct VP8_COMP *cpi);
+
+/* Marks planes built from frame buffer fb_idx as stale */
+extern void vp8_halfpel_invalidate(struct VP8_COMP *cpi, int fb_idx);
+
+/* Makes sure the references used by the frame about to be encoded have
+ * planes, last frame first, building them where needed, and points
+ * cpi->halfpel_ref at them. */
+extern void vp8_halfpel_prepare(struct VP8_COMP *cpi);
+
+/* Points x->halfpel at the planes of ref_frame for the MB at recon_yoffset,
+ * or clears it when the reference has none. */
+extern void vp8_halfpel_setup_mb(struct VP8_COMP *cpi, struct macroblock *x,
+                                 int ref_frame, int recon_yoffset);
+
+#endif
@@ -0,0 +1,336 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "onyx_int.h"
+#include "hashme.h"
+#include "vpx_mem/vpx_mem.h"
+
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+#endif
+
+/* Polynomial hashes over the rows of a block, then over its row hashes.
+ * Rows are rolled along, so every position costs a few operations. */
+#define ROW_BASE  0x01000193u
+#define COL_BASE  0x9e3779b1u
+#define QUAD_BASE 0x85ebca77u
+#define SLOT_MIX  0x2545f491u
+
+/* Slots tried after the home slot of a hash */
+#define PROBES 4
+
+typedef struct
+{
+    YV12_BUFFER_CONFIG *frame;
+    int row_step;
+} HASH_ME_JOB;
+
+static unsigned int hash8(const unsigned char *s, int stride)
+{
+    unsigned int hash = 0;
+    int r, c;
+
+    for (r = 0; r < 8; r++, s += stride)
+    {
+        unsigned int row = 0;
+
+        for (c = 0; c < 8; c++)
+            row = row * ROW_BASE + s[c];
+
+        hash = hash * COL_BASE + row;
+    }
+
+    return hash;
+}
+
+static unsigned int hash16(unsigned int tl, unsigned int tr,
+                           unsigned int bl, unsigned int br)
+{
+    return ((tl * QUAD_BASE + tr) * QUAD_BASE + bl) * QUAD_BASE + br;
+}
+
+/* The hash of an 8x8 block of pixels all equal to one */
+static unsigned int flat8_unit(void)
+{
+    unsigned int row = 0, hash = 0;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        row = row * ROW_BASE + 1;
+
+    for (i = 0; i < 8; i++)
+        hash = hash * COL_BASE + row;
+
+    return hash;
+}
+
+static void insert(HASH_ME_ENTRY *table, int bits, unsigned int hash,
+                   int row, int col)
+{
+    unsigned int mask = (1u << bits) - 1;
+    unsigned int slot = (hash * SLOT_MIX) >> (32 - bits);
+    int i;
+
+    for (i = 0; i < PROBES; i++, slot = (slot + 1) & mask)
+    {
+        HASH_ME_ENTRY *e = &table[slot];
+
+        // The first block found keeps the slot
+        if (e->hash == hash && e->row >= 0)
+            return;
+
+        if (e->row < 0)
+        {
+            e->hash = hash;
+            e->row = row;
+            e->col = col;
+            return;
+        }
+    }
+}
+
+static const HASH_ME_ENTRY *lookup(const HASH_ME_ENTRY *table, int bits,
+                                   unsigned int hash)
+{
+    unsigned int mask = (1u << bits) - 1;
+    unsigned int slot = (hash * SLOT_MIX) >> (32 - bits);
+    int i;
+
+    for (i = 0; i < PROBES; i++, slot = (slot + 1) & mask)
+    {
+        const HASH_ME_ENTRY *e = &table[slot];
+
+        if (e->row < 0)
+            return 0;
+
+        if (e->hash == hash)
+            return e;
+    }
+
+    return 0;
+}
+
+void vp8_hash_me_free(VP8_COMP *cpi)
+{
+    HASH_ME *h = &cpi->hash_me;
+
+    vpx_free(h->table[0]);
+    vpx_free(h->table[1]);
+    vpx_free(h->row_hash);
+    vpx_free(h->hash8);
+    vpx_memset(h, 0, sizeof(*h));
+}
+
+void vp8_hash_me_alloc(VP8_COMP *cpi)
+{
+    HASH_ME *h = &cpi->hash_me;
+    int width = cpi->common.yv12_fb[0].y_width;
+    int height = cpi->common.yv12_fb[0].y_height;
+    int bits;
+
+    if (!cpi->oxcf.screen_content || !width)
+    {
+        vp8_hash_me_free(cpi);
+        return;
+    }
+
+    if (h->table[0] && h->width == width && h->height == height)
+        return;
+
+    vp8_hash_me_free(cpi);
+
+    for (bits = 10; (1 << bits) < width * height; bits++);
+
+    h->width = width;
+    h->height = height;
+    h->bits = bits;
+    CHECK_MEM_ERROR(h->table[0], vpx_malloc(sizeof(HASH_ME_ENTRY) << bits));
+    CHECK_MEM_ERROR(h->table[1], vpx_malloc(sizeof(HASH_ME_ENTRY) << bits));
+    CHECK_MEM_ERROR(h->row_hash,
+                    vpx_malloc(sizeof(unsigned int) * width * height));
+    CHECK_MEM_ERROR(h->hash8,
+                    vpx_malloc(sizeof(unsigned int) * width * height));
+}
+
+static void row_hash_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread,
+                          void *data)
+{
+    HASH_ME_JOB *job = (HASH_ME_JOB *)data;
+    HASH_ME *h = &cpi->hash_me;
+    unsigned int base7 = 1;
+    int r, c;
+
+    (void) x;
+
+    for (c = 0; c < 7; c++)
+        base7 *= ROW_BASE;
+
+    for (r = ithread; r < h->height; r += job->row_step)
+    {
+        const unsigned char *s = job->frame->y_buffer +
+                                 r * job->frame->y_stride;
+        unsigned int *out = h->row_hash + r * h->width;
+        unsigned int hash = 0;
+
+        for (c = 0; c < 8; c++)
+            hash = hash * ROW_BASE + s[c];
+
+        out[0] = hash;
+
+        for (c = 1; c <= h->width - 8; c++)
+        {
+            hash = (hash - s[c - 1] * base7) * ROW_BASE + s[c + 7];
+            out[c] = hash;
+        }
+    }
+}
+
+static void block_hash_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread,
+                            void *data)
+{
+    HASH_ME_JOB *job = (HASH_ME_JOB *)data;
+    HASH_ME *h = &cpi->hash_me;
+    int r, c, i;
+
+    (void) x;
+
+    for (r = ithread; r <= h->height - 8; r += job->row_step)
+    {
+        const unsigned int *rows = h->row_hash + r * h->width;
+        unsigned int *out = h->hash8 + r * h->width;
+
+        for (c = 0; c <= h->width - 8; c++)
+        {
+            unsigned int hash = 0;
+
+            for (i = 0; i < 8; i++)
+                hash = hash * COL_BASE + rows[i * h->width + c];
+
+            out[c] = hash;
+        }
+    }
+}
+
+void vp8_hash_me_build(VP8_COMP *cpi, YV12_BUFFER_CONFIG *frame)
+{
+    HASH_ME *h = &cpi->hash_me;
+    unsigned int flat = flat8_unit();
+    HASH_ME_JOB job;
+    int r, c;
+
+    h->valid = 0;
+
+    if (frame->y_width != h->width || frame->y_height != h->height)
+        return;
+
+    job.frame = frame;
+    job.row_step = 1;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+    {
+        job.row_step = cpi->encoding_thread_count + 1;
+        vp8cx_mt_run_job(cpi, row_hash_rows, &job);
+        vp8cx_mt_run_job(cpi, block_hash_rows, &job);
+    }
+    else
+#endif
+    {
+        row_hash_rows(cpi, &cpi->mb, 0, &job);
+        block_hash_rows(cpi, &cpi->mb, 0, &job);
+    }
+
+    vpx_memset(h->table[0], 0xff, sizeof(HASH_ME_ENTRY) << h->bits);
+    vpx_memset(h->table[1], 0xff, sizeof(HASH_ME_ENTRY) << h->bits);
+
+    /* Flat blocks are left out, they match anywhere and the usual search
+     * finds them. */
+    for (r = 0; r <= h->height - 8; r++)
+    {
+        const unsigned char *s = frame->y_buffer + r * frame->y_stride;
+        const unsigned int *q = h->hash8 + r * h->width;
+
+        for (c = 0; c <= h->width - 8; c++)
+        {
+            unsigned int f = s[c] * flat;
+
+            if (q[c] != f)
+                insert(h->table[1], h->bits, q[c], r, c);
+
+            if (r <= h->height - 16 && c <= h->width - 16)
+            {
+                unsigned int q16 = hash16(q[c], q[c + 8], q[c + 8 * h->width],
+                                          q[c + 8 * h->width + 8]);
+
+                if (q16 != hash16(f, f, f, f))
+                    insert(h->table[0], h->bits, q16, r, c);
+            }
+        }
+    }
+
+    h->valid = 1;
+}
+
+int vp8_hash_me_candidates(VP8_COMP *cpi, int mb_row, int mb_col,
+                           int_mv *mvs)
+{
+    HASH_ME *h = &cpi->hash_me;
+    YV12_BUFFER_CONFIG *src = cpi->Source;
+    int stride = src->y_stride;
+    int row = mb_row * 16;
+    int col = mb_col * 16;
+    const unsigned char *s = src->y_buffer + row * stride + col;
+    unsigned int flat = flat8_unit();
+    unsigned int q[4];
+    const HASH_ME_ENTRY *e;
+    int i, j, n = 0;
+
+    if (!h->valid)
+        return 0;
+
+    for (i = 0; i < 4; i++)
+        q[i] = hash8(s + (i >> 1) * 8 * stride + (i & 1) * 8, stride);
+
+    e = lookup(h->table[0], h->bits, hash16(q[0], q[1], q[2], q[3]));
+
+    if (e)
+    {
+        mvs[0].as_mv.row = e->row - row;
+        mvs[0].as_mv.col = e->col - col;
+        return mvs[0].as_int != 0;
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        int r = row + (i >> 1) * 8;
+        int c = col + (i & 1) * 8;
+
+        if (q[i] == s[(i >> 1) * 8 * stride + (i & 1) * 8] * flat)
+            continue;
+
+        e = lookup(h->table[1], h->bits, q[i]);
+
+        if (!e)
+            continue;
+
+        mvs[n].as_mv.row = e->row - r;
+        mvs[n].as_mv.col = e->col - c;
+
+        for (j = 0; j < n; j++)
+            if (mvs[j].as_int == mvs[n].as_int)
+                break;
+
+        if (j == n && mvs[n].as_int)
+            n++;
+    }
+
+    return n;
+}
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_HASHME_H
+#define __INC_HASHME_H
+
+#include "vpx_scale/yv12config.h"
+#include "vp8/common/mv.h"
+
+/* The whole MB, or each of its 8x8 blocks */
+#define HASH_ME_MAX_CANDIDATES 4
+
+typedef struct
+{
+    unsigned int hash;
+    short row;                // -1 for an empty slot
+    short col;
+} HASH_ME_ENTRY;
+
+/* Where each 16x16 and 8x8 block of a frame is, at every pixel position,
+ * keyed by a hash of its pixels. Built from the source of the last frame,
+ * as the reconstruction of screen content is rarely an exact copy of it.
+ */
+typedef struct
+{
+    int width;
+    int height;
+    int bits;                 // log2 of the table sizes
+    HASH_ME_ENTRY *table[2];  // 16x16 and 8x8 blocks
+    unsigned int *row_hash;   // 8 pixel row hashes at every position
+    unsigned int *hash8;      // 8x8 block hashes at every position
+    int valid;
+} HASH_ME;
+
+struct VP8_COMP;
+
+/* Allocates the tables when oxcf.screen_content is set, frees them when
+ * it is not. */
+extern void vp8_hash_me_alloc(struct VP8_COMP *cpi);
+extern void vp8_hash_me_free(struct VP8_COMP *cpi);
+
+/* Hashes every block of frame, the source of the new last frame */
+extern void vp8_hash_me_build(struct VP8_COMP *cpi, YV12_BUFFER_CONFIG *frame);
+
+/* Finds the full pel MVs to the blocks of the last frame matching MB
+ * (mb_row, mb_col) of the source: the whole MB when it matches, otherwise
+ * any of its 8x8 blocks. Returns how many there are. */
+extern int vp8_hash_me_candidates(struct VP8_COMP *cpi, int mb_row,
+                                  int mb_col, int_mv *mvs);
+
+#endif
@@ -22,6 +22,7 @@ struct lookahead_ctx
     unsigned int read_idx;       /* Read index */
     unsigned int write_idx;      /* Write index */
     struct lookahead_entry *buf; /* Buffer list */
+    int pushed;                  /* Whether a buffer was ever pushed */
 };
 
 
@@ -167,6 +168,50 @@ vp8_lookahead_push(struct lookahead_ctx *ctx,
     buf->ts_start = ts_start;
     buf->ts_end = ts_end;
     buf->flags = flags;
+    ctx->pushed = 1;
+    return 0;
+}
+
+
+int
+vp8_lookahead_still_mbs(struct lookahead_ctx *ctx,
+                        YV12_BUFFER_CONFIG   *src,
+                        vp8_sad_fn_t          sdf,
+                        unsigned int          thresh,
+                        unsigned char        *still)
+{
+    YV12_BUFFER_CONFIG *last = &ctx->buf[ctx->write_idx].img;
+    int row, col;
+    int mb_rows = (src->y_height + 15) >> 4;
+    int mb_cols = (src->y_width + 15) >> 4;
+
+    if(ctx->max_sz != 1 || !ctx->pushed)
+        return 1;
+
+    for(row = 0; row < mb_rows; ++row)
+    {
+        unsigned char *src_ptr = src->y_buffer + (row << 4) * src->y_stride;
+        unsigned char *last_ptr = last->y_buffer + (row << 4) * last->y_stride;
+
+        for(col = 0; col < mb_cols; ++col)
+        {
+            // The source is not padded, so partial MBs always change
+            if((row << 4) + 16 <= src->y_height
+               && (col << 4) + 16 <= src->y_width
+               && sdf(src_ptr + (col << 4), src->y_stride,
+                      last_ptr + (col << 4), last->y_stride,
+                      thresh) <= thresh)
+            {
+                if(*still < 255)
+                    (*still)++;
+            }
+            else
+                *still = 0;
+
+            still++;
+        }
+    }
+
     return 0;
 }
 
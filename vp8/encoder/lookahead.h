@@ -11,6 +11,7 @@
 #define LOOKAHEAD_H
 #include "vpx_scale/yv12config.h"
 #include "vpx/vpx_integer.h"
+#include "variance.h"
 
 struct lookahead_entry
 {
@@ -66,6 +67,28 @@ vp8_lookahead_push(struct lookahead_ctx *ctx,
                    unsigned char        *active_map);
 
 
+/**\brief Count how long each macroblock of a source image has been still
+ * Compares the luma of each macroblock of src with the frame the next push
+ * will overwrite. With a queue depth of 1 that is the last frame pushed,
+ * with its inactive macroblocks as they were when last copied, so slow
+ * changes add up. Macroblocks within thresh of it have their count in
+ * still incremented, the others, and partial ones at the frame edges, have
+ * it reset to 0.
+ * \param[in] ctx         Pointer to the lookahead context
+ * \param[in] src         Pointer to the image about to be enqueued
+ * \param[in] sdf         16x16 SAD function
+ * \param[in] thresh      Largest SAD of a still macroblock
+ * \param[in,out] still   Count of each macroblock, in raster order
+ * \retval 1, if the queue depth is not 1 or nothing was pushed yet
+ */
+int
+vp8_lookahead_still_mbs(struct lookahead_ctx *ctx,
+                        YV12_BUFFER_CONFIG   *src,
+                        vp8_sad_fn_t          sdf,
+                        unsigned int          thresh,
+                        unsigned char        *still);
+
+
 /**\brief Get the next source buffer to encode
  *
  *
@@ -0,0 +1,146 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include "onyx_int.h"
+#include "mbhint.h"
+#include "mcomp.h"
+
+/* Beyond any MV that can point into the bordered frame, in 1/4 pel */
+#define MB_HINT_MV_MAX 4095
+
+static short hint_mv_component(short v, int mask)
+{
+    if (v > MB_HINT_MV_MAX)
+        v = MB_HINT_MV_MAX;
+    else if (v < -MB_HINT_MV_MAX)
+        v = -MB_HINT_MV_MAX;
+
+    return (v * 2) & mask;
+}
+
+int vp8_set_mb_hints(VP8_COMP *cpi, vpx_mb_hint_map_t *map)
+{
+    // The top left 4x4 block of each 8x8 quarter
+    static const int quarters[MB_HINT_MAX_CANDIDATES] = {0, 2, 8, 10};
+    int mask = cpi->common.full_pixel ? ~7 : ~0;
+    unsigned int i;
+
+    if (map->rows != (unsigned int)cpi->common.mb_rows ||
+        map->cols != (unsigned int)cpi->common.mb_cols)
+        return -1;
+
+    if (!map->hints)
+    {
+        cpi->mb_hints_valid = 0;
+        return 0;
+    }
+
+    for (i = 0; i < map->rows * map->cols; i++)
+    {
+        const vpx_mb_hint_t *src = &map->hints[i];
+        MB_HINT *hint = &cpi->mb_hints[i];
+        int n = src->mode == VP8_MB_HINT_SPLIT ? MB_HINT_MAX_CANDIDATES : 1;
+        int j, k;
+
+        hint->mode = VP8_MB_HINT_NONE;
+        hint->ref_frame = INTRA_FRAME;
+        hint->count = 0;
+
+        if (src->mode == VP8_MB_HINT_INTRA)
+            hint->mode = VP8_MB_HINT_INTRA;
+
+        if (src->mode != VP8_MB_HINT_INTER && src->mode != VP8_MB_HINT_SPLIT)
+            continue;
+
+        switch (src->ref_frame)
+        {
+        case VP8_LAST_FRAME:
+            hint->ref_frame = LAST_FRAME;
+            break;
+        case VP8_GOLD_FRAME:
+            hint->ref_frame = GOLDEN_FRAME;
+            break;
+        case VP8_ALTR_FRAME:
+            hint->ref_frame = ALTREF_FRAME;
+            break;
+        default:
+            continue;
+        }
+
+        hint->mode = src->mode;
+
+        for (j = 0; j < n; j++)
+        {
+            int_mv mv;
+
+            mv.as_mv.row = hint_mv_component(src->mv[quarters[j]][0], mask);
+            mv.as_mv.col = hint_mv_component(src->mv[quarters[j]][1], mask);
+
+            for (k = 0; k < hint->count; k++)
+                if (hint->mv[k].as_int == mv.as_int)
+                    break;
+
+            if (k == hint->count)
+                hint->mv[hint->count++].as_int = mv.as_int;
+        }
+    }
+
+    cpi->mb_hints_valid = 1;
+    cpi->mb_hints_only = map->only;
+    return 0;
+}
+
+const MB_HINT *vp8_mb_hint(VP8_COMP *cpi, int mb_row, int mb_col)
+{
+    static const int flags[MAX_REF_FRAMES] =
+    {
+        0, VP8_LAST_FLAG, VP8_GOLD_FLAG, VP8_ALT_FLAG
+    };
+    const MB_HINT *hint;
+
+    if (!cpi->mb_hints_valid)
+        return 0;
+
+    hint = &cpi->mb_hints[mb_row * cpi->common.mb_cols + mb_col];
+
+    if (hint->mode == VP8_MB_HINT_NONE ||
+        (hint->ref_frame != INTRA_FRAME &&
+         !(cpi->ref_frame_flags & flags[hint->ref_frame])))
+        return 0;
+
+    return hint;
+}
+
+int vp8_mb_hint_mv_valid(const MB_HINT *hint, const int_mv *ref_mv)
+{
+    int row = hint->mv[0].as_mv.row >> 3;
+    int col = hint->mv[0].as_mv.col >> 3;
+
+    // The window the NEWMV search is limited to
+    return hint->mode == VP8_MB_HINT_INTER &&
+           col >= ((ref_mv->as_mv.col + 7) >> 3) - MAX_FULL_PEL_VAL &&
+           col <= (ref_mv->as_mv.col >> 3) + MAX_FULL_PEL_VAL &&
+           row >= ((ref_mv->as_mv.row + 7) >> 3) - MAX_FULL_PEL_VAL &&
+           row <= (ref_mv->as_mv.row >> 3) + MAX_FULL_PEL_VAL;
+}
+
+int vp8_mb_hint_candidates(const MB_HINT *hint, int_mv *mvs)
+{
+    int i;
+
+    for (i = 0; i < hint->count; i++)
+    {
+        mvs[i].as_mv.row = hint->mv[i].as_mv.row >> 3;
+        mvs[i].as_mv.col = hint->mv[i].as_mv.col >> 3;
+    }
+
+    return hint->count;
+}
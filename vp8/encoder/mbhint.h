@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_MBHINT_H
+#define __INC_MBHINT_H
+
+#include "vpx/vp8.h"
+#include "vp8/common/mv.h"
+
+/* The 16x16 MV, or the MVs of the four 8x8 quarters of a split */
+#define MB_HINT_MAX_CANDIDATES 4
+
+/* Hinted MVs are good to a pixel or two, so the full pel search started
+ * from one only takes the smallest steps. */
+#define MB_HINT_STEP_PARAM (MAX_MVSEARCH_STEPS - 2)
+
+/* A vpx_mb_hint_t as the encoder uses it */
+typedef struct
+{
+    unsigned char mode;       // VP8_MB_HINT_NONE to VP8_MB_HINT_SPLIT
+    unsigned char ref_frame;  // INTRA_FRAME to ALTREF_FRAME
+    unsigned char count;      // distinct MVs in mv[]
+    int_mv mv[MB_HINT_MAX_CANDIDATES];  // 1/8 pel, as in MODE_INFO
+} MB_HINT;
+
+struct VP8_COMP;
+
+/* The hint of MB (mb_row, mb_col) of the frame being encoded, if there is
+ * one and its reference frame can be used. */
+extern const MB_HINT *vp8_mb_hint(struct VP8_COMP *cpi, int mb_row,
+                                  int mb_col);
+
+/* Whether the hinted 16x16 MV can be coded as a NEWMV against ref_mv */
+extern int vp8_mb_hint_mv_valid(const MB_HINT *hint, const int_mv *ref_mv);
+
+/* Copies the hinted MVs, in full pel, to mvs. Returns how many there are. */
+extern int vp8_mb_hint_candidates(const MB_HINT *hint, int_mv *mvs);
+
+#endif
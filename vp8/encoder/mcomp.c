@@ -179,7 +179,8 @@ void vp8_init3smotion_compensation(MACROBLOCK *x, int stride)
 #define MVC(r,c) (((mvcost[0][(r)-rr] + mvcost[1][(c) - rc]) * error_per_bit + 128 )>>8 ) // estimated cost of a motion vector (r,c)
 #define PRE(r,c) (y + (((r)>>2) * y_stride + ((c)>>2) -(offset))) // pointer to predictor base of a motionvector
 #define SP(x) (((x)&3)<<1) // convert motion vector component to offset for svf calc
-#define DIST(r,c) vfp->svf( PRE(r,c), y_stride, SP(c),SP(r), z,b->src_stride,&sse) // returns subpixel variance error function.
+#define HPRE(r,c) ((((r)|(c))&2 ? x->halfpel[(((r)&2)|(((c)&2)>>1))-1] : *(d->base_pre)) + d->pre + ((r)>>2) * d->pre_stride + ((c)>>2)) // pointer to a full or half pel position in the precomputed planes
+#define DIST(r,c) ((x->halfpel[0] && !(((r)|(c))&1)) ? vfp->vf(HPRE(r,c), d->pre_stride, z, b->src_stride, &sse) : vfp->svf( PRE(r,c), y_stride, SP(c),SP(r), z,b->src_stride,&sse)) // returns subpixel variance error function.
 #define IFMVCV(r,c,s,e) if ( c >= minc && c <= maxc && r >= minr && r <= maxr) s else e;
 #define ERR(r,c) (MVC(r,c)+DIST(r,c)) // returns distortion + motion vector cost
 #define CHECK_BETTER(v,r,c) IFMVCV(r,c,{thismse = DIST(r,c); if((v = (MVC(r,c)+thismse)) < besterr) { besterr = v; br=r; bc=c; *distortion = thismse; *sse1 = sse; }}, v=INT_MAX;)// checks if (r,c) has better score than previous best
@@ -325,12 +326,20 @@ int vp8_find_best_sub_pixel_step_iteratively(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
 }
 #undef MVC
 #undef PRE
+#undef HPRE
 #undef SP
 #undef DIST
 #undef IFMVCV
 #undef ERR
 #undef CHECK_BETTER
 
+/* Variance at the half pel position in direction dir whose filter starts r
+ * rows and c cols from y, read from the precomputed planes if there are. */
+#define HALFPIX_VAR(dir, plane, r, c) \
+    (x->halfpel[0] ? \
+     vfp->vf(x->halfpel[plane] + hp_offset + (r) * d->pre_stride + (c), d->pre_stride, z, b->src_stride, &sse) : \
+     vfp->svf_halfpix_##dir(y + (r) * y_stride + (c), y_stride, z, b->src_stride, &sse))
+
 int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
                                  int_mv *bestmv, int_mv *ref_mv,
                                  int error_per_bit,
@@ -347,6 +356,7 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     int whichdir ;
     int thismse;
     int y_stride;
+    int hp_offset = d->pre + (bestmv->as_mv.row) * d->pre_stride + bestmv->as_mv.col;
 
 #if ARCH_X86 || ARCH_X86_64
     MACROBLOCKD *xd = &x->e_mbd;
@@ -375,7 +385,7 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     // go left then right and check error
     this_mv.as_mv.row = startmv.as_mv.row;
     this_mv.as_mv.col = ((startmv.as_mv.col - 8) | 4);
-    thismse = vfp->svf_halfpix_h(y - 1, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(h, 0, 0, -1);
     left = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (left < bestmse)
@@ -387,7 +397,7 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     }
 
     this_mv.as_mv.col += 8;
-    thismse = vfp->svf_halfpix_h(y, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(h, 0, 0, 0);
     right = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (right < bestmse)
@@ -401,7 +411,7 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     // go up then down and check error
     this_mv.as_mv.col = startmv.as_mv.col;
     this_mv.as_mv.row = ((startmv.as_mv.row - 8) | 4);
-    thismse =  vfp->svf_halfpix_v(y - y_stride, y_stride, z, b->src_stride, &sse);
+    thismse =  HALFPIX_VAR(v, 1, -1, 0);
     up = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (up < bestmse)
@@ -413,7 +423,7 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     }
 
     this_mv.as_mv.row += 8;
-    thismse = vfp->svf_halfpix_v(y, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(v, 1, 0, 0);
     down = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (down < bestmse)
@@ -436,23 +446,23 @@ int vp8_find_best_sub_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     case 0:
         this_mv.as_mv.col = (this_mv.as_mv.col - 8) | 4;
         this_mv.as_mv.row = (this_mv.as_mv.row - 8) | 4;
-        thismse = vfp->svf_halfpix_hv(y - 1 - y_stride, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, -1, -1);
         break;
     case 1:
         this_mv.as_mv.col += 4;
         this_mv.as_mv.row = (this_mv.as_mv.row - 8) | 4;
-        thismse = vfp->svf_halfpix_hv(y - y_stride, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, -1, 0);
         break;
     case 2:
         this_mv.as_mv.col = (this_mv.as_mv.col - 8) | 4;
         this_mv.as_mv.row += 4;
-        thismse = vfp->svf_halfpix_hv(y - 1, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, 0, -1);
         break;
     case 3:
     default:
         this_mv.as_mv.col += 4;
         this_mv.as_mv.row += 4;
-        thismse = vfp->svf_halfpix_hv(y, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, 0, 0);
         break;
     }
 
@@ -662,6 +672,7 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     int whichdir ;
     int thismse;
     int y_stride;
+    int hp_offset = d->pre + (bestmv->as_mv.row) * d->pre_stride + bestmv->as_mv.col;
 
 #if ARCH_X86 || ARCH_X86_64
     MACROBLOCKD *xd = &x->e_mbd;
@@ -690,7 +701,7 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     // go left then right and check error
     this_mv.as_mv.row = startmv.as_mv.row;
     this_mv.as_mv.col = ((startmv.as_mv.col - 8) | 4);
-    thismse = vfp->svf_halfpix_h(y - 1, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(h, 0, 0, -1);
     left = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (left < bestmse)
@@ -702,7 +713,7 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     }
 
     this_mv.as_mv.col += 8;
-    thismse = vfp->svf_halfpix_h(y, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(h, 0, 0, 0);
     right = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (right < bestmse)
@@ -716,7 +727,7 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     // go up then down and check error
     this_mv.as_mv.col = startmv.as_mv.col;
     this_mv.as_mv.row = ((startmv.as_mv.row - 8) | 4);
-    thismse = vfp->svf_halfpix_v(y - y_stride, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(v, 1, -1, 0);
     up = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (up < bestmse)
@@ -728,7 +739,7 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     }
 
     this_mv.as_mv.row += 8;
-    thismse = vfp->svf_halfpix_v(y, y_stride, z, b->src_stride, &sse);
+    thismse = HALFPIX_VAR(v, 1, 0, 0);
     down = thismse + mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
 
     if (down < bestmse)
@@ -748,23 +759,23 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     case 0:
         this_mv.as_mv.col = (this_mv.as_mv.col - 8) | 4;
         this_mv.as_mv.row = (this_mv.as_mv.row - 8) | 4;
-        thismse = vfp->svf_halfpix_hv(y - 1 - y_stride, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, -1, -1);
         break;
     case 1:
         this_mv.as_mv.col += 4;
         this_mv.as_mv.row = (this_mv.as_mv.row - 8) | 4;
-        thismse = vfp->svf_halfpix_hv(y - y_stride, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, -1, 0);
         break;
     case 2:
         this_mv.as_mv.col = (this_mv.as_mv.col - 8) | 4;
         this_mv.as_mv.row += 4;
-        thismse = vfp->svf_halfpix_hv(y - 1, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, 0, -1);
         break;
     case 3:
     default:
         this_mv.as_mv.col += 4;
         this_mv.as_mv.row += 4;
-        thismse = vfp->svf_halfpix_hv(y, y_stride, z, b->src_stride, &sse);
+        thismse = HALFPIX_VAR(hv, 2, 0, 0);
         break;
     }
 
@@ -781,6 +792,8 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *x, BLOCK *b, BLOCKD *d,
     return bestmse;
 }
 
+#undef HALFPIX_VAR
+
 #define CHECK_BOUNDS(range) \
 {\
     all_in = 1;\
@@ -1005,6 +1018,187 @@ cal_neighbors:
 
     return bestsad;
 }
+
+/* Starts the full pel search from alt instead of start when it has the
+ * lower SAD. Returns 1 if start was replaced. */
+int vp8_better_start_mv
+(
+    MACROBLOCK *x,
+    BLOCK *b,
+    BLOCKD *d,
+    int_mv *start,
+    int_mv *alt,
+    int sad_per_bit,
+    const vp8_variance_fn_ptr_t *vfp,
+    int *mvsadcost[2],
+    int_mv *center_mv
+)
+{
+    unsigned char *what = (*(b->base_src) + b->src);
+    int what_stride = b->src_stride;
+    int in_what_stride = d->pre_stride;
+    unsigned char *base_offset = (unsigned char *)(*(d->base_pre) + d->pre);
+    unsigned int startsad, altsad;
+    int_mv this_mv;
+
+    int_mv fcenter_mv;
+    fcenter_mv.as_mv.row = center_mv->as_mv.row >> 3;
+    fcenter_mv.as_mv.col = center_mv->as_mv.col >> 3;
+
+    this_mv.as_int = alt->as_int;
+    vp8_clamp_mv(start, x->mv_col_min, x->mv_col_max, x->mv_row_min, x->mv_row_max);
+    vp8_clamp_mv(&this_mv, x->mv_col_min, x->mv_col_max, x->mv_row_min, x->mv_row_max);
+
+    if (this_mv.as_int == start->as_int)
+        return 0;
+
+    startsad = vfp->sdf(what, what_stride,
+                        base_offset + start->as_mv.row * in_what_stride + start->as_mv.col,
+                        in_what_stride, 0x7fffffff)
+             + mvsad_err_cost(start, &fcenter_mv, mvsadcost, sad_per_bit);
+    altsad = vfp->sdf(what, what_stride,
+                      base_offset + this_mv.as_mv.row * in_what_stride + this_mv.as_mv.col,
+                      in_what_stride, startsad)
+           + mvsad_err_cost(&this_mv, &fcenter_mv, mvsadcost, sad_per_bit);
+
+    if (altsad < startsad)
+    {
+        start->as_int = this_mv.as_int;
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Predictive zonal search. The full pel candidates, typically the MVs of
+ * the neighbouring MBs and of the co-located MB in the last frame, are
+ * tried first. The search stops there if the best one is below stop_sad.
+ * Below refine_sad it is refined with a small diamond, otherwise the
+ * prediction is taken to be poor and a hex search is run from it.
+ */
+int vp8_epzs_search
+(
+    MACROBLOCK *x,
+    BLOCK *b,
+    BLOCKD *d,
+    int_mv *candidates,
+    int candidate_count,
+    int_mv *best_mv,
+    unsigned int stop_sad,
+    unsigned int refine_sad,
+    int sad_per_bit,
+    const vp8_variance_fn_ptr_t *vfp,
+    int *mvsadcost[2],
+    int *mvcost[2],
+    int_mv *center_mv
+)
+{
+    MV neighbors[4] = {{0, -1}, { -1, 0}, {1, 0}, {0, 1}} ;
+    int i, j;
+
+    unsigned char *what = (*(b->base_src) + b->src);
+    int what_stride = b->src_stride;
+    int in_what_stride = d->pre_stride;
+    int br = 0, bc = 0;
+    int_mv this_mv;
+    unsigned int bestsad = 0x7fffffff;
+    unsigned int thissad;
+    unsigned char *base_offset;
+    unsigned char *this_offset;
+    int all_in;
+    int best_site = -1;
+
+    int_mv fcenter_mv;
+    fcenter_mv.as_mv.row = center_mv->as_mv.row >> 3;
+    fcenter_mv.as_mv.col = center_mv->as_mv.col >> 3;
+
+    base_offset = (unsigned char *)(*(d->base_pre) + d->pre);
+
+    // try the candidates, skipping any seen already
+    for (i = 0; i < candidate_count; i++)
+    {
+        vp8_clamp_mv(&candidates[i], x->mv_col_min, x->mv_col_max,
+                     x->mv_row_min, x->mv_row_max);
+
+        for (j = 0; j < i; j++)
+            if (candidates[j].as_int == candidates[i].as_int)
+                break;
+
+        if (j < i)
+            continue;
+
+        this_mv.as_int = candidates[i].as_int;
+        this_offset = base_offset + (this_mv.as_mv.row * in_what_stride) + this_mv.as_mv.col;
+        thissad = vfp->sdf( what, what_stride, this_offset, in_what_stride, bestsad);
+        CHECK_BETTER
+    }
+
+    if (best_site == -1)
+    {
+        best_mv->as_int = 0;
+        return INT_MAX;
+    }
+
+    br = candidates[best_site].as_mv.row;
+    bc = candidates[best_site].as_mv.col;
+
+    if (bestsad < stop_sad)
+    {
+        best_mv->as_mv.row = br;
+        best_mv->as_mv.col = bc;
+        return bestsad;
+    }
+
+    if (bestsad >= refine_sad)
+    {
+        this_mv.as_mv.row = br;
+        this_mv.as_mv.col = bc;
+        return vp8_hex_search(x, b, d, &this_mv, best_mv, 0, sad_per_bit,
+                              vfp, mvsadcost, mvcost, center_mv);
+    }
+
+    for (j = 0; j < 8 && bestsad >= stop_sad; j++)
+    {
+        best_site = -1;
+        CHECK_BOUNDS(1)
+
+        if(all_in)
+        {
+            for (i = 0; i < 4; i++)
+            {
+                this_mv.as_mv.row = br + neighbors[i].row;
+                this_mv.as_mv.col = bc + neighbors[i].col;
+                this_offset = base_offset + (this_mv.as_mv.row * (in_what_stride)) + this_mv.as_mv.col;
+                thissad = vfp->sdf( what, what_stride, this_offset, in_what_stride, bestsad);
+                CHECK_BETTER
+            }
+        }else
+        {
+            for (i = 0; i < 4; i++)
+            {
+                this_mv.as_mv.row = br + neighbors[i].row;
+                this_mv.as_mv.col = bc + neighbors[i].col;
+                CHECK_POINT
+                this_offset = base_offset + (this_mv.as_mv.row * (in_what_stride)) + this_mv.as_mv.col;
+                thissad = vfp->sdf( what, what_stride, this_offset, in_what_stride, bestsad);
+                CHECK_BETTER
+            }
+        }
+
+        if (best_site == -1)
+            break;
+        else
+        {
+            br += neighbors[best_site].row;
+            bc += neighbors[best_site].col;
+        }
+    }
+
+    best_mv->as_mv.row = br;
+    best_mv->as_mv.col = bc;
+
+    return bestsad;
+}
 #undef CHECK_BOUNDS
 #undef CHECK_POINT
 #undef CHECK_BETTER
@@ -1292,6 +1486,52 @@ int vp8_diamond_search_sadx4
         + mv_err_cost(&this_mv, center_mv, mvcost, x->errorperbit);
 }
 
+/* Successive elimination: the SAD of a candidate block is at least the sum,
+ * over its sub-blocks, of the difference between the sum of each and that
+ * of the source sub-block. 4x4 blocks are split into 2x2 sub-blocks, the
+ * others into 4x4 ones, which prune more than whole block sums for less
+ * than the SADs they save. */
+#define SEA_SUB_SIZE(fn_ptr) ((fn_ptr)->width == 4 ? 2 : 4)
+
+static void sea_source_sums(unsigned char *src, int stride,
+                            vp8_variance_fn_ptr_t *fn_ptr,
+                            unsigned int *src_sum)
+{
+    int size = SEA_SUB_SIZE(fn_ptr);
+    int r, c, i, j;
+
+    for (r = 0; r < fn_ptr->height; r += size)
+        for (c = 0; c < fn_ptr->width; c += size)
+        {
+            unsigned char *s = src + r * stride + c;
+            unsigned int sum = 0;
+
+            for (i = 0; i < size; i++, s += stride)
+                for (j = 0; j < size; j++)
+                    sum += s[j];
+
+            *src_sum++ = sum;
+        }
+}
+
+static int sea_bound(unsigned short *sums, int stride,
+                     vp8_variance_fn_ptr_t *fn_ptr, unsigned int *src_sum)
+{
+    int size = SEA_SUB_SIZE(fn_ptr);
+    int bound = 0;
+    int r, c;
+
+    for (r = 0; r < fn_ptr->height; r += size, sums += size * stride)
+        for (c = 0; c < fn_ptr->width; c += size)
+            bound += abs((int)sums[c] - (int)*src_sum++);
+
+    return bound;
+}
+
+// The bound at candidate p, or 0 when there are no block sums
+#define SEA_BOUND(p) (sums ? sea_bound(sums + ((p) - in_what), \
+                                       in_what_stride, fn_ptr, src_sum) : 0)
+
 int vp8_full_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
                         int sad_per_bit, int distance,
                         vp8_variance_fn_ptr_t *fn_ptr, int *mvcost[2],
@@ -1310,6 +1550,7 @@ int vp8_full_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
     unsigned char *check_here;
     int thissad;
+    int mv_cost;
 
     int ref_row = ref_mv->as_mv.row;
     int ref_col = ref_mv->as_mv.col;
@@ -1321,6 +1562,10 @@ int vp8_full_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
     int *mvsadcost[2] = {x->mvsadcost[0], x->mvsadcost[1]};
     int_mv fcenter_mv;
+
+    unsigned short *sums = x->block_sums[0];
+    unsigned int src_sum[16];
+
     fcenter_mv.as_mv.row = center_mv->as_mv.row >> 3;
     fcenter_mv.as_mv.col = center_mv->as_mv.col >> 3;
 
@@ -1349,6 +1594,12 @@ int vp8_full_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
     if (row_max > x->mv_row_max)
         row_max = x->mv_row_max;
 
+    if (sums)
+    {
+        sums = x->block_sums[SEA_SUB_SIZE(fn_ptr) == 4] + d->pre;
+        sea_source_sums(what, what_stride, fn_ptr, src_sum);
+    }
+
     for (r = row_min; r < row_max ; r++)
     {
         this_mv.as_mv.row = r;
@@ -1356,18 +1607,22 @@ int vp8_full_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
         for (c = col_min; c < col_max; c++)
         {
-            thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
-
             this_mv.as_mv.col = c;
-            thissad  += mvsad_err_cost(&this_mv, &fcenter_mv,
+            mv_cost = mvsad_err_cost(&this_mv, &fcenter_mv,
                         mvsadcost, sad_per_bit);
 
-            if (thissad < bestsad)
+            if (SEA_BOUND(check_here) + mv_cost < bestsad)
             {
-                bestsad = thissad;
-                best_mv->as_mv.row = r;
-                best_mv->as_mv.col = c;
-                bestaddress = check_here;
+                thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+                thissad += mv_cost;
+
+                if (thissad < bestsad)
+                {
+                    bestsad = thissad;
+                    best_mv->as_mv.row = r;
+                    best_mv->as_mv.col = c;
+                    bestaddress = check_here;
+                }
             }
 
             check_here++;
@@ -1415,6 +1670,10 @@ int vp8_full_search_sadx3(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
     int *mvsadcost[2] = {x->mvsadcost[0], x->mvsadcost[1]};
     int_mv fcenter_mv;
+
+    unsigned short *sums = x->block_sums[0];
+    unsigned int src_sum[16];
+
     fcenter_mv.as_mv.row = center_mv->as_mv.row >> 3;
     fcenter_mv.as_mv.col = center_mv->as_mv.col >> 3;
 
@@ -1443,6 +1702,12 @@ int vp8_full_search_sadx3(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
     if (row_max > x->mv_row_max)
         row_max = x->mv_row_max;
 
+    if (sums)
+    {
+        sums = x->block_sums[SEA_SUB_SIZE(fn_ptr) == 4] + d->pre;
+        sea_source_sums(what, what_stride, fn_ptr, src_sum);
+    }
+
     for (r = row_min; r < row_max ; r++)
     {
         this_mv.as_mv.row = r;
@@ -1453,6 +1718,20 @@ int vp8_full_search_sadx3(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
         {
             int i;
 
+            if (sums)
+            {
+                for (i = 0; i < 3; i++)
+                    if ((unsigned int)SEA_BOUND(check_here + i) < bestsad)
+                        break;
+
+                if (i == 3)
+                {
+                    check_here += 3;
+                    c += 3;
+                    continue;
+                }
+            }
+
             fn_ptr->sdx3f(what, what_stride, check_here , in_what_stride, sad_array);
 
             for (i = 0; i < 3; i++)
@@ -1481,7 +1760,10 @@ int vp8_full_search_sadx3(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
         while (c < col_max)
         {
-            thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+            if ((unsigned int)SEA_BOUND(check_here) < bestsad)
+                thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+            else
+                thissad = bestsad;
 
             if (thissad < bestsad)
             {
@@ -1546,6 +1828,10 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
     int *mvsadcost[2] = {x->mvsadcost[0], x->mvsadcost[1]};
     int_mv fcenter_mv;
+
+    unsigned short *sums = x->block_sums[0];
+    unsigned int src_sum[16];
+
     fcenter_mv.as_mv.row = center_mv->as_mv.row >> 3;
     fcenter_mv.as_mv.col = center_mv->as_mv.col >> 3;
 
@@ -1574,6 +1860,12 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
     if (row_max > x->mv_row_max)
         row_max = x->mv_row_max;
 
+    if (sums)
+    {
+        sums = x->block_sums[SEA_SUB_SIZE(fn_ptr) == 4] + d->pre;
+        sea_source_sums(what, what_stride, fn_ptr, src_sum);
+    }
+
     for (r = row_min; r < row_max ; r++)
     {
         this_mv.as_mv.row = r;
@@ -1584,6 +1876,20 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
         {
             int i;
 
+            if (sums)
+            {
+                for (i = 0; i < 8; i++)
+                    if ((unsigned int)SEA_BOUND(check_here + i) < bestsad)
+                        break;
+
+                if (i == 8)
+                {
+                    check_here += 8;
+                    c += 8;
+                    continue;
+                }
+            }
+
             fn_ptr->sdx8f(what, what_stride, check_here , in_what_stride, sad_array8);
 
             for (i = 0; i < 8; i++)
@@ -1614,6 +1920,20 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
         {
             int i;
 
+            if (sums)
+            {
+                for (i = 0; i < 3; i++)
+                    if ((unsigned int)SEA_BOUND(check_here + i) < bestsad)
+                        break;
+
+                if (i == 3)
+                {
+                    check_here += 3;
+                    c += 3;
+                    continue;
+                }
+            }
+
             fn_ptr->sdx3f(what, what_stride, check_here , in_what_stride, sad_array);
 
             for (i = 0; i < 3; i++)
@@ -1642,7 +1962,10 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
 
         while (c < col_max)
         {
-            thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+            if ((unsigned int)SEA_BOUND(check_here) < bestsad)
+                thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+            else
+                thissad = bestsad;
 
             if (thissad < bestsad)
             {
@@ -1674,6 +1997,9 @@ int vp8_full_search_sadx8(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
         return INT_MAX;
 }
 
+#undef SEA_BOUND
+#undef SEA_SUB_SIZE
+
 int vp8_refining_search_sad_c(MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *ref_mv,
                             int error_per_bit, int search_range,
                             vp8_variance_fn_ptr_t *fn_ptr, int *mvcost[2],
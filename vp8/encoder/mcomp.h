@@ -46,6 +46,36 @@ extern int vp8_hex_search
     int_mv *center_mv
 );
 
+extern int vp8_better_start_mv
+(
+    MACROBLOCK *x,
+    BLOCK *b,
+    BLOCKD *d,
+    int_mv *start,
+    int_mv *alt,
+    int error_per_bit,
+    const vp8_variance_fn_ptr_t *vf,
+    int *mvsadcost[2],
+    int_mv *center_mv
+);
+
+extern int vp8_epzs_search
+(
+    MACROBLOCK *x,
+    BLOCK *b,
+    BLOCKD *d,
+    int_mv *candidates,
+    int candidate_count,
+    int_mv *best_mv,
+    unsigned int stop_sad,
+    unsigned int refine_sad,
+    int error_per_bit,
+    const vp8_variance_fn_ptr_t *vf,
+    int *mvsadcost[2],
+    int *mvcost[2],
+    int_mv *center_mv
+);
+
 typedef int (fractional_mv_step_fp)
     (MACROBLOCK *x, BLOCK *b, BLOCKD *d, int_mv *bestmv, int_mv *ref_mv,
      int error_per_bit, const vp8_variance_fn_ptr_t *vfp, int *mvcost[2],
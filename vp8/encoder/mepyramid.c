@@ -0,0 +1,212 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include <limits.h>
+#include "onyx_int.h"
+#include "mepyramid.h"
+#include "vpx_mem/vpx_mem.h"
+
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+#endif
+
+static const MV neighbors[8] =
+{
+    { -1, -1}, { -1, 0}, { -1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}
+};
+
+int vp8_me_pyramid_alloc(ME_PYRAMID *p, int width, int height)
+{
+    int i;
+
+    vp8_me_pyramid_free(p);
+
+    for (i = 0; i < ME_PYRAMID_LEVELS; i++)
+    {
+        width >>= 1;
+        height >>= 1;
+
+        p->width[i] = width;
+        p->height[i] = height;
+        p->buf[i] = vpx_malloc(width * height);
+
+        if (!p->buf[i])
+            return 1;
+    }
+
+    return 0;
+}
+
+void vp8_me_pyramid_free(ME_PYRAMID *p)
+{
+    int i;
+
+    for (i = 0; i < ME_PYRAMID_LEVELS; i++)
+    {
+        vpx_free(p->buf[i]);
+        p->buf[i] = 0;
+    }
+}
+
+static void downsample(const unsigned char *src, int src_stride,
+                       unsigned char *dst, int width, int height)
+{
+    int r, c;
+
+    for (r = 0; r < height; r++)
+    {
+        const unsigned char *s0 = src + 2 * r * src_stride;
+        const unsigned char *s1 = s0 + src_stride;
+
+        for (c = 0; c < width; c++)
+            dst[c] = (s0[2*c] + s0[2*c+1] + s1[2*c] + s1[2*c+1] + 2) >> 2;
+
+        dst += width;
+    }
+}
+
+void vp8_me_pyramid_build(ME_PYRAMID *p, YV12_BUFFER_CONFIG *frame)
+{
+    int i;
+
+    downsample(frame->y_buffer, frame->y_stride, p->buf[0],
+               p->width[0], p->height[0]);
+
+    for (i = 1; i < ME_PYRAMID_LEVELS; i++)
+        downsample(p->buf[i-1], p->width[i-1], p->buf[i],
+                   p->width[i], p->height[i]);
+}
+
+void vp8_me_pyramid_search(const ME_PYRAMID *src, const ME_PYRAMID *ref,
+                           int mb_row, int mb_col,
+                           const int_mv *pred, int pred_count,
+                           int_mv *mv,
+                           const vp8_variance_fn_ptr_t *fn_ptr)
+{
+    const vp8_variance_fn_ptr_t *vfp = &fn_ptr[BLOCK_4X4];
+    const int level = ME_PYRAMID_LEVELS - 1;
+    const int shift = level + 1;
+    int stride = src->width[level];
+    int x = mb_col * 4;
+    int y = mb_row * 4;
+    int col_min = -x;
+    int col_max = src->width[level] - 4 - x;
+    int row_min = -y;
+    int row_max = src->height[level] - 4 - y;
+    unsigned char *what = src->buf[level] + y * stride + x;
+    unsigned char *in_what = ref->buf[level] + y * stride + x;
+    unsigned int bestsad;
+    int br = 0, bc = 0;
+    int step, i;
+
+    bestsad = vfp->sdf(what, stride, in_what, stride, INT_MAX);
+
+    for (i = 0; i < pred_count; i++)
+    {
+        int r = pred[i].as_mv.row >> shift;
+        int c = pred[i].as_mv.col >> shift;
+        unsigned int thissad;
+
+        if (r < row_min || r > row_max || c < col_min || c > col_max)
+            continue;
+
+        thissad = vfp->sdf(what, stride, in_what + r * stride + c, stride,
+                           bestsad);
+
+        if (thissad < bestsad)
+        {
+            bestsad = thissad;
+            br = r;
+            bc = c;
+        }
+    }
+
+    // Three step search from the best predictor
+    for (step = 4; step > 0; step >>= 1)
+    {
+        int cr = br, cc = bc;
+
+        for (i = 0; i < 8; i++)
+        {
+            int r = cr + neighbors[i].row * step;
+            int c = cc + neighbors[i].col * step;
+            unsigned int thissad;
+
+            if (r < row_min || r > row_max || c < col_min || c > col_max)
+                continue;
+
+            thissad = vfp->sdf(what, stride, in_what + r * stride + c,
+                               stride, bestsad);
+
+            if (thissad < bestsad)
+            {
+                bestsad = thissad;
+                br = r;
+                bc = c;
+            }
+        }
+    }
+
+    /* Refining on the finer levels cost more than it gained, the full pel
+     * search around the seed does that anyway. */
+    mv->as_mv.row = br << shift;
+    mv->as_mv.col = bc << shift;
+}
+
+static void pyramid_search_rows(VP8_COMP *cpi, MACROBLOCK *x, int ithread,
+                                void *data)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int row_step = *(int *)data;
+    int mb_row, mb_col;
+
+    (void) x;
+
+    for (mb_row = ithread; mb_row < cm->mb_rows; mb_row += row_step)
+    {
+        int_mv *mv = cpi->pyramid_mv + mb_row * cm->mb_cols;
+
+        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+        {
+            int_mv pred[2];
+            int n = 0;
+
+            /* The co-located entry still holds the last frame's motion */
+            pred[n++].as_int = mv[mb_col].as_int;
+
+            if (mb_col > 0)
+                pred[n++].as_int = mv[mb_col - 1].as_int;
+
+            vp8_me_pyramid_search(&cpi->me_pyramid[0], &cpi->me_pyramid[1],
+                                  mb_row, mb_col, pred, n, &mv[mb_col],
+                                  cpi->fn_ptr);
+        }
+    }
+}
+
+void vp8_me_pyramid_frame(VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int row_step = 1;
+
+    vp8_me_pyramid_build(&cpi->me_pyramid[0], cpi->Source);
+    vp8_me_pyramid_build(&cpi->me_pyramid[1], &cm->yv12_fb[cm->lst_fb_idx]);
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+    {
+        row_step = cpi->encoding_thread_count + 1;
+        vp8cx_mt_run_job(cpi, pyramid_search_rows, &row_step);
+    }
+    else
+#endif
+        pyramid_search_rows(cpi, &cpi->mb, 0, &row_step);
+}
@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_MEPYRAMID_H
+#define __INC_MEPYRAMID_H
+
+#include "vpx_scale/yv12config.h"
+#include "vp8/common/mv.h"
+#include "variance.h"
+
+#define ME_PYRAMID_LEVELS 2
+
+/* Seeds from the pyramid are good to a few pixels, so the full pel search
+ * started from one can begin with a 4 pixel step. */
+#define ME_PYRAMID_STEP_PARAM 5
+
+/* The luma plane downsampled by 2 (level 0) and by 4 (level 1) in each
+ * direction. A 16x16 MB is an 8x8 block at level 0 and a 4x4 at level 1.
+ */
+typedef struct
+{
+    int width[ME_PYRAMID_LEVELS];
+    int height[ME_PYRAMID_LEVELS];
+    unsigned char *buf[ME_PYRAMID_LEVELS];
+} ME_PYRAMID;
+
+struct VP8_COMP;
+
+extern int vp8_me_pyramid_alloc(ME_PYRAMID *p, int width, int height);
+extern void vp8_me_pyramid_free(ME_PYRAMID *p);
+extern void vp8_me_pyramid_build(ME_PYRAMID *p, YV12_BUFFER_CONFIG *frame);
+
+/* Finds the full pel motion of MB (mb_row, mb_col) from src to ref on the
+ * coarsest level, to within a few pixels. The search starts from the best
+ * of zero and the full pel MVs in pred. */
+extern void vp8_me_pyramid_search(const ME_PYRAMID *src, const ME_PYRAMID *ref,
+                                  int mb_row, int mb_col,
+                                  const int_mv *pred, int pred_count,
+                                  int_mv *mv,
+                                  const vp8_variance_fn_ptr_t *fn_ptr);
+
+/* Fills cpi->pyramid_mv with the motion of every MB from the source to the
+ * last frame. */
+extern void vp8_me_pyramid_frame(struct VP8_COMP *cpi);
+
+#endif
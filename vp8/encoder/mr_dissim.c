@@ -50,6 +50,137 @@ if(x->mbmi.ref_frame !=INTRA_FRAME)   \
     cnt++;  \
 }
 
+/* Stores the mode info of one MB row for the next resolution up. The rows
+ * above and below it must be final too.
+ */
+static void cal_dissimilarity_row(VP8_COMP *cpi, int mb_row)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int mb_col;
+    /* Point to the row in the allocated MODE_INFO arrays, past its border. */
+    MODE_INFO *tmp = cm->mip + (mb_row + 1) * cm->mode_info_stride + 1;
+    LOWER_RES_INFO* store_mode_info = cpi->mr_mode_info + mb_row * cm->mb_cols;
+
+    for (mb_col = 0; mb_col < cm->mb_cols; mb_col ++)
+    {
+        int dissim = INT_MAX;
+
+        if(tmp->mbmi.ref_frame !=INTRA_FRAME)
+        {
+            int              mvx[8];
+            int              mvy[8];
+            int              mmvx;
+            int              mmvy;
+            int              cnt=0;
+            const MODE_INFO *here = tmp;
+            const MODE_INFO *above = here - cm->mode_info_stride;
+            const MODE_INFO *left = here - 1;
+            const MODE_INFO *aboveleft = above - 1;
+            const MODE_INFO *aboveright = NULL;
+            const MODE_INFO *right = NULL;
+            const MODE_INFO *belowleft = NULL;
+            const MODE_INFO *below = NULL;
+            const MODE_INFO *belowright = NULL;
+
+            /* If alternate reference frame is used, we have to
+             * check sign of MV. */
+            if(cpi->oxcf.play_alternate)
+            {
+                /* Gather mv of neighboring MBs */
+                GET_MV_SIGN(above)
+                GET_MV_SIGN(left)
+                GET_MV_SIGN(aboveleft)
+
+                if(mb_col < (cm->mb_cols-1))
+                {
+                    right = here + 1;
+                    aboveright = above + 1;
+                    GET_MV_SIGN(right)
+                    GET_MV_SIGN(aboveright)
+                }
+
+                if(mb_row < (cm->mb_rows-1))
+                {
+                    below = here + cm->mode_info_stride;
+                    belowleft = below - 1;
+                    GET_MV_SIGN(below)
+                    GET_MV_SIGN(belowleft)
+                }
+
+                if(mb_col < (cm->mb_cols-1)
+                    && mb_row < (cm->mb_rows-1))
+                {
+                    belowright = below + 1;
+                    GET_MV_SIGN(belowright)
+                }
+            }else
+            {
+                /* No alt_ref and gather mv of neighboring MBs */
+                GET_MV(above)
+                GET_MV(left)
+                GET_MV(aboveleft)
+
+                if(mb_col < (cm->mb_cols-1))
+                {
+                    right = here + 1;
+                    aboveright = above + 1;
+                    GET_MV(right)
+                    GET_MV(aboveright)
+                }
+
+                if(mb_row < (cm->mb_rows-1))
+                {
+                    below = here + cm->mode_info_stride;
+                    belowleft = below - 1;
+                    GET_MV(below)
+                    GET_MV(belowleft)
+                }
+
+                if(mb_col < (cm->mb_cols-1)
+                    && mb_row < (cm->mb_rows-1))
+                {
+                    belowright = below + 1;
+                    GET_MV(belowright)
+                }
+            }
+
+            if (cnt > 0)
+            {
+                int max_mvx = mvx[0];
+                int min_mvx = mvx[0];
+                int max_mvy = mvy[0];
+                int min_mvy = mvy[0];
+                int i;
+
+                if (cnt > 1)
+                {
+                    for (i=1; i< cnt; i++)
+                    {
+                        if (mvx[i] > max_mvx) max_mvx = mvx[i];
+                        else if (mvx[i] < min_mvx) min_mvx = mvx[i];
+                        if (mvy[i] > max_mvy) max_mvy = mvy[i];
+                        else if (mvy[i] < min_mvy) min_mvy = mvy[i];
+                    }
+                }
+
+                mmvx = MAX(abs(min_mvx - here->mbmi.mv.as_mv.row),
+                           abs(max_mvx - here->mbmi.mv.as_mv.row));
+                mmvy = MAX(abs(min_mvy - here->mbmi.mv.as_mv.col),
+                           abs(max_mvy - here->mbmi.mv.as_mv.col));
+                dissim = MAX(mmvx, mmvy);
+            }
+        }
+
+        /* Store mode info for next resolution encoding */
+        store_mode_info->mode = tmp->mbmi.mode;
+        store_mode_info->ref_frame = tmp->mbmi.ref_frame;
+        store_mode_info->mv.as_int = tmp->mbmi.mv.as_int;
+        store_mode_info->dissim = dissim;
+        tmp++;
+        store_mode_info++;
+    }
+}
+
 void vp8_cal_dissimilarity(VP8_COMP *cpi)
 {
     VP8_COMMON *cm = &cpi->common;
@@ -59,8 +190,7 @@ void vp8_cal_dissimilarity(VP8_COMP *cpi)
      * Their ref_frame = 0 means they won't be counted in the following
      * calculation.
      */
-    if (cpi->oxcf.mr_total_resolutions >1
-        && cpi->oxcf.mr_encoder_id < (cpi->oxcf.mr_total_resolutions - 1))
+    if (cpi->mr_mode_info)
     {
         /* Store info for show/no-show frames for supporting alt_ref.
          * If parent frame is alt_ref, child has one too.
@@ -68,134 +198,122 @@ void vp8_cal_dissimilarity(VP8_COMP *cpi)
         if(cm->frame_type != KEY_FRAME)
         {
             int mb_row;
-            int mb_col;
-            /* Point to beginning of allocated MODE_INFO arrays. */
-            MODE_INFO *tmp = cm->mip + cm->mode_info_stride;
-            LOWER_RES_INFO* store_mode_info
-                            = (LOWER_RES_INFO*)cpi->oxcf.mr_low_res_mode_info;
 
             for (mb_row = 0; mb_row < cm->mb_rows; mb_row ++)
-            {
-                tmp++;
-                for (mb_col = 0; mb_col < cm->mb_cols; mb_col ++)
-                {
-                    int dissim = INT_MAX;
+                cal_dissimilarity_row(cpi, mb_row);
+        }
+    }
+}
 
-                    if(tmp->mbmi.ref_frame !=INTRA_FRAME)
-                    {
-                        int              mvx[8];
-                        int              mvy[8];
-                        int              mmvx;
-                        int              mmvy;
-                        int              cnt=0;
-                        const MODE_INFO *here = tmp;
-                        const MODE_INFO *above = here - cm->mode_info_stride;
-                        const MODE_INFO *left = here - 1;
-                        const MODE_INFO *aboveleft = above - 1;
-                        const MODE_INFO *aboveright = NULL;
-                        const MODE_INFO *right = NULL;
-                        const MODE_INFO *belowleft = NULL;
-                        const MODE_INFO *below = NULL;
-                        const MODE_INFO *belowright = NULL;
-
-                        /* If alternate reference frame is used, we have to
-                         * check sign of MV. */
-                        if(cpi->oxcf.play_alternate)
-                        {
-                            /* Gather mv of neighboring MBs */
-                            GET_MV_SIGN(above)
-                            GET_MV_SIGN(left)
-                            GET_MV_SIGN(aboveleft)
-
-                            if(mb_col < (cm->mb_cols-1))
-                            {
-                                right = here + 1;
-                                aboveright = above + 1;
-                                GET_MV_SIGN(right)
-                                GET_MV_SIGN(aboveright)
-                            }
-
-                            if(mb_row < (cm->mb_rows-1))
-                            {
-                                below = here + cm->mode_info_stride;
-                                belowleft = below - 1;
-                                GET_MV_SIGN(below)
-                                GET_MV_SIGN(belowleft)
-                            }
-
-                            if(mb_col < (cm->mb_cols-1)
-                                && mb_row < (cm->mb_rows-1))
-                            {
-                                belowright = below + 1;
-                                GET_MV_SIGN(belowright)
-                            }
-                        }else
-                        {
-                            /* No alt_ref and gather mv of neighboring MBs */
-                            GET_MV(above)
-                            GET_MV(left)
-                            GET_MV(aboveleft)
-
-                            if(mb_col < (cm->mb_cols-1))
-                            {
-                                right = here + 1;
-                                aboveright = above + 1;
-                                GET_MV(right)
-                                GET_MV(aboveright)
-                            }
-
-                            if(mb_row < (cm->mb_rows-1))
-                            {
-                                below = here + cm->mode_info_stride;
-                                belowleft = below - 1;
-                                GET_MV(below)
-                                GET_MV(belowleft)
-                            }
-
-                            if(mb_col < (cm->mb_cols-1)
-                                && mb_row < (cm->mb_rows-1))
-                            {
-                                belowright = below + 1;
-                                GET_MV(belowright)
-                            }
-                        }
-
-                        if (cnt > 0)
-                        {
-                            int max_mvx = mvx[0];
-                            int min_mvx = mvx[0];
-                            int max_mvy = mvy[0];
-                            int min_mvy = mvy[0];
-                            int i;
-
-                            if (cnt > 1)
-                            {
-                                for (i=1; i< cnt; i++)
-                                {
-                                    if (mvx[i] > max_mvx) max_mvx = mvx[i];
-                                    else if (mvx[i] < min_mvx) min_mvx = mvx[i];
-                                    if (mvy[i] > max_mvy) max_mvy = mvy[i];
-                                    else if (mvy[i] < min_mvy) min_mvy = mvy[i];
-                                }
-                            }
-
-                            mmvx = MAX(abs(min_mvx - here->mbmi.mv.as_mv.row),
-                                       abs(max_mvx - here->mbmi.mv.as_mv.row));
-                            mmvy = MAX(abs(min_mvy - here->mbmi.mv.as_mv.col),
-                                       abs(max_mvy - here->mbmi.mv.as_mv.col));
-                            dissim = MAX(mmvx, mmvy);
-                        }
-                    }
+void vp8_mr_alloc_mode_info(VP8_COMP *cpi)
+{
+    MR_SHARED_INFO *shared = (MR_SHARED_INFO *)cpi->oxcf.mr_low_res_mode_info;
 
-                    /* Store mode info for next resolution encoding */
-                    store_mode_info->mode = tmp->mbmi.mode;
-                    store_mode_info->ref_frame = tmp->mbmi.ref_frame;
-                    store_mode_info->mv.as_int = tmp->mbmi.mv.as_int;
-                    store_mode_info->dissim = dissim;
-                    tmp++;
-                    store_mode_info++;
-                }
-            }
+    if (cpi->oxcf.mr_total_resolutions > 1)
+    {
+        shared->cpi[cpi->oxcf.mr_encoder_id] = cpi;
+        shared->num_encoders++;
+
+        /* The highest resolution has nobody to store mode info for */
+        if (cpi->oxcf.mr_encoder_id < (cpi->oxcf.mr_total_resolutions - 1))
+            CHECK_MEM_ERROR(cpi->mr_mode_info,
+                            vpx_calloc(cpi->common.MBs, sizeof(LOWER_RES_INFO)));
+    }
+}
+
+void vp8_mr_start_frame(VP8_COMP *cpi)
+{
+    int frame = cpi->mr_frame + 1;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->oxcf.mr_pipeline && cpi->mr_mode_info)
+    {
+        MR_SHARED_INFO *shared = (MR_SHARED_INFO *)cpi->oxcf.mr_low_res_mode_info;
+        int *child_frames_done =
+            &shared->cpi[cpi->oxcf.mr_encoder_id + 1]->mr_frames_done;
+
+        /* Don't overwrite mode info the next resolution up is still reading */
+        while (sync_fetch_and_add(child_frames_done, 0) < frame - 1)
+        {
+            x86_pause_hint();
+            thread_sleep(0);
         }
+
+        cpi->mr_row_publish = !cpi->sf.recode_loop && cpi->pass != 1;
+    }
+
+    /* The next resolution up checks mr_frame before mr_rows_ready, so the
+     * rows of the last frame have to be gone before the frame moves on.
+     * The atomics are full barriers.
+     */
+    sync_fetch_and_add(&cpi->mr_rows_ready, -cpi->mr_rows_ready);
+    sync_fetch_and_add(&cpi->mr_frame, 1);
+#else
+    cpi->mr_rows_ready = 0;
+    cpi->mr_frame = frame;
+#endif
+}
+
+void vp8_mr_end_frame(VP8_COMP *cpi)
+{
+    cpi->mr_row_publish = 0;
+#if CONFIG_MULTITHREAD
+    sync_fetch_and_add(&cpi->mr_rows_ready,
+                       cpi->common.mb_rows - cpi->mr_rows_ready);
+    sync_fetch_and_add(&cpi->mr_frames_done,
+                       cpi->mr_frame - cpi->mr_frames_done);
+#else
+    cpi->mr_rows_ready = cpi->common.mb_rows;
+    cpi->mr_frames_done = cpi->mr_frame;
+#endif
+}
+
+#if CONFIG_MULTITHREAD
+void vp8_mr_publish_rows(VP8_COMP *cpi, int rows_done)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int mb_row;
+
+    /* Whoever holds the lock publishes the rows we'd have */
+    if (!sync_bool_compare_and_swap(&cpi->mr_publish_lock, 0, 1))
+        return;
+
+    if (cpi->b_multi_threaded)
+    {
+        volatile const int *mb_col = cpi->mt_current_mb_col;
+
+        while (rows_done < cm->mb_rows && mb_col[rows_done] >= cm->mb_cols - 1)
+            rows_done++;
+    }
+
+    /* A row's dissimilarity looks at the row below it */
+    for (mb_row = cpi->mr_rows_ready;
+         mb_row < rows_done - 1 || (mb_row < rows_done && rows_done == cm->mb_rows);
+         mb_row++)
+    {
+        if (cm->frame_type != KEY_FRAME)
+            cal_dissimilarity_row(cpi, mb_row);
+
+        /* Takes mr_rows_ready to mb_row + 1 after the row's mode info */
+        sync_fetch_and_add(&cpi->mr_rows_ready, 1);
+    }
+
+    sync_fetch_and_add(&cpi->mr_publish_lock, -1);
+}
+
+void vp8_mr_wait_for_parent_row(VP8_COMP *cpi, VP8_COMP *parent, int mb_row)
+{
+    if (mb_row > parent->common.mb_rows - 1)
+        mb_row = parent->common.mb_rows - 1;
+
+    /* Atomic reads, so that the rows are read after mr_frame and the mode
+     * info after the rows
+     */
+    while (sync_fetch_and_add(&parent->mr_frame, 0) < cpi->mr_frame ||
+           sync_fetch_and_add(&parent->mr_rows_ready, 0) <= mb_row)
+    {
+        x86_pause_hint();
+        thread_sleep(0);
     }
 }
+#endif
@@ -15,5 +15,13 @@
 
 extern void vp8_cal_low_res_mb_cols(VP8_COMP *cpi);
 extern void vp8_cal_dissimilarity(VP8_COMP *cpi);
+extern void vp8_mr_alloc_mode_info(VP8_COMP *cpi);
+extern void vp8_mr_start_frame(VP8_COMP *cpi);
+extern void vp8_mr_end_frame(VP8_COMP *cpi);
+#if CONFIG_MULTITHREAD
+extern void vp8_mr_publish_rows(VP8_COMP *cpi, int rows_done);
+extern void vp8_mr_wait_for_parent_row(VP8_COMP *cpi, VP8_COMP *parent,
+                                       int mb_row);
+#endif
 
 #endif
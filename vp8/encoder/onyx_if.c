@@ -45,6 +45,14 @@
 extern void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi);
 extern void vp8cx_set_alt_lf_level(VP8_COMP *cpi, int filt_val);
 extern void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi);
+#if CONFIG_MULTITHREAD
+extern void vp8cx_pick_filter_level_estimate(VP8_COMP *cpi);
+extern void vp8cx_save_filter_search_rows(VP8_COMP *cpi, int mb_row);
+extern void vp8cx_pick_next_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi);
+extern void vp8cx_alloc_partition_bufs(VP8_COMP *cpi, unsigned int buf_sz,
+                                       int num_bufs);
+extern void vp8cx_pick_coef_probs_row_sync(VP8_COMP *cpi);
+#endif
 
 extern void vp8_deblock_frame(YV12_BUFFER_CONFIG *source, YV12_BUFFER_CONFIG *post, int filt_lvl, int low_var_thresh, int flag);
 extern void print_parms(VP8_CONFIG *ocf, char *filenam);
@@ -52,6 +60,9 @@ extern unsigned int vp8_get_processor_freq();
 extern void print_tree_update_probs();
 extern void vp8cx_create_encoder_threads(VP8_COMP *cpi);
 extern void vp8cx_remove_encoder_threads(VP8_COMP *cpi);
+extern void vp8cx_remove_async_thread(VP8_COMP *cpi);
+extern void vp8cx_start_lpf_thread(VP8_COMP *cpi);
+extern void vp8cx_wait_lpf_thread(VP8_COMP *cpi);
 #if HAVE_NEON
 extern void vp8_yv12_copy_frame_func_neon(YV12_BUFFER_CONFIG *src_ybc, YV12_BUFFER_CONFIG *dst_ybc);
 extern void vp8_yv12_copy_src_frame_func_neon(YV12_BUFFER_CONFIG *src_ybc, YV12_BUFFER_CONFIG *dst_ybc);
@@ -328,6 +339,9 @@ static void dealloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->tplist);
     cpi->tplist = NULL;
 
+    vpx_free(cpi->twopass.row_stats);
+    cpi->twopass.row_stats = NULL;
+
     // Delete last frame MV storage buffers
     vpx_free(cpi->lfmv);
     cpi->lfmv = 0;
@@ -345,9 +359,15 @@ static void dealloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->active_map);
     cpi->active_map = 0;
 
+    vpx_free(cpi->active_map_still);
+    cpi->active_map_still = 0;
+
     vp8_de_alloc_frame_buffers(&cpi->common);
 
     vp8_yv12_de_alloc_frame_buffer(&cpi->pick_lf_lvl_frame);
+#if CONFIG_MULTITHREAD
+    vp8_yv12_de_alloc_frame_buffer(&cpi->pick_lf_lvl_frame_mt);
+#endif
     vp8_yv12_de_alloc_frame_buffer(&cpi->scaled_source);
 #if VP8_TEMPORAL_ALT_REF
     vp8_yv12_de_alloc_frame_buffer(&cpi->alt_ref_buffer);
@@ -367,6 +387,24 @@ static void dealloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->mb_norm_activity_map);
     cpi->mb_norm_activity_map = 0;
 
+    vpx_free(cpi->epzs_sad);
+    cpi->epzs_sad = 0;
+
+    vp8_me_pyramid_free(&cpi->me_pyramid[0]);
+    vp8_me_pyramid_free(&cpi->me_pyramid[1]);
+    vpx_free(cpi->pyramid_mv);
+    cpi->pyramid_mv = 0;
+
+    vpx_free(cpi->recode_mv);
+    cpi->recode_mv = 0;
+
+    vpx_free(cpi->mb_hints);
+    cpi->mb_hints = 0;
+
+    vp8_halfpel_free(cpi);
+    vp8_block_sums_free(cpi);
+    vp8_hash_me_free(cpi);
+
     vpx_free(cpi->mb.pip);
     cpi->mb.pip = 0;
 }
@@ -704,6 +742,10 @@ void vp8_set_speed_features(VP8_COMP *cpi)
     sf->first_step = 0;
     sf->max_step_search_steps = MAX_MVSEARCH_STEPS;
     sf->improved_mv_pred = 1;
+    sf->me_pyramid = 0;
+    sf->recode_mv_reuse = 0;
+    sf->early_skip = 0;
+    sf->satd_pick = 0;
 
     // default thresholds to 0
     for (i = 0; i < MAX_MODES; i++)
@@ -793,6 +835,8 @@ void vp8_set_speed_features(VP8_COMP *cpi)
         break;
     case 1:
     case 3:
+        sf->recode_mv_reuse = 1;
+
         if (Speed > 0)
         {
             /* Disable coefficient optimization above speed 0 */
@@ -835,6 +879,8 @@ void vp8_set_speed_features(VP8_COMP *cpi)
         sf->auto_filter = 1;
         sf->iterative_sub_pixel = 1;
         sf->search_method = NSTEP;
+        sf->me_pyramid = 1;
+        sf->early_skip = 1;
 
         if (Speed > 0)
         {
@@ -853,12 +899,15 @@ void vp8_set_speed_features(VP8_COMP *cpi)
         {
             sf->RD = 0;
             sf->auto_filter = 1;
+            sf->satd_pick = 1;                       // Rank intra modes by SATD
         }
 
         if (Speed > 4)
         {
             sf->auto_filter = 0;                     // Faster selection of loop filter
-            sf->search_method = HEX;
+            sf->satd_pick = 0;                       // Loses with the fast filter pick
+            sf->search_method = EPZS;
+            sf->me_pyramid = 0;               // EPZS predicts well enough
             sf->iterative_sub_pixel = 0;
         }
 
@@ -1087,6 +1136,13 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
         vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
                            "Failed to allocate last frame buffer");
 
+#if CONFIG_MULTITHREAD
+    if (vp8_yv12_alloc_frame_buffer(&cpi->pick_lf_lvl_frame_mt,
+                                    width, height, VP8BORDERINPIXELS))
+        vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate loop filter search buffer");
+#endif
+
     if (vp8_yv12_alloc_frame_buffer(&cpi->scaled_source,
                                     width, height, VP8BORDERINPIXELS))
         vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
@@ -1123,6 +1179,37 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
                     vpx_calloc(sizeof(unsigned int),
                     cm->mb_rows * cm->mb_cols));
 
+    vpx_free(cpi->epzs_sad);
+    CHECK_MEM_ERROR(cpi->epzs_sad,
+                    vpx_calloc(sizeof(unsigned int),
+                    cm->mb_rows * cm->mb_cols));
+
+    if (vp8_me_pyramid_alloc(&cpi->me_pyramid[0], width, height) ||
+        vp8_me_pyramid_alloc(&cpi->me_pyramid[1], width, height))
+        vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate ME pyramid");
+
+    vpx_free(cpi->pyramid_mv);
+    CHECK_MEM_ERROR(cpi->pyramid_mv,
+                    vpx_calloc(sizeof(int_mv), cm->mb_rows * cm->mb_cols));
+
+    vpx_free(cpi->recode_mv);
+    CHECK_MEM_ERROR(cpi->recode_mv,
+                    vpx_calloc(sizeof(int_mv),
+                    cm->mb_rows * cm->mb_cols * MAX_REF_FRAMES));
+
+    vpx_free(cpi->mb_hints);
+    CHECK_MEM_ERROR(cpi->mb_hints,
+                    vpx_calloc(sizeof(MB_HINT), cm->mb_rows * cm->mb_cols));
+    cpi->mb_hints_valid = 0;
+
+    // The frame buffers were reallocated
+    vp8_halfpel_free(cpi);
+    vp8_halfpel_alloc(cpi);
+    vp8_block_sums_free(cpi);
+    vp8_block_sums_alloc(cpi);
+    vp8_hash_me_alloc(cpi);
+
 #if CONFIG_MULTITHREAD
     if (width < 640)
         cpi->mt_sync_range = 1;
@@ -1137,6 +1224,10 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
     vpx_free(cpi->tplist);
 
     CHECK_MEM_ERROR(cpi->tplist, vpx_malloc(sizeof(TOKENLIST) * cpi->common.mb_rows));
+
+    vpx_free(cpi->twopass.row_stats);
+    CHECK_MEM_ERROR(cpi->twopass.row_stats,
+                    vpx_calloc(sizeof(FIRSTPASS_ROW_STATS), cm->mb_rows));
 }
 
 
@@ -1400,6 +1491,18 @@ void vp8_change_config(VP8_COMP *cpi, VP8_CONFIG *oxcf)
         vp8_setup_version(cm);
     }
 
+    // The automatic active map replaced any map the application set, so
+    // turning it off leaves every MB active.
+    if (cpi->oxcf.auto_active_map && !oxcf->auto_active_map &&
+        cpi->active_map)
+    {
+        int mbs = cm->mb_rows * cm->mb_cols;
+
+        vpx_memset(cpi->active_map, 1, mbs);
+        vpx_memset(cpi->active_map_still, 0, mbs);
+        cpi->active_map_enabled = 0;
+    }
+
     cpi->oxcf = *oxcf;
 
     switch (cpi->oxcf.Mode)
@@ -1600,6 +1703,16 @@ void vp8_change_config(VP8_COMP *cpi, VP8_CONFIG *oxcf)
     cm->horiz_scale  = cpi->horiz_scale;
     cm->vert_scale   = cpi->vert_scale;
 
+#if CONFIG_SPATIAL_RESAMPLING
+    // The first pass can run on a half size source, vp8_first_pass()
+    // scales its stats back to full size.
+    if (cpi->pass == 1 && cpi->oxcf.first_pass_downscale)
+    {
+        cm->horiz_scale = ONETWO;
+        cm->vert_scale  = ONETWO;
+    }
+#endif
+
     // VP8 sharpness level mapping 0-7 (vs 0-10 in general VPx dialogs)
     if (cpi->oxcf.Sharpness > 7)
         cpi->oxcf.Sharpness = 7;
@@ -1628,6 +1741,12 @@ void vp8_change_config(VP8_COMP *cpi, VP8_CONFIG *oxcf)
         alloc_raw_frame_buffers(cpi);
         vp8_alloc_compressor_data(cpi);
     }
+    else
+    {
+        vp8_halfpel_alloc(cpi);
+        vp8_block_sums_alloc(cpi);
+        vp8_hash_me_alloc(cpi);
+    }
 
     if (cpi->oxcf.fixed_q >= 0)
     {
@@ -1748,6 +1867,7 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     CHECK_MEM_ERROR(cpi->active_map, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
     vpx_memset(cpi->active_map , 1, (cpi->common.mb_rows * cpi->common.mb_cols));
     cpi->active_map_enabled = 0;
+    CHECK_MEM_ERROR(cpi->active_map_still, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
 
 #if 0
     // Experimental code for lagged and one pass
@@ -1937,6 +2057,8 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->fn_ptr[BLOCK_16X16].sdx3f          = vp8_sad16x16x3;
     cpi->fn_ptr[BLOCK_16X16].sdx8f          = vp8_sad16x16x8;
     cpi->fn_ptr[BLOCK_16X16].sdx4df         = vp8_sad16x16x4d;
+    cpi->fn_ptr[BLOCK_16X16].width          = 16;
+    cpi->fn_ptr[BLOCK_16X16].height         = 16;
 
     cpi->fn_ptr[BLOCK_16X8].sdf            = vp8_sad16x8;
     cpi->fn_ptr[BLOCK_16X8].vf             = vp8_variance16x8;
@@ -1947,6 +2069,8 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->fn_ptr[BLOCK_16X8].sdx3f          = vp8_sad16x8x3;
     cpi->fn_ptr[BLOCK_16X8].sdx8f          = vp8_sad16x8x8;
     cpi->fn_ptr[BLOCK_16X8].sdx4df         = vp8_sad16x8x4d;
+    cpi->fn_ptr[BLOCK_16X8].width          = 16;
+    cpi->fn_ptr[BLOCK_16X8].height         = 8;
 
     cpi->fn_ptr[BLOCK_8X16].sdf            = vp8_sad8x16;
     cpi->fn_ptr[BLOCK_8X16].vf             = vp8_variance8x16;
@@ -1957,6 +2081,8 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->fn_ptr[BLOCK_8X16].sdx3f          = vp8_sad8x16x3;
     cpi->fn_ptr[BLOCK_8X16].sdx8f          = vp8_sad8x16x8;
     cpi->fn_ptr[BLOCK_8X16].sdx4df         = vp8_sad8x16x4d;
+    cpi->fn_ptr[BLOCK_8X16].width          = 8;
+    cpi->fn_ptr[BLOCK_8X16].height         = 16;
 
     cpi->fn_ptr[BLOCK_8X8].sdf            = vp8_sad8x8;
     cpi->fn_ptr[BLOCK_8X8].vf             = vp8_variance8x8;
@@ -1967,6 +2093,8 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->fn_ptr[BLOCK_8X8].sdx3f          = vp8_sad8x8x3;
     cpi->fn_ptr[BLOCK_8X8].sdx8f          = vp8_sad8x8x8;
     cpi->fn_ptr[BLOCK_8X8].sdx4df         = vp8_sad8x8x4d;
+    cpi->fn_ptr[BLOCK_8X8].width          = 8;
+    cpi->fn_ptr[BLOCK_8X8].height         = 8;
 
     cpi->fn_ptr[BLOCK_4X4].sdf            = vp8_sad4x4;
     cpi->fn_ptr[BLOCK_4X4].vf             = vp8_variance4x4;
@@ -1977,6 +2105,8 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->fn_ptr[BLOCK_4X4].sdx3f          = vp8_sad4x4x3;
     cpi->fn_ptr[BLOCK_4X4].sdx8f          = vp8_sad4x4x8;
     cpi->fn_ptr[BLOCK_4X4].sdx4df         = vp8_sad4x4x4d;
+    cpi->fn_ptr[BLOCK_4X4].width          = 4;
+    cpi->fn_ptr[BLOCK_4X4].height         = 4;
 
 #if ARCH_X86 || ARCH_X86_64
     cpi->fn_ptr[BLOCK_16X16].copymem      = vp8_copy32xn;
@@ -1999,14 +2129,16 @@ struct VP8_COMP* vp8_create_compressor(VP8_CONFIG *oxcf)
 
     vp8_loop_filter_init(cm);
 
-    cpi->common.error.setjmp = 0;
-
 #if CONFIG_MULTI_RES_ENCODING
     /* Calculate # of MBs in a row in lower-resolution level image. */
     if (cpi->oxcf.mr_encoder_id > 0)
         vp8_cal_low_res_mb_cols(cpi);
+
+    vp8_mr_alloc_mode_info(cpi);
 #endif
 
+    cpi->common.error.setjmp = 0;
+
     return  cpi;
 
 }
@@ -2281,10 +2413,14 @@ void vp8_remove_compressor(VP8_COMP **ptr)
     }
 
 #if CONFIG_MULTITHREAD
+    vp8cx_remove_async_thread(cpi);
     vp8cx_remove_encoder_threads(cpi);
 #endif
 
     dealloc_compressor_data(cpi);
+#if CONFIG_MULTI_RES_ENCODING
+    vpx_free(cpi->mr_mode_info);
+#endif
     vpx_free(cpi->mb.ss);
     vpx_free(cpi->tok);
     vpx_free(cpi->cyclic_refresh_map);
@@ -2484,6 +2620,11 @@ int vp8_set_reference(VP8_COMP *cpi, VP8_REFFRAME ref_frame_flag, YV12_BUFFER_CO
         return -1;
 
     vp8_yv12_copy_frame_ptr(sd, &cm->yv12_fb[ref_fb_idx]);
+    vp8_halfpel_invalidate(cpi, ref_fb_idx);
+    vp8_block_sums_invalidate(cpi, ref_fb_idx);
+
+    if (ref_fb_idx == cm->lst_fb_idx)
+        cpi->hash_me.valid = 0;
 
     return 0;
 }
@@ -3068,8 +3209,61 @@ void update_reference_frames(VP8_COMMON *cm)
     }
 }
 
+#if CONFIG_MULTITHREAD
+// Filters the frame one MB row at a time. With threads, this starts along
+// with the MB row encoding and each row is filtered as soon as the row below
+// it is encoded, since filtering changes the pixels that row is intra
+// predicted from. The level was set by vp8cx_pick_filter_level_estimate().
+static void loopfilter_frame_rows(VP8_COMP *cpi, VP8_COMMON *cm)
+{
+    int mb_row;
+
+    if (cpi->b_multi_threaded)
+        sem_post(&cpi->h_event_end_lpf); /* filter_level is already set */
+
+    if (cm->filter_level > 0)
+    {
+        vp8cx_set_alt_lf_level(cpi, cm->filter_level);
+        vp8_loop_filter_frame_init(cm, &cpi->mb.e_mbd, cm->filter_level);
+    }
+
+    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    {
+        if (cpi->b_multi_threaded)
+        {
+            int next_row = (mb_row + 1 < cm->mb_rows) ? mb_row + 1 : mb_row;
+            volatile const int *next_row_mb_col = &cpi->mt_current_mb_col[next_row];
+
+            while (*next_row_mb_col != cm->mb_cols - 1)
+            {
+                x86_pause_hint();
+                thread_sleep(0);
+            }
+        }
+
+        vp8cx_save_filter_search_rows(cpi, mb_row);
+
+        if (cm->filter_level > 0)
+            vp8_loop_filter_rows(cm, mb_row, mb_row + 1);
+    }
+
+    // Pick the level for the next frame from the rows saved above
+    vp8cx_pick_next_filter_level(cpi->Source, cpi);
+
+    vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+}
+#endif
+
 void loopfilter_frame(VP8_COMP *cpi, VP8_COMMON *cm)
 {
+#if CONFIG_MULTITHREAD
+    if (cpi->lf_row_sync)
+    {
+        loopfilter_frame_rows(cpi, cm);
+        return;
+    }
+#endif
+
     if (cm->no_lpf)
     {
         cm->filter_level = 0;
@@ -3092,6 +3286,8 @@ void loopfilter_frame(VP8_COMP *cpi, VP8_COMMON *cm)
     }
 
 #if CONFIG_MULTITHREAD
+    cpi->next_filter_level = cm->filter_level;
+
     if (cpi->b_multi_threaded)
         sem_post(&cpi->h_event_end_lpf); /* signal that we have set filter_level */
 #endif
@@ -3159,6 +3355,26 @@ static void encode_frame_to_data_rate
         cpi->force_next_frame_intra = 0;
     }
 
+#if CONFIG_MULTITHREAD
+    // Realtime frames are never recoded, so the loop filter can run along
+    // with the one and only encode of the frame.
+    cpi->lf_row_sync = cpi->oxcf.lf_row_sync && !cm->no_lpf &&
+                       cpi->compressor_speed == 2 && cpi->sf.recode_loop == 0;
+
+    if (cpi->lf_row_sync)
+        cm->frame_to_show = &cm->yv12_fb[cm->new_fb_idx];
+
+    // The tokens can be packed along with the MB rows once the coefficient
+    // probabilities are known up front, see vp8cx_pick_coef_probs_row_sync().
+    // This doesn't depend on the thread count so the output doesn't either.
+    cpi->token_row_sync = cpi->oxcf.token_row_sync &&
+                          cpi->compressor_speed == 2 && cpi->sf.recode_loop == 0;
+
+    if (cpi->token_row_sync && cpi->b_multi_threaded)
+        vp8cx_alloc_partition_bufs(cpi, dest_end - dest,
+                                   1 << cm->multi_token_partition);
+#endif
+
     // For an alt ref frame in 2 pass we skip the call to the second pass function that sets the target bandwidth
 #if !(CONFIG_REALTIME_ONLY)
 
@@ -3618,6 +3834,17 @@ static void encode_frame_to_data_rate
     vp8_write_yuv_frame(cpi->Source);
 #endif
 
+    if (cpi->sf.recode_mv_reuse && cpi->sf.recode_loop && cpi->sf.RD &&
+        cm->frame_type != KEY_FRAME)
+    {
+        int i;
+
+        for (i = 0; i < cm->mb_rows * cm->mb_cols * MAX_REF_FRAMES; i++)
+            cpi->recode_mv[i].as_int = RECODE_MV_NONE;
+
+        cpi->recode_mv_state = RECODE_MV_RECORD;
+    }
+
     do
     {
         vp8_clear_system_state();  //__asm emms;
@@ -3704,9 +3931,20 @@ static void encode_frame_to_data_rate
             vp8_setup_key_frame(cpi);
         }
 
+#if CONFIG_MULTITHREAD
+        if (cpi->lf_row_sync)
+            vp8cx_pick_filter_level_estimate(cpi);
+
+        if (cpi->token_row_sync)
+            vp8cx_pick_coef_probs_row_sync(cpi);
+#endif
+
         // transform / motion compensation build reconstruction frame
         vp8_encode_frame(cpi);
 
+        if (cpi->recode_mv_state == RECODE_MV_RECORD)
+            cpi->recode_mv_state = RECODE_MV_REUSE;
+
         cpi->projected_frame_size -= vp8_estimate_entropy_savings(cpi);
         cpi->projected_frame_size = (cpi->projected_frame_size > 0) ? cpi->projected_frame_size : 0;
 
@@ -3964,6 +4202,8 @@ static void encode_frame_to_data_rate
     }
     while (Loop == 1);
 
+    cpi->recode_mv_state = RECODE_MV_OFF;
+
 #if 0
     // Experimental code for lagged and one pass
     // Update stats used for one pass GF selection
@@ -4028,7 +4268,9 @@ static void encode_frame_to_data_rate
     }
 
 #if CONFIG_MULTI_RES_ENCODING
-    vp8_cal_dissimilarity(cpi);
+    /* Otherwise the rows were stored as they were encoded */
+    if (!cpi->mr_row_publish)
+        vp8_cal_dissimilarity(cpi);
 #endif
 
     // Update the GF useage maps.
@@ -4056,16 +4298,21 @@ static void encode_frame_to_data_rate
     else
         cm->copy_buffer_to_arf  = 0;
 
-    cm->frame_to_show = &cm->yv12_fb[cm->new_fb_idx];
-
 #if CONFIG_MULTITHREAD
-    if (cpi->b_multi_threaded)
+    if (cpi->b_multi_threaded && cpi->lf_row_sync)
+    {
+        /* loopfilter thread was started with the MB rows, see
+         * vp8cx_encode_frame() */
+    }
+    else if (cpi->b_multi_threaded)
     {
-        sem_post(&cpi->h_event_start_lpf); /* start loopfilter in separate thread */
+        cm->frame_to_show = &cm->yv12_fb[cm->new_fb_idx];
+        vp8cx_start_lpf_thread(cpi); /* start loopfilter in separate thread */
     }
     else
 #endif
     {
+        cm->frame_to_show = &cm->yv12_fb[cm->new_fb_idx];
         loopfilter_frame(cpi, cm);
     }
 
@@ -4079,7 +4326,7 @@ static void encode_frame_to_data_rate
 #if CONFIG_MULTITHREAD
     /* wait that filter_level is picked so that we can continue with stream packing */
     if (cpi->b_multi_threaded)
-        sem_wait(&cpi->h_event_end_lpf);
+        vp8cx_wait_lpf_thread(cpi);
 #endif
 
     // build the bitstream
@@ -4089,10 +4336,14 @@ static void encode_frame_to_data_rate
     /* wait for loopfilter thread done */
     if (cpi->b_multi_threaded)
     {
-        sem_wait(&cpi->h_event_end_lpf);
+        vp8cx_wait_lpf_thread(cpi);
     }
 #endif
 
+    // The next frames search the source of the new last frame by hash
+    if (cpi->hash_me.table[0] && cm->refresh_last_frame)
+        vp8_hash_me_build(cpi, cpi->Source);
+
     /* Move storing frame_type out of the above loop since it is also
      * needed in motion search besides loopfilter */
     cm->last_frame_type = cm->frame_type;
@@ -4531,6 +4782,46 @@ extern void vp8_pop_neon(int64_t *store);
 #endif
 
 
+// An MB still for this many frames in a row becomes inactive
+#define AUTO_ACTIVE_MAP_HOLD 3
+
+// Frames between those with every MB active
+#define AUTO_ACTIVE_MAP_REFRESH 60
+
+/* Derives the active map of the frame about to be pushed from how long its
+ * MBs have been still. Only the changing parts of surveillance or screen
+ * content are then copied and coded. Every MB is active in forced key frames
+ * (the only flag frame_flags carries) and every AUTO_ACTIVE_MAP_REFRESH
+ * frames, so that changes kept under the threshold get coded too, and the
+ * MBs have to be still again for AUTO_ACTIVE_MAP_HOLD frames after a key
+ * frame.
+ */
+static void update_auto_active_map(VP8_COMP *cpi, YV12_BUFFER_CONFIG *sd,
+                                   unsigned int frame_flags)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int mbs = cm->mb_rows * cm->mb_cols;
+    int refresh = frame_flags ||
+                  !(cm->current_video_frame % AUTO_ACTIVE_MAP_REFRESH);
+    int i;
+
+    if (cm->frame_type == KEY_FRAME)
+        vpx_memset(cpi->active_map_still, 0, mbs);
+
+    if (vp8_lookahead_still_mbs(cpi->lookahead, sd,
+                                cpi->fn_ptr[BLOCK_16X16].sdf,
+                                cpi->oxcf.auto_active_map << 8,
+                                cpi->active_map_still))
+        refresh = 1;
+
+    for (i = 0; i < mbs; i++)
+        cpi->active_map[i] = refresh ||
+                             cpi->active_map_still[i] < AUTO_ACTIVE_MAP_HOLD;
+
+    cpi->active_map_enabled = 1;
+}
+
+
 int vp8_receive_raw_frame(VP8_COMP *cpi, unsigned int frame_flags, YV12_BUFFER_CONFIG *sd, int64_t time_stamp, int64_t end_time)
 {
 #if HAVE_NEON
@@ -4550,6 +4841,8 @@ int vp8_receive_raw_frame(VP8_COMP *cpi, unsigned int frame_flags, YV12_BUFFER_C
 #endif
 
     vpx_usec_timer_start(&timer);
+    if (cpi->oxcf.auto_active_map)
+        update_auto_active_map(cpi, sd, frame_flags);
     if(vp8_lookahead_push(cpi->lookahead, sd, time_stamp, end_time,
                           frame_flags, cpi->active_map_enabled ? cpi->active_map : NULL))
         res = -1;
@@ -4603,6 +4896,10 @@ int vp8_get_compressed_data(VP8_COMP *cpi, unsigned int *frame_flags, unsigned l
     if (setjmp(cpi->common.error.jmp))
     {
         cpi->common.error.setjmp = 0;
+#if CONFIG_MULTI_RES_ENCODING
+        /* don't keep the next resolution up waiting for this frame */
+        vp8_mr_end_frame(cpi);
+#endif
         return VPX_CODEC_CORRUPT_FRAME;
     }
 
@@ -4825,6 +5122,9 @@ int vp8_get_compressed_data(VP8_COMP *cpi, unsigned int *frame_flags, unsigned l
 
         assert(i < NUM_YV12_BUFFERS );
     }
+#if CONFIG_MULTI_RES_ENCODING
+    vp8_mr_start_frame(cpi);
+#endif
 #if !(CONFIG_REALTIME_ONLY)
 
     if (cpi->pass == 1)
@@ -4839,6 +5139,13 @@ int vp8_get_compressed_data(VP8_COMP *cpi, unsigned int *frame_flags, unsigned l
 #endif
         encode_frame_to_data_rate(cpi, size, dest, dest_end, frame_flags);
 
+#if CONFIG_MULTI_RES_ENCODING
+    vp8_mr_end_frame(cpi);
+#endif
+
+    // The hints were for this frame only
+    cpi->mb_hints_valid = 0;
+
     if (cpi->compressor_speed == 2)
     {
         unsigned int duration, duration2;
@@ -5215,6 +5522,11 @@ int vp8_calc_ss_err(YV12_BUFFER_CONFIG *source, YV12_BUFFER_CONFIG *dest)
 }
 
 
+int vp8_get_halfpel_planes_kb(VP8_COMP *cpi)
+{
+    return (cpi->halfpel_sets * 3 * cpi->halfpel_size + 1023) >> 10;
+}
+
 int vp8_get_quantizer(VP8_COMP *cpi)
 {
     return cpi->common.base_qindex;
@@ -28,6 +28,11 @@
 #include "mcomp.h"
 #include "vp8/common/findnearmv.h"
 #include "lookahead.h"
+#include "mepyramid.h"
+#include "halfpel.h"
+#include "blocksum.h"
+#include "hashme.h"
+#include "mbhint.h"
 
 //#define SPEEDSTATS 1
 #define MIN_GF_INTERVAL             4
@@ -94,6 +99,25 @@ typedef struct
 
 } CODING_CONTEXT;
 
+// First pass sums for one MB row. They are added up in row order, so the
+// frame stats don't depend on how the rows were split between threads.
+typedef struct
+{
+    int64_t intra_error;
+    int64_t coded_error;
+    int sum_mvr, sum_mvc;
+    int sum_mvr_abs, sum_mvc_abs;
+    int sum_mvrs, sum_mvcs;
+    int mvcount;
+    int intercount;
+    int second_ref_count;
+    int neutral_count;
+    int new_mv_count;       // not counting the row's first non-zero mv
+    int sum_in_vectors;
+    uint32_t first_mv_as_int;
+    uint32_t last_mv_as_int;
+} FIRSTPASS_ROW_STATS;
+
 typedef struct
 {
     double frame;
@@ -169,9 +193,19 @@ typedef enum
 {
     DIAMOND = 0,
     NSTEP = 1,
-    HEX = 2
+    HEX = 2,
+    EPZS = 3
 } SEARCH_METHODS;
 
+typedef enum
+{
+    RECODE_MV_OFF,
+    RECODE_MV_RECORD,   // first Q trial of the frame
+    RECODE_MV_REUSE     // later ones
+} RECODE_MV_STATE;
+
+#define RECODE_MV_NONE 0x80008000
+
 typedef struct
 {
     int RD;
@@ -191,6 +225,10 @@ typedef struct
     int use_fastquant_for_pick;
     int no_skip_block4x4_search;
     int improved_mv_pred;
+    int me_pyramid;
+    int recode_mv_reuse;
+    int early_skip;
+    int satd_pick;
 
 } SPEED_FEATURES;
 
@@ -213,12 +251,44 @@ typedef struct
     void *ptr1;
     void *ptr2;
 } ENCODETHREAD_DATA;
+
+struct VP8_COMP;
+
+// Work run on every encoding thread by vp8cx_mt_run_job(). ithread is 0 on
+// the main thread, which passes cpi->mb as x.
+typedef void (*vp8cx_mt_job_fn)(struct VP8_COMP *cpi, MACROBLOCK *x,
+                                int ithread, void *data);
 typedef struct
 {
     int ithread;
     void *ptr1;
 } LPFTHREAD_DATA;
 
+// Work queued on the shared thread pool, see vp8cx_start_encoding_threads()
+typedef struct VP8_POOL_TASK
+{
+    void (*run)(struct VP8_COMP *cpi, int ithread);
+    struct VP8_COMP *cpi;
+    int ithread;
+    struct VP8_POOL_TASK *next;
+} VP8_POOL_TASK;
+
+// Work run off the calling thread by vp8cx_start_async()
+typedef int (*vp8cx_async_fn)(void *data);
+
+#if CONFIG_MULTI_RES_ENCODING
+#define MAX_MR_ENCODERS 16
+
+// Shared by the encoders of a multi-resolution encode, each of which is
+// registered under its mr_encoder_id. It's what mr_low_res_mode_info points
+// to, and is freed with the last encoder registered.
+typedef struct
+{
+    struct VP8_COMP *cpi[MAX_MR_ENCODERS];
+    int num_encoders;
+} MR_SHARED_INFO;
+#endif
+
 enum
 {
     BLOCK_16X8,
@@ -329,6 +399,9 @@ typedef struct VP8_COMP
 
     //int refresh_alt_ref_frame;
     YV12_BUFFER_CONFIG pick_lf_lvl_frame;
+#if CONFIG_MULTITHREAD
+    YV12_BUFFER_CONFIG pick_lf_lvl_frame_mt;
+#endif
 
     TOKENEXTRA *tok;
     unsigned int tok_count;
@@ -512,6 +585,7 @@ typedef struct VP8_COMP
 
     unsigned char *active_map;
     unsigned int active_map_enabled;
+    unsigned char *active_map_still;    // frames each MB has been still, see oxcf.auto_active_map
     // Video conferencing cyclic refresh mode flags etc
     // This is a mode designed to clean up the background over time in live encoding scenarious. It uses segmentation
     int cyclic_refresh_mode_enabled;
@@ -529,16 +603,57 @@ typedef struct VP8_COMP
 
     pthread_t *h_encoding_thread;
     pthread_t h_filter_thread;
+    pthread_t h_pack_thread;
+    int b_pack_thread;  // pack events and thread exist, see vp8cx_start_pack_thread()
 
     MB_ROW_COMP *mb_row_ei;
     ENCODETHREAD_DATA *en_thread_data;
     LPFTHREAD_DATA lpf_thread_data;
+    LPFTHREAD_DATA pack_thread_data;
+
+    vp8cx_mt_job_fn mt_job;
+    void *mt_job_data;
+
+    // Next MB row to be encoded, see vp8cx_claim_mb_row()
+    int mt_next_mb_row;
+
+    // Set when the threads are the shared pool's instead of our own
+    VP8_POOL_TASK *pool_tasks;
+
+    // A frame encoded off the calling thread, see vp8cx_start_async()
+    vp8cx_async_fn async_fn;
+    void *async_data;
+    int async_res;
+    int b_async_thread;
+    int async_pool;
+    pthread_t h_async_thread;
+    VP8_POOL_TASK async_task;
 
     //events
     sem_t *h_event_start_encoding;
     sem_t h_event_end_encoding;
+    sem_t h_event_end_job;
     sem_t h_event_start_lpf;
     sem_t h_event_end_lpf;
+    sem_t h_event_start_pack;
+    sem_t h_event_end_pack;
+    sem_t h_event_start_async;
+    sem_t h_event_end_async;
+
+    // Set for frames whose loop filter trails the MB row encoding, see
+    // loopfilter_frame_rows().
+    int lf_row_sync;
+    int next_filter_level;
+
+    // Set for frames whose tokens are packed as the MB rows are done, see
+    // vp8cx_pack_tokens_row_sync().
+    int token_row_sync;
+    int token_row_sync_failed;
+    vp8_prob coef_probs_row_sync[BLOCK_TYPES][COEF_BANDS][PREV_COEF_CONTEXTS][ENTROPY_NODES];
+
+    // Scratch space for packing token partitions on the encoding threads
+    unsigned char *partition_buf[MAX_PARTITIONS];
+    unsigned int partition_buf_sz;
 #endif
 
     TOKENLIST *tplist;
@@ -573,6 +688,7 @@ typedef struct VP8_COMP
         FIRSTPASS_STATS this_frame_stats;
         FIRSTPASS_STATS *stats_in, *stats_in_end, *stats_in_start;
         FIRSTPASS_STATS total_left_stats;
+        FIRSTPASS_ROW_STATS *row_stats;
         int first_pass_done;
         int64_t bits_left;
         int64_t clip_bits_total;
@@ -640,6 +756,41 @@ typedef struct VP8_COMP
     unsigned int * mb_activity_map;
     int * mb_norm_activity_map;
 
+    // Best full pel SAD of each MB's last EPZS search
+    unsigned int *epzs_sad;
+
+    // Source and last frame pyramids, and the full pel motion of each MB
+    // found on them to seed the MB searches
+    ME_PYRAMID me_pyramid[2];
+    int_mv *pyramid_mv;
+
+    // Precomputed half pel planes of up to HALFPEL_MAX_SETS references, and
+    // the set of each reference of the current frame, null if it has none
+    HALFPEL_PLANES halfpel[HALFPEL_MAX_SETS];
+    int halfpel_sets;
+    int halfpel_size;
+    HALFPEL_PLANES *halfpel_ref[MAX_REF_FRAMES];
+
+    // Block sums of the references for the full search, best quality only,
+    // and the set of each reference of the current frame
+    BLOCK_SUMS block_sums[BLOCK_SUMS_MAX_SETS];
+    int block_sums_sets;
+    int block_sums_size;
+    BLOCK_SUMS *block_sums_ref[MAX_REF_FRAMES];
+
+    // Blocks of the last frame's source by hash, for screen content
+    HASH_ME hash_me;
+
+    // Full pel NEWMV of each MB and reference found by the first Q trial of
+    // the recode loop, RECODE_MV_NONE where it did not search
+    int_mv *recode_mv;
+    RECODE_MV_STATE recode_mv_state;
+
+    // Hints for the MBs of the next frame coded, see VP8E_SET_MB_HINTS
+    MB_HINT *mb_hints;
+    int mb_hints_valid;
+    int mb_hints_only;
+
     // Record of which MBs still refer to last golden frame either
     // directly or through 0,0
     unsigned char *gf_active_flags;
@@ -677,6 +828,18 @@ typedef struct VP8_COMP
 #if CONFIG_MULTI_RES_ENCODING
     /* Number of MBs per row at lower-resolution level */
     int    mr_low_res_mb_cols;
+
+    /* This encoder's mode info, read by the next resolution up. mr_rows_ready
+     * rows of it are final for frame mr_frame. Frames are counted from 1.
+     */
+    LOWER_RES_INFO *mr_mode_info;
+    int    mr_frame;
+    int    mr_rows_ready;
+    int    mr_frames_done;
+
+    /* Set for frames whose mode info is stored row by row as it's encoded */
+    int    mr_row_publish;
+    int    mr_publish_lock;
 #endif
 
 } VP8_COMP;
@@ -24,6 +24,9 @@
 #include "mcomp.h"
 #include "rdopt.h"
 #include "vpx_mem/vpx_mem.h"
+#if CONFIG_MULTI_RES_ENCODING
+#include "mr_dissim.h"
+#endif
 
 extern int VP8_UVSSE(MACROBLOCK *x);
 
@@ -87,6 +90,42 @@ static int get_inter_mbpred_error(MACROBLOCK *mb,
 }
 
 
+/* Whether the zero MV prediction set up in xd->pre leaves nothing worth
+ * coding. The thresholds are those of the encode breakout in rdopt.c, with
+ * its Q dependent floor, so the MB is one that would quantize to a skip.
+ */
+static int check_early_skip(MACROBLOCK *x, const vp8_variance_fn_ptr_t *vfp,
+                            int *distortion, unsigned int *sse)
+{
+    MACROBLOCKD *xd = &x->e_mbd;
+    int threshold = (xd->block[0].dequant[1] * xd->block[0].dequant[1] >> 4);
+    unsigned int q2dc = xd->block[24].dequant[0];
+    unsigned int var;
+    int_mv zero_mv;
+
+    if (threshold < x->encode_breakout)
+        threshold = x->encode_breakout;
+
+    zero_mv.as_int = 0;
+    var = get_inter_mbpred_error(x, vfp, sse, zero_mv);
+
+    if (*sse >= (unsigned int)threshold)
+        return 0;
+
+    /* No codeable 2nd order DC, or a very small uniform pixel change */
+    if (*sse - var >= (q2dc * q2dc >> 4) &&
+        (*sse / 2 <= var || *sse - var >= 64))
+        return 0;
+
+    // Check u and v to make sure skip is ok
+    if (VP8_UVSSE(x) * 2 >= threshold)
+        return 0;
+
+    *distortion = var;
+    return 1;
+}
+
+
 unsigned int vp8_get4x4sse_cs_c
 (
     const unsigned char *src_ptr,
@@ -124,6 +163,17 @@ static int get_prediction_error(BLOCK *be, BLOCKD *b)
 
 }
 
+static unsigned int satd16x16(const unsigned char *src_ptr, int src_stride,
+                              const unsigned char *ref_ptr, int ref_stride)
+{
+    return vp8_satd8x8(src_ptr, src_stride, ref_ptr, ref_stride) +
+           vp8_satd8x8(src_ptr + 8, src_stride, ref_ptr + 8, ref_stride) +
+           vp8_satd8x8(src_ptr + 8 * src_stride, src_stride,
+                       ref_ptr + 8 * ref_stride, ref_stride) +
+           vp8_satd8x8(src_ptr + 8 * src_stride + 8, src_stride,
+                       ref_ptr + 8 * ref_stride + 8, ref_stride);
+}
+
 static int pick_intra4x4block(
     MACROBLOCK *x,
     int ib,
@@ -131,7 +181,8 @@ static int pick_intra4x4block(
     unsigned int *mode_costs,
 
     int *bestrate,
-    int *bestdistortion)
+    int *bestdistortion,
+    int use_satd)
 {
 
     BLOCKD *b = &x->e_mbd.block[ib];
@@ -149,8 +200,19 @@ static int pick_intra4x4block(
         vp8_intra4x4_predict
                      (*(b->base_dst) + b->dst, b->dst_stride,
                       mode, b->predictor_base + b->predictor_offset, 16);
-        distortion = get_prediction_error(be, b);
-        this_rd = RDCOST(x->rdmult, x->rddiv, rate, distortion);
+
+        if (use_satd)
+        {
+            distortion = vp8_satd4x4(*(be->base_src) + be->src, be->src_stride,
+                                     b->predictor_base + b->predictor_offset,
+                                     16);
+            this_rd = distortion + ((rate * x->sadperbit4 + 128) >> 8);
+        }
+        else
+        {
+            distortion = get_prediction_error(be, b);
+            this_rd = RDCOST(x->rdmult, x->rddiv, rate, distortion);
+        }
 
         if (this_rd < best_rd)
         {
@@ -163,6 +225,11 @@ static int pick_intra4x4block(
 
     b->bmi.as_mode = (B_PREDICTION_MODE)(*best_mode);
     vp8_encode_intra4x4block(x, ib);
+
+    // The SATD only ranks the modes, the caller expects the error
+    if (use_satd)
+        *bestdistortion = get_prediction_error(be, b);
+
     return best_rd;
 }
 
@@ -171,7 +238,8 @@ static int pick_intra4x4mby_modes
 (
     MACROBLOCK *mb,
     int *Rate,
-    int *best_dist
+    int *best_dist,
+    int use_satd
 )
 {
     MACROBLOCKD *const xd = &mb->e_mbd;
@@ -202,7 +270,8 @@ static int pick_intra4x4mby_modes
         }
 
 
-        pick_intra4x4block(mb, i, &best_mode, bmode_costs, &r, &d);
+        pick_intra4x4block(mb, i, &best_mode, bmode_costs, &r, &d,
+                           use_satd);
 
         cost += r;
         distortion += d;
@@ -399,8 +468,9 @@ void get_lower_res_motion_info(VP8_COMP *cpi, MACROBLOCKD *xd, int *dissim,
                                MB_PREDICTION_MODE *parent_mode,
                                int_mv *parent_ref_mv, int mb_row, int mb_col)
 {
-    LOWER_RES_INFO* store_mode_info
-                          = (LOWER_RES_INFO*)cpi->oxcf.mr_low_res_mode_info;
+    MR_SHARED_INFO *shared = (MR_SHARED_INFO *)cpi->oxcf.mr_low_res_mode_info;
+    VP8_COMP *parent = shared->cpi[cpi->oxcf.mr_encoder_id - 1];
+    LOWER_RES_INFO* store_mode_info = parent->mr_mode_info;
     unsigned int parent_mb_index;
     //unsigned int parent_mb_index = map_640x480_to_320x240[mb_row][mb_col];
 
@@ -418,6 +488,11 @@ void get_lower_res_motion_info(VP8_COMP *cpi, MACROBLOCKD *xd, int *dissim,
         parent_mb_col = (mb_col*cpi->oxcf.mr_down_sampling_factor.den+round)
                     /cpi->oxcf.mr_down_sampling_factor.num;
         parent_mb_index = parent_mb_row*cpi->mr_low_res_mb_cols + parent_mb_col;
+
+#if CONFIG_MULTITHREAD
+        if (cpi->oxcf.mr_pipeline)
+            vp8_mr_wait_for_parent_row(cpi, parent, parent_mb_row);
+#endif
     }
 
     /* Read lower-resolution mode & motion result from memory.*/
@@ -448,6 +523,113 @@ void get_lower_res_motion_info(VP8_COMP *cpi, MACROBLOCKD *xd, int *dissim,
 }
 #endif
 
+#define EPZS_MAX_CANDIDATES (8 + HASH_ME_MAX_CANDIDATES + \
+                             MB_HINT_MAX_CANDIDATES)
+#define EPZS_STOP_SAD       256
+#define EPZS_REFINE_SAD     128
+
+/* Gets the full pel starting points of the EPZS search: the MV predictor,
+ * the near MVs, zero, the co-located MV of the last frame and the MVs of
+ * the above, left and above-right MBs, plus the hash and hinted MVs if
+ * there are any. The early exit thresholds follow the SADs those
+ * neighbours ended their own searches with.
+ */
+static int get_epzs_candidates(VP8_COMP *cpi, MACROBLOCKD *xd,
+                               int_mv *mode_mv, int_mv *mvp, int mb_row,
+                               int mb_col, int_mv *candidates,
+                               unsigned int *stop_sad,
+                               unsigned int *refine_sad)
+{
+    const MODE_INFO *here = xd->mode_info_context;
+    const MODE_INFO *above = here - xd->mode_info_stride;
+    const MODE_INFO *neighbors[3];
+    int *sign_bias = cpi->common.ref_frame_sign_bias;
+    int ref_frame = here->mbmi.ref_frame;
+    int mb_cols = cpi->common.mb_cols;
+    unsigned int *sad = cpi->epzs_sad + mb_row * mb_cols + mb_col;
+    const MB_HINT *hint;
+    unsigned int min_sad;
+    int n = 0;
+    int i;
+
+    candidates[n++].as_int = mvp->as_int;
+    candidates[n++].as_int = mode_mv[NEARESTMV].as_int;
+    candidates[n++].as_int = mode_mv[NEARMV].as_int;
+    candidates[n++].as_int = 0;
+
+    if (cpi->common.last_frame_type != KEY_FRAME)
+    {
+        int mb_offset = (mb_row + 1) * (xd->mode_info_stride + 1) + mb_col + 1;
+
+        if (cpi->lf_ref_frame[mb_offset] != INTRA_FRAME)
+        {
+            candidates[n].as_int = cpi->lfmv[mb_offset].as_int;
+            mv_bias(cpi->lf_ref_frame_sign_bias[mb_offset], ref_frame,
+                    &candidates[n], sign_bias);
+            n++;
+        }
+    }
+
+    neighbors[0] = above;
+    neighbors[1] = here - 1;
+    neighbors[2] = above + 1;
+
+    for (i = 0; i < 3; i++)
+    {
+        if (neighbors[i]->mbmi.ref_frame != INTRA_FRAME)
+        {
+            candidates[n].as_int = neighbors[i]->mbmi.mv.as_int;
+            mv_bias(sign_bias[neighbors[i]->mbmi.ref_frame], ref_frame,
+                    &candidates[n], sign_bias);
+            n++;
+        }
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        candidates[i].as_mv.row >>= 3;
+        candidates[i].as_mv.col >>= 3;
+    }
+
+    if (cpi->hash_me.valid && ref_frame == LAST_FRAME)
+        n += vp8_hash_me_candidates(cpi, mb_row, mb_col, candidates + n);
+
+    hint = vp8_mb_hint(cpi, mb_row, mb_col);
+
+    if (hint && hint->ref_frame == ref_frame)
+        n += vp8_mb_hint_candidates(hint, candidates + n);
+
+    /* The co-located entry still holds the last frame's SAD */
+    min_sad = sad[0];
+
+    if (mb_col > 0 && sad[-1] < min_sad)
+        min_sad = sad[-1];
+
+    if (mb_row > 0)
+    {
+        if (sad[-mb_cols] < min_sad)
+            min_sad = sad[-mb_cols];
+
+        if (mb_col < mb_cols - 1 && sad[-mb_cols + 1] < min_sad)
+            min_sad = sad[-mb_cols + 1];
+    }
+
+    /* Stop once a candidate does nearly as well as the neighbours did, and
+     * only fall back to the wide search when it does much worse. */
+    *stop_sad = min_sad - (min_sad >> 3);
+
+    if (*stop_sad < EPZS_STOP_SAD)
+        *stop_sad = EPZS_STOP_SAD;
+
+    *refine_sad = min_sad + (min_sad >> 2) + EPZS_REFINE_SAD;
+
+    /* The floor on stop_sad can lift it above refine_sad for small SADs */
+    if (*refine_sad < *stop_sad)
+        *refine_sad = *stop_sad;
+
+    return n;
+}
+
 
 void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
                          int recon_uvoffset, int *returnrate,
@@ -481,6 +663,7 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
     int near_sadidx[8] = {0, 1, 2, 3, 4, 5, 6, 7};
     int saddone=0;
     int sr=0;    //search range got from mv_pred(). It uses step_param levels. (0-7)
+    unsigned int epzs_sad = UINT_MAX;
 
     unsigned char *plane[4][3];
     int ref_frame_map[4];
@@ -489,6 +672,10 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
     int have_subp_search = cpi->sf.half_pixel_search;  /* In real-time mode,
                                        when Speed >= 15, no sub-pixel search. */
 
+    const MB_HINT *hint = vp8_mb_hint(cpi, mb_row, mb_col);
+    int hint_only = hint && cpi->mb_hints_only && !cpi->is_src_frame_alt_ref;
+    int hint_newmv = 0;
+
 #if CONFIG_MULTI_RES_ENCODING
     int dissim = INT_MAX;
     int parent_ref_frame = 0;
@@ -534,15 +721,52 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
 
     x->e_mbd.mode_info_context->mbmi.ref_frame = INTRA_FRAME;
 
+    /* A MB the last frame already predicts well enough with a zero MV, as
+     * static backgrounds are, is a ZEROMV skip without trying any mode. */
+    if (cpi->sf.early_skip && ref_frame_map[1] == LAST_FRAME &&
+        !hint_only && !cpi->is_src_frame_alt_ref &&
+        !(cpi->active_map_enabled && x->active_ptr[0] == 0))
+    {
+        MB_MODE_INFO *mbmi = &x->e_mbd.mode_info_context->mbmi;
+
+        x->e_mbd.pre.y_buffer = plane[LAST_FRAME][0];
+        x->e_mbd.pre.u_buffer = plane[LAST_FRAME][1];
+        x->e_mbd.pre.v_buffer = plane[LAST_FRAME][2];
+        mbmi->ref_frame = LAST_FRAME;
+        mbmi->mode = ZEROMV;
+        mbmi->uv_mode = DC_PRED;
+        mbmi->mv.as_int = 0;
+
+        if (check_early_skip(x, &cpi->fn_ptr[BLOCK_16X16],
+                             returndistortion, &sse))
+        {
+            *returnrate = x->e_mbd.ref_frame_cost[LAST_FRAME] +
+                          vp8_cost_mv_ref(ZEROMV, mdcounts);
+            best_mode_index = THR_ZERO1;
+            best_sse = sse;
+            vpx_memcpy(&best_mbmode, mbmi, sizeof(MB_MODE_INFO));
+            x->skip = 1;
+        }
+        else
+            mbmi->ref_frame = INTRA_FRAME;
+    }
+
     // if we encode a new mv this is important
     // find the best new motion vector
-    for (mode_index = 0; mode_index < MAX_MODES; mode_index++)
+    for (mode_index = 0; mode_index < MAX_MODES && !x->skip; mode_index++)
     {
         int frame_cost;
         int this_rd = INT_MAX;
         int this_ref_frame = ref_frame_map[vp8_ref_frame_order[mode_index]];
 
-        if (best_rd <= cpi->rd_threshes[mode_index])
+        /* With hints only, try all the modes of the hinted reference frame
+         * and nothing else */
+        if (hint_only)
+        {
+            if (this_ref_frame != hint->ref_frame)
+                continue;
+        }
+        else if (best_rd <= cpi->rd_threshes[mode_index])
             continue;
 
         if (this_ref_frame < 0)
@@ -572,6 +796,7 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             x->e_mbd.pre.y_buffer = plane[this_ref_frame][0];
             x->e_mbd.pre.u_buffer = plane[this_ref_frame][1];
             x->e_mbd.pre.v_buffer = plane[this_ref_frame][2];
+            vp8_halfpel_setup_mb(cpi, x, this_ref_frame, recon_yoffset);
 
             if (sign_bias != cpi->common.ref_frame_sign_bias[this_ref_frame])
             {
@@ -603,7 +828,7 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
         /* Check to see if the testing frequency for this mode is at its max
          * If so then prevent it from being tested and increase the threshold
          * for its testing */
-        if (cpi->mode_test_hit_counts[mode_index] &&
+        if (!hint_only && cpi->mode_test_hit_counts[mode_index] &&
                                          (cpi->mode_check_freq[mode_index] > 1))
         {
             if (cpi->mbs_tested_so_far <= (cpi->mode_check_freq[mode_index] *
@@ -656,7 +881,8 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
         case B_PRED:
             /* Pass best so far to pick_intra4x4mby_modes to use as breakout */
             distortion2 = best_sse;
-            pick_intra4x4mby_modes(x, &rate, &distortion2);
+            pick_intra4x4mby_modes(x, &rate, &distortion2,
+                                   cpi->sf.satd_pick);
 
             if (distortion2 == INT_MAX)
             {
@@ -704,6 +930,17 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             break;
 
         case NEWMV:
+        hint_newmv = hint_only && vp8_mb_hint_mv_valid(hint, &best_ref_mv);
+
+        if (hint_newmv)
+        {
+            /* Take the hinted MV as it is, without any search */
+            mode_mv[NEWMV].as_int = hint->mv[0].as_int;
+
+            rate2 += vp8_mv_bit_cost(&mode_mv[NEWMV], &best_ref_mv,
+                                     cpi->mb.mvcost, 128);
+        }
+        else
         {
             int thissme;
             int step_param;
@@ -798,10 +1035,71 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
                 if (x->mv_row_max > row_max )
                     x->mv_row_max = row_max;
 
+                /* Start from the pyramid MV when it beats the predictor */
+                if (cpi->sf.me_pyramid && cpi->sf.search_method != EPZS &&
+                    x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME &&
+                    vp8_better_start_mv(x, b, d, &mvp_full,
+                        &cpi->pyramid_mv[mb_row * cpi->common.mb_cols + mb_col],
+                        sadpb, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost,
+                        &best_ref_mv) &&
+                    step_param < ME_PYRAMID_STEP_PARAM)
+                    step_param = ME_PYRAMID_STEP_PARAM;
+
+                /* An exact match only needs the smallest steps around it */
+                if (cpi->hash_me.valid && cpi->sf.search_method != EPZS &&
+                    x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME)
+                {
+                    int_mv hash_mv[HASH_ME_MAX_CANDIDATES];
+                    int count = vp8_hash_me_candidates(cpi, mb_row, mb_col,
+                                                       hash_mv);
+                    int i;
+
+                    for (i = 0; i < count; i++)
+                        if (vp8_better_start_mv(x, b, d, &mvp_full,
+                                                &hash_mv[i], sadpb,
+                                                &cpi->fn_ptr[BLOCK_16X16],
+                                                x->mvsadcost, &best_ref_mv))
+                            step_param = cpi->sf.max_step_search_steps - 1;
+                }
+
+                /* Start from the hinted MVs when they beat the predictor */
+                if (hint && hint->ref_frame == this_ref_frame &&
+                    cpi->sf.search_method != EPZS)
+                {
+                    int_mv hint_mv[MB_HINT_MAX_CANDIDATES];
+                    int count = vp8_mb_hint_candidates(hint, hint_mv);
+                    int i;
+
+                    for (i = 0; i < count; i++)
+                        if (vp8_better_start_mv(x, b, d, &mvp_full,
+                                                &hint_mv[i], sadpb,
+                                                &cpi->fn_ptr[BLOCK_16X16],
+                                                x->mvsadcost, &best_ref_mv) &&
+                            step_param < MB_HINT_STEP_PARAM)
+                            step_param = MB_HINT_STEP_PARAM;
+                }
+
                 further_steps = (cpi->Speed >= 8)?
                            0: (cpi->sf.max_step_search_steps - 1 - step_param);
 
-                if (cpi->sf.search_method == HEX)
+                if (cpi->sf.search_method == EPZS)
+                {
+                    int_mv candidates[EPZS_MAX_CANDIDATES];
+                    unsigned int stop_sad, refine_sad;
+                    int count = get_epzs_candidates(cpi, xd, mode_mv, &mvp,
+                                                    mb_row, mb_col, candidates,
+                                                    &stop_sad, &refine_sad);
+
+                    bestsme = vp8_epzs_search(x, b, d, candidates, count,
+                                          &d->bmi.mv, stop_sad, refine_sad,
+                                          sadpb, &cpi->fn_ptr[BLOCK_16X16],
+                                          x->mvsadcost, x->mvcost, &best_ref_mv);
+                    mode_mv[NEWMV].as_int = d->bmi.mv.as_int;
+
+                    if ((unsigned int)bestsme < epzs_sad)
+                        epzs_sad = bestsme;
+                }
+                else if (cpi->sf.search_method == HEX)
                 {
 #if CONFIG_MULTI_RES_ENCODING
                 /* TODO: In higher-res pick_inter_mode, step_param is used to
@@ -914,7 +1212,10 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
                 break;
             }
 
-            if((this_mode != NEWMV) ||
+            /* Inter modes stay ranked by variance even with satd_pick: the
+             * rd_threshes, the encode breakout and the comparison against
+             * the intra modes above all work on the SSE scale. */
+            if((this_mode != NEWMV) || hint_newmv ||
                 !(have_subp_search) || cpi->common.full_pixel==1)
                 distortion2 = get_inter_mbpred_error(x,
                                                      &cpi->fn_ptr[BLOCK_16X16],
@@ -982,6 +1283,9 @@ void vp8_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             break;
     }
 
+    if (epzs_sad != UINT_MAX)
+        cpi->epzs_sad[mb_row * cpi->common.mb_cols + mb_col] = epzs_sad;
+
     // Reduce the activation RD thresholds for the best choice mode
     if ((cpi->rd_baseline_thresh[best_mode_index] > 0) && (cpi->rd_baseline_thresh[best_mode_index] < (INT_MAX >> 2)))
     {
@@ -1049,7 +1353,7 @@ void vp8_pick_intra_mode(VP8_COMP *cpi, MACROBLOCK *x, int *rate_)
     int rate, best_rate = 0, distortion, best_sse;
     MB_PREDICTION_MODE mode, best_mode = DC_PRED;
     int this_rd;
-    unsigned int sse;
+    unsigned int sse = 0;
     BLOCK *b = &x->block[0];
 
     x->e_mbd.mode_info_context->mbmi.ref_frame = INTRA_FRAME;
@@ -1061,10 +1365,20 @@ void vp8_pick_intra_mode(VP8_COMP *cpi, MACROBLOCK *x, int *rate_)
         x->e_mbd.mode_info_context->mbmi.mode = mode;
         vp8_build_intra_predictors_mby
             (&x->e_mbd);
-        distortion = vp8_variance16x16
-            (*(b->base_src), b->src_stride, x->e_mbd.predictor, 16, &sse);
         rate = x->mbmode_cost[x->e_mbd.frame_type][mode];
-        this_rd = RDCOST(x->rdmult, x->rddiv, rate, distortion);
+
+        if (cpi->sf.satd_pick)
+        {
+            this_rd = satd16x16(*(b->base_src), b->src_stride,
+                                x->e_mbd.predictor, 16)
+                      + ((rate * x->sadperbit16 + 128) >> 8);
+        }
+        else
+        {
+            distortion = vp8_variance16x16
+                (*(b->base_src), b->src_stride, x->e_mbd.predictor, 16, &sse);
+            this_rd = RDCOST(x->rdmult, x->rddiv, rate, distortion);
+        }
 
         if (error16x16 > this_rd)
         {
@@ -1076,8 +1390,19 @@ void vp8_pick_intra_mode(VP8_COMP *cpi, MACROBLOCK *x, int *rate_)
     }
     x->e_mbd.mode_info_context->mbmi.mode = best_mode;
 
+    if (cpi->sf.satd_pick)
+    {
+        // Measure the error of the mode the SATD picked, so that it can be
+        // weighed against B_PRED
+        vp8_build_intra_predictors_mby(&x->e_mbd);
+        distortion = vp8_variance16x16
+            (*(b->base_src), b->src_stride, x->e_mbd.predictor, 16, &sse);
+        error16x16 = RDCOST(x->rdmult, x->rddiv, best_rate, distortion);
+        best_sse = sse;
+    }
+
     error4x4 = pick_intra4x4mby_modes(x, &rate,
-                                      &best_sse);
+                                      &best_sse, cpi->sf.satd_pick);
     if (error4x4 < error16x16)
     {
         x->e_mbd.mode_info_context->mbmi.mode = B_PRED;
@@ -132,7 +132,11 @@ static int get_max_filter_level(VP8_COMP *cpi, int base_qindex)
     return max_filter_level;
 }
 
-void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
+// Searches for the best level around filter_level, filtering a part of
+// saved_frame only. Returns the level found.
+static int search_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi,
+                                    YV12_BUFFER_CONFIG *saved_frame,
+                                    int filter_level)
 {
     VP8_COMMON *cm = &cpi->common;
 
@@ -141,8 +145,8 @@ void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
     int min_filter_level = get_min_filter_level(cpi, cm->base_qindex);
     int max_filter_level = get_max_filter_level(cpi, cm->base_qindex);
     int filt_val;
-    int best_filt_val = cm->filter_level;
-    YV12_BUFFER_CONFIG * saved_frame = cm->frame_to_show;
+    int best_filt_val = filter_level;
+    YV12_BUFFER_CONFIG * frame_to_show = cm->frame_to_show;
 
     /* Replace unfiltered frame buffer with a new one */
     cm->frame_to_show = &cpi->pick_lf_lvl_frame;
@@ -159,12 +163,12 @@ void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
     }
 
     // Start the search at the previous frame filter level unless it is now out of range.
-    if (cm->filter_level < min_filter_level)
-        cm->filter_level = min_filter_level;
-    else if (cm->filter_level > max_filter_level)
-        cm->filter_level = max_filter_level;
+    if (filter_level < min_filter_level)
+        filter_level = min_filter_level;
+    else if (filter_level > max_filter_level)
+        filter_level = max_filter_level;
 
-    filt_val = cm->filter_level;
+    filt_val = filter_level;
     best_filt_val = filt_val;
 
     // Get the err using the previous frame's filter value.
@@ -201,9 +205,9 @@ void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
     }
 
     // Search up (note that we have already done filt_val = cm->filter_level)
-    filt_val = cm->filter_level + 1 + (filt_val > 10);
+    filt_val = filter_level + 1 + (filt_val > 10);
 
-    if (best_filt_val == cm->filter_level)
+    if (best_filt_val == filter_level)
     {
         // Resist raising filter level for very small gains
         best_err -= (best_err >> 10);
@@ -234,17 +238,90 @@ void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
         }
     }
 
-    cm->filter_level = best_filt_val;
+    if (best_filt_val < min_filter_level)
+        best_filt_val = min_filter_level;
+
+    if (best_filt_val > max_filter_level)
+        best_filt_val = max_filter_level;
+
+    /* restore unfiltered frame pointer */
+    cm->frame_to_show = frame_to_show;
+
+    return best_filt_val;
+}
+
+void vp8cx_pick_filter_level_fast(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+
+    cm->filter_level = search_filter_level_fast(sd, cpi, cm->frame_to_show,
+                                                cm->filter_level);
+}
+
+#if CONFIG_MULTITHREAD
+// With lf_row_sync the frame is filtered while it is being encoded, so the
+// level has to be chosen up front. Key frames keep the level derived from Q
+// by vp8_setup_key_frame(), other frames use the level that was found on
+// the previous frame.
+void vp8cx_pick_filter_level_estimate(VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int min_filter_level = get_min_filter_level(cpi, cm->base_qindex);
+    int max_filter_level = get_max_filter_level(cpi, cm->base_qindex);
+
+    if (cm->frame_type == KEY_FRAME)
+        cm->sharpness_level = 0;
+    else
+    {
+        cm->sharpness_level = cpi->oxcf.Sharpness;
+        cm->filter_level = cpi->next_filter_level;
+    }
 
     if (cm->filter_level < min_filter_level)
         cm->filter_level = min_filter_level;
-
-    if (cm->filter_level > max_filter_level)
+    else if (cm->filter_level > max_filter_level)
         cm->filter_level = max_filter_level;
+}
 
-    /* restore unfiltered frame pointer */
-    cm->frame_to_show = saved_frame;
+// Saves the lines of mb_row that search_filter_level_fast() looks at, as
+// vp8_yv12_copy_partial_frame() would. Called just before the row is
+// filtered, when it still holds the unfiltered reconstruction.
+void vp8cx_save_filter_search_rows(VP8_COMP *cpi, int mb_row)
+{
+    YV12_BUFFER_CONFIG *src = cpi->common.frame_to_show;
+    YV12_BUFFER_CONFIG *dst = &cpi->pick_lf_lvl_frame_mt;
+    int ystride = src->y_stride;
+    int linestocopy;
+    int first, last;
+
+    linestocopy = (src->y_height >> 4) / PARTIAL_FRAME_FRACTION;
+    linestocopy = linestocopy ? linestocopy << 4 : 16;
+    linestocopy += 4;
+
+    first = ((src->y_height >> 5) * 16) - 4;
+    last = first + linestocopy;
+
+    if (first < mb_row * 16)
+        first = mb_row * 16;
+
+    if (last > mb_row * 16 + 16)
+        last = mb_row * 16 + 16;
+
+    if (first < last)
+        vpx_memcpy(dst->y_buffer + first * ystride,
+                   src->y_buffer + first * ystride,
+                   ystride * (last - first));
+}
+
+// Runs the fast level search on the rows saved by
+// vp8cx_save_filter_search_rows(), giving the next frame's level.
+void vp8cx_pick_next_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
+{
+    cpi->next_filter_level =
+        search_filter_level_fast(sd, cpi, &cpi->pick_lf_lvl_frame_mt,
+                                 cpi->common.filter_level);
 }
+#endif
 
 // Stub function for now Alt LF not used
 void vp8cx_set_alt_lf_level(VP8_COMP *cpi, int filt_val)
@@ -258,6 +335,59 @@ void vp8cx_set_alt_lf_level(VP8_COMP *cpi, int filt_val)
     mbd->segment_feature_data[MB_LVL_ALT_LF][3] = cpi->segment_feature_data[MB_LVL_ALT_LF][3];
 }
 
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+
+typedef struct
+{
+    YV12_BUFFER_CONFIG *sd;
+    YV12_BUFFER_CONFIG *saved_frame;
+    YV12_BUFFER_CONFIG *dst[2];
+    int level[2];
+    int err[2];
+} PICK_LF_JOB;
+
+// Filters and scores one of the candidate levels. Each level gets its own
+// copy of the unfiltered frame, so the threads don't share any output.
+static void pick_lf_trial(VP8_COMP *cpi, MACROBLOCK *x, int ithread, void *data)
+{
+    PICK_LF_JOB *job = (PICK_LF_JOB *)data;
+    int i;
+    (void) x;
+
+    for (i = ithread; i < 2; i += cpi->encoding_thread_count + 1)
+    {
+        vp8_yv12_copy_y_ptr(job->saved_frame, job->dst[i]);
+        vp8_loop_filter_buffer_yonly(&cpi->common, &cpi->mb.e_mbd,
+                                     job->dst[i], job->level[i]);
+        job->err[i] = vp8_calc_ss_err(job->sd, job->dst[i]);
+    }
+}
+
+// Scores filt_low and filt_high at the same time. The results go into
+// ss_err, where the search below picks them up exactly as if it had
+// computed them itself, so the chosen level doesn't depend on threading.
+static void pick_lf_trials_mt(VP8_COMP *cpi, YV12_BUFFER_CONFIG *sd,
+                              YV12_BUFFER_CONFIG *saved_frame, int *ss_err,
+                              int filt_low, int filt_high)
+{
+    PICK_LF_JOB job;
+
+    job.sd = sd;
+    job.saved_frame = saved_frame;
+    job.dst[0] = &cpi->pick_lf_lvl_frame;
+    job.dst[1] = &cpi->pick_lf_lvl_frame_mt;
+    job.level[0] = filt_low;
+    job.level[1] = filt_high;
+
+    vp8cx_set_alt_lf_level(cpi, filt_low);
+    vp8cx_mt_run_job(cpi, pick_lf_trial, &job);
+
+    ss_err[filt_low] = job.err[0];
+    ss_err[filt_high] = job.err[1];
+}
+#endif
+
 void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
 {
     VP8_COMMON *cm = &cpi->common;
@@ -326,6 +456,14 @@ void vp8cx_pick_filter_level(YV12_BUFFER_CONFIG *sd, VP8_COMP *cpi)
         filt_high = ((filt_mid + filter_step) > max_filter_level) ? max_filter_level : (filt_mid + filter_step);
         filt_low = ((filt_mid - filter_step) < min_filter_level) ? min_filter_level : (filt_mid - filter_step);
 
+#if CONFIG_MULTITHREAD
+        // When both sides of filt_mid have to be tried, try them together
+        if (cpi->b_multi_threaded && filt_direction == 0 &&
+            filt_low != filt_mid && ss_err[filt_low] == 0 &&
+            filt_high != filt_mid && ss_err[filt_high] == 0)
+            pick_lf_trials_mt(cpi, sd, saved_frame, ss_err, filt_low, filt_high);
+#endif
+
         if ((filt_direction <= 0) && (filt_low != filt_mid))
         {
             if(ss_err[filt_low] == 0)
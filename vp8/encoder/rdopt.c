@@ -1752,6 +1752,10 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
     int ref_frame_map[4];
     int sign_bias = 0;
 
+    const MB_HINT *hint = vp8_mb_hint(cpi, -xd->mb_to_top_edge >> 7,
+                                      -xd->mb_to_left_edge >> 7);
+    int hint_only = hint && cpi->mb_hints_only && !cpi->is_src_frame_alt_ref;
+
     mode_mv = mode_mv_sb[sign_bias];
     best_ref_mv.as_int = 0;
     vpx_memset(mode_mv_sb, 0, sizeof(mode_mv_sb));
@@ -1796,8 +1800,17 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
         int other_cost = 0;
         int this_ref_frame = ref_frame_map[vp8_ref_frame_order[mode_index]];
 
+        // With hints only, try all the modes of the hinted reference frame
+        // and nothing else, splitting only when the hint does
+        if (hint_only)
+        {
+            if (this_ref_frame != hint->ref_frame ||
+                (vp8_mode_order[mode_index] == SPLITMV &&
+                 hint->mode != VP8_MB_HINT_SPLIT))
+                continue;
+        }
         // Test best rd so far against threshold for trying this mode.
-        if (best_rd <= cpi->rd_threshes[mode_index])
+        else if (best_rd <= cpi->rd_threshes[mode_index])
             continue;
 
         if (this_ref_frame < 0)
@@ -1828,6 +1841,8 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             x->e_mbd.pre.y_buffer = plane[this_ref_frame][0];
             x->e_mbd.pre.u_buffer = plane[this_ref_frame][1];
             x->e_mbd.pre.v_buffer = plane[this_ref_frame][2];
+            vp8_halfpel_setup_mb(cpi, x, this_ref_frame, recon_yoffset);
+            vp8_block_sums_setup_mb(cpi, x, this_ref_frame, recon_yoffset);
 
             if (sign_bias != cpi->common.ref_frame_sign_bias[this_ref_frame])
             {
@@ -1839,7 +1854,7 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
 
         // Check to see if the testing frequency for this mode is at its max
         // If so then prevent it from being tested and increase the threshold for its testing
-        if (cpi->mode_test_hit_counts[mode_index] && (cpi->mode_check_freq[mode_index] > 1))
+        if (!hint_only && cpi->mode_test_hit_counts[mode_index] && (cpi->mode_check_freq[mode_index] > 1))
         {
             if (cpi->mbs_tested_so_far  <= cpi->mode_check_freq[mode_index] * cpi->mode_test_hit_counts[mode_index])
             {
@@ -1955,6 +1970,14 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             break;
 
         case NEWMV:
+        if (hint_only && vp8_mb_hint_mv_valid(hint, &best_ref_mv))
+        {
+            // Take the hinted MV as it is, without any search
+            mode_mv[NEWMV].as_int = hint->mv[0].as_int;
+
+            rate2 += vp8_mv_bit_cost(&mode_mv[NEWMV], &best_ref_mv, x->mvcost, 96);
+        }
+        else
         {
             int thissme;
             int bestsme = INT_MAX;
@@ -1966,6 +1989,10 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
 
             int sadpb = x->sadperbit16;
             int_mv mvp_full;
+            int mb_index = (-xd->mb_to_top_edge >> 7) * cpi->common.mb_cols
+                         + (-xd->mb_to_left_edge >> 7);
+            int_mv *recode_mv = &cpi->recode_mv[mb_index * MAX_REF_FRAMES +
+                                x->e_mbd.mode_info_context->mbmi.ref_frame];
 
             int col_min = ((best_ref_mv.as_mv.col+7)>>3) - MAX_FULL_PEL_VAL;
             int row_min = ((best_ref_mv.as_mv.row+7)>>3) - MAX_FULL_PEL_VAL;
@@ -1977,18 +2004,6 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             int tmp_row_min = x->mv_row_min;
             int tmp_row_max = x->mv_row_max;
 
-            if(!saddone)
-            {
-                vp8_cal_sad(cpi,xd,x, recon_yoffset ,&near_sadidx[0] );
-                saddone = 1;
-            }
-
-            vp8_mv_pred(cpi, &x->e_mbd, x->e_mbd.mode_info_context, &mvp,
-                        x->e_mbd.mode_info_context->mbmi.ref_frame, cpi->common.ref_frame_sign_bias, &sr, &near_sadidx[0]);
-
-            mvp_full.as_mv.col = mvp.as_mv.col>>3;
-            mvp_full.as_mv.row = mvp.as_mv.row>>3;
-
             // Get intersection of UMV window and valid MV window to reduce # of checks in diamond search.
             if (x->mv_col_min < col_min )
                 x->mv_col_min = col_min;
@@ -1999,9 +2014,78 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             if (x->mv_row_max > row_max )
                 x->mv_row_max = row_max;
 
-            //adjust search range according to sr from mv prediction
-            if(sr > step_param)
-                step_param = sr;
+            // Full pel motion barely depends on Q, so the later Q trials of
+            // the recode loop only refine what the first one found
+            if (cpi->recode_mv_state == RECODE_MV_REUSE &&
+                recode_mv->as_int != RECODE_MV_NONE)
+            {
+                mvp_full.as_int = recode_mv->as_int;
+                step_param = cpi->sf.max_step_search_steps - 1;
+            }
+            else
+            {
+                if(!saddone)
+                {
+                    vp8_cal_sad(cpi,xd,x, recon_yoffset ,&near_sadidx[0] );
+                    saddone = 1;
+                }
+
+                vp8_mv_pred(cpi, &x->e_mbd, x->e_mbd.mode_info_context, &mvp,
+                            x->e_mbd.mode_info_context->mbmi.ref_frame, cpi->common.ref_frame_sign_bias, &sr, &near_sadidx[0]);
+
+                mvp_full.as_mv.col = mvp.as_mv.col>>3;
+                mvp_full.as_mv.row = mvp.as_mv.row>>3;
+
+                //adjust search range according to sr from mv prediction
+                if(sr > step_param)
+                    step_param = sr;
+
+                // Start from the pyramid MV when it beats the predictor
+                if (cpi->sf.me_pyramid &&
+                    x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME)
+                {
+                    if (vp8_better_start_mv(x, b, d, &mvp_full,
+                                            &cpi->pyramid_mv[mb_index], sadpb,
+                                            &cpi->fn_ptr[BLOCK_16X16],
+                                            x->mvsadcost, &best_ref_mv) &&
+                        step_param < ME_PYRAMID_STEP_PARAM)
+                        step_param = ME_PYRAMID_STEP_PARAM;
+                }
+
+                // An exact match only needs the smallest steps around it
+                if (cpi->hash_me.valid &&
+                    x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME)
+                {
+                    int_mv hash_mv[HASH_ME_MAX_CANDIDATES];
+                    int count = vp8_hash_me_candidates(cpi,
+                                                       -xd->mb_to_top_edge >> 7,
+                                                       -xd->mb_to_left_edge >> 7,
+                                                       hash_mv);
+                    int i;
+
+                    for (i = 0; i < count; i++)
+                        if (vp8_better_start_mv(x, b, d, &mvp_full, &hash_mv[i],
+                                                sadpb, &cpi->fn_ptr[BLOCK_16X16],
+                                                x->mvsadcost, &best_ref_mv))
+                            step_param = cpi->sf.max_step_search_steps - 1;
+                }
+
+                // Start from the hinted MVs when they beat the predictor
+                if (hint && hint->ref_frame ==
+                            x->e_mbd.mode_info_context->mbmi.ref_frame)
+                {
+                    int_mv hint_mv[MB_HINT_MAX_CANDIDATES];
+                    int count = vp8_mb_hint_candidates(hint, hint_mv);
+                    int i;
+
+                    for (i = 0; i < count; i++)
+                        if (vp8_better_start_mv(x, b, d, &mvp_full, &hint_mv[i],
+                                                sadpb, &cpi->fn_ptr[BLOCK_16X16],
+                                                x->mvsadcost, &best_ref_mv) &&
+                            step_param < MB_HINT_STEP_PARAM)
+                            step_param = MB_HINT_STEP_PARAM;
+                }
+            }
 
             // Initial step/diamond search
             {
@@ -2082,6 +2166,9 @@ void vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset,
             x->mv_row_min = tmp_row_min;
             x->mv_row_max = tmp_row_max;
 
+            if (cpi->recode_mv_state == RECODE_MV_RECORD)
+                recode_mv->as_int = d->bmi.mv.as_int;
+
             if (bestsme < INT_MAX)
             {
                 int dis; /* TODO: use dis in distortion calculation later. */
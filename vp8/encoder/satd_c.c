@@ -0,0 +1,122 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include <stdlib.h>
+#include "vpx_config.h"
+
+/* Sum of the absolute values of the Hadamard transformed differences
+ * (SATD). The transform is left unnormalized and the sums are scaled back
+ * as an orthonormal one would have them, where they are about a SAD, so
+ * that they can be weighed against rates with the sadperbit constants.
+ * The order of the coefficients does not matter here, so the butterflies
+ * are not reordered into sequency order.
+ */
+unsigned int vp8_satd4x4_c(
+    const unsigned char *src_ptr,
+    int  src_stride,
+    const unsigned char *ref_ptr,
+    int  ref_stride)
+{
+    int d[16];
+    int i;
+    unsigned int satd = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        int a0 = src_ptr[0] - ref_ptr[0];
+        int a1 = src_ptr[1] - ref_ptr[1];
+        int a2 = src_ptr[2] - ref_ptr[2];
+        int a3 = src_ptr[3] - ref_ptr[3];
+        int b0 = a0 + a1;
+        int b1 = a0 - a1;
+        int b2 = a2 + a3;
+        int b3 = a2 - a3;
+
+        d[i * 4 + 0] = b0 + b2;
+        d[i * 4 + 1] = b1 + b3;
+        d[i * 4 + 2] = b0 - b2;
+        d[i * 4 + 3] = b1 - b3;
+
+        src_ptr += src_stride;
+        ref_ptr += ref_stride;
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        int b0 = d[i] + d[4 + i];
+        int b1 = d[i] - d[4 + i];
+        int b2 = d[8 + i] + d[12 + i];
+        int b3 = d[8 + i] - d[12 + i];
+
+        satd += abs(b0 + b2) + abs(b1 + b3) + abs(b0 - b2) + abs(b1 - b3);
+    }
+
+    return (satd + 2) >> 2;
+}
+
+
+static void hadamard8(int *d, int pitch)
+{
+    int b[8];
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        b[i] = d[i * pitch] + d[(i + 4) * pitch];
+        b[i + 4] = d[i * pitch] - d[(i + 4) * pitch];
+    }
+
+    for (i = 0; i < 8; i += 4)
+    {
+        int c0 = b[i] + b[i + 2];
+        int c1 = b[i + 1] + b[i + 3];
+        int c2 = b[i] - b[i + 2];
+        int c3 = b[i + 1] - b[i + 3];
+
+        d[i * pitch] = c0 + c1;
+        d[(i + 1) * pitch] = c0 - c1;
+        d[(i + 2) * pitch] = c2 + c3;
+        d[(i + 3) * pitch] = c2 - c3;
+    }
+}
+
+
+unsigned int vp8_satd8x8_c(
+    const unsigned char *src_ptr,
+    int  src_stride,
+    const unsigned char *ref_ptr,
+    int  ref_stride)
+{
+    int d[64];
+    int r, c;
+    unsigned int satd = 0;
+
+    for (r = 0; r < 8; r++)
+    {
+        for (c = 0; c < 8; c++)
+            d[r * 8 + c] = src_ptr[c] - ref_ptr[c];
+
+        src_ptr += src_stride;
+        ref_ptr += ref_stride;
+    }
+
+    // Columns, then rows
+    for (c = 0; c < 8; c++)
+        hadamard8(d + c, 8);
+
+    for (r = 0; r < 8; r++)
+        hadamard8(d + r * 8, 1);
+
+    for (r = 0; r < 64; r++)
+        satd += abs(d[r]);
+
+    return (satd + 4) >> 3;
+}
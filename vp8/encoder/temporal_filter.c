@@ -140,13 +140,13 @@ static int dummy_cost[2*mv_max+1];
 static int vp8_temporal_filter_find_matching_mb_c
 (
     VP8_COMP *cpi,
+    MACROBLOCK *x,
     YV12_BUFFER_CONFIG *arf_frame,
     YV12_BUFFER_CONFIG *frame_ptr,
     int mb_offset,
     int error_thresh
 )
 {
-    MACROBLOCK *x = &cpi->mb;
     int step_param;
     int further_steps;
     int sadpb = x->sadperbit16;
@@ -210,6 +210,9 @@ static int vp8_temporal_filter_find_matching_mb_c
     {
         int distortion;
         unsigned int sse;
+
+        // The half pel planes are of the references, not of this frame
+        x->halfpel[0] = 0;
         bestsme = cpi->find_fractional_mv_step(x, b, d,
                     &d->bmi.mv, &best_ref_mv1,
                     x->errorperbit, &cpi->fn_ptr[BLOCK_16X16],
@@ -229,36 +232,46 @@ static int vp8_temporal_filter_find_matching_mb_c
 }
 #endif
 
-static void vp8_temporal_filter_iterate_c
+typedef struct
+{
+    int frame_count;
+    int alt_ref_index;
+    int strength;
+    int row_step;
+} TEMPORAL_FILTER_JOB;
+
+// Filters every job->row_step'th MB row starting at row ithread. Each MB only
+// reads the source frames and writes its own part of alt_ref_buffer, so the
+// rows can be filtered in any order, on any thread.
+static void vp8_temporal_filter_iterate_rows
 (
     VP8_COMP *cpi,
-    int frame_count,
-    int alt_ref_index,
-    int strength
+    MACROBLOCK *x,
+    int ithread,
+    void *data
 )
 {
+    TEMPORAL_FILTER_JOB *job = (TEMPORAL_FILTER_JOB *)data;
     int byte;
     int frame;
     int mb_col, mb_row;
     unsigned int filter_weight;
     int mb_cols = cpi->common.mb_cols;
     int mb_rows = cpi->common.mb_rows;
-    int mb_y_offset = 0;
-    int mb_uv_offset = 0;
+    int mb_y_offset;
+    int mb_uv_offset;
     DECLARE_ALIGNED_ARRAY(16, unsigned int, accumulator, 16*16 + 8*8 + 8*8);
     DECLARE_ALIGNED_ARRAY(16, unsigned short, count, 16*16 + 8*8 + 8*8);
-    MACROBLOCKD *mbd = &cpi->mb.e_mbd;
-    YV12_BUFFER_CONFIG *f = cpi->frames[alt_ref_index];
+    MACROBLOCKD *mbd = &x->e_mbd;
+    YV12_BUFFER_CONFIG *f = cpi->frames[job->alt_ref_index];
     unsigned char *dst1, *dst2;
     DECLARE_ALIGNED_ARRAY(16, unsigned char,  predictor, 16*16 + 8*8 + 8*8);
 
-    // Save input state
-    unsigned char *y_buffer = mbd->pre.y_buffer;
-    unsigned char *u_buffer = mbd->pre.u_buffer;
-    unsigned char *v_buffer = mbd->pre.v_buffer;
-
-    for (mb_row = 0; mb_row < mb_rows; mb_row++)
+    for (mb_row = ithread; mb_row < mb_rows; mb_row += job->row_step)
     {
+        mb_y_offset = mb_row * 16 * f->y_stride;
+        mb_uv_offset = mb_row * 8 * f->uv_stride;
+
 #if ALT_REF_MC_ENABLED
         // Source frames are extended to 16 pixels.  This is different than
         //  L/A/G reference frames that have a border of 32 (VP8BORDERINPIXELS)
@@ -270,8 +283,8 @@ static void vp8_temporal_filter_iterate_c
         //  (16 - 3) >> 1 == 6 which is greater than 8 - 3.
         // To keep the mv in play for both Y and UV planes the max that it
         //  can be on a border is therefore 16 - 5.
-        cpi->mb.mv_row_min = -((mb_row * 16) + (16 - 5));
-        cpi->mb.mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16)
+        x->mv_row_min = -((mb_row * 16) + (16 - 5));
+        x->mv_row_max = ((cpi->common.mb_rows - 1 - mb_row) * 16)
                                 + (16 - 5);
 #endif
 
@@ -284,12 +297,12 @@ static void vp8_temporal_filter_iterate_c
             vpx_memset(count, 0, 384*sizeof(unsigned short));
 
 #if ALT_REF_MC_ENABLED
-            cpi->mb.mv_col_min = -((mb_col * 16) + (16 - 5));
-            cpi->mb.mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16)
+            x->mv_col_min = -((mb_col * 16) + (16 - 5));
+            x->mv_col_max = ((cpi->common.mb_cols - 1 - mb_col) * 16)
                                     + (16 - 5);
 #endif
 
-            for (frame = 0; frame < frame_count; frame++)
+            for (frame = 0; frame < job->frame_count; frame++)
             {
                 int err = 0;
 
@@ -306,7 +319,8 @@ static void vp8_temporal_filter_iterate_c
                 // Find best match in this frame by MC
                 err = vp8_temporal_filter_find_matching_mb_c
                       (cpi,
-                       cpi->frames[alt_ref_index],
+                       x,
+                       cpi->frames[job->alt_ref_index],
                        cpi->frames[frame],
                        mb_y_offset,
                        THRESH_LOW);
@@ -337,7 +351,7 @@ static void vp8_temporal_filter_iterate_c
                          f->y_stride,
                          predictor,
                          16,
-                         strength,
+                         job->strength,
                          filter_weight,
                          accumulator,
                          count);
@@ -347,7 +361,7 @@ static void vp8_temporal_filter_iterate_c
                          f->uv_stride,
                          predictor + 256,
                          8,
-                         strength,
+                         job->strength,
                          filter_weight,
                          accumulator + 256,
                          count + 256);
@@ -357,7 +371,7 @@ static void vp8_temporal_filter_iterate_c
                          f->uv_stride,
                          predictor + 320,
                          8,
-                         strength,
+                         job->strength,
                          filter_weight,
                          accumulator + 320,
                          count + 320);
@@ -418,9 +432,56 @@ static void vp8_temporal_filter_iterate_c
             mb_uv_offset += 8;
         }
 
-        mb_y_offset += 16*(f->y_stride-mb_cols);
-        mb_uv_offset += 8*(f->uv_stride-mb_cols);
     }
+}
+
+#if CONFIG_MULTITHREAD
+extern void vp8cx_mt_run_job(VP8_COMP *cpi, vp8cx_mt_job_fn job, void *data);
+#endif
+
+static void vp8_temporal_filter_iterate_c
+(
+    VP8_COMP *cpi,
+    int frame_count,
+    int alt_ref_index,
+    int strength
+)
+{
+    TEMPORAL_FILTER_JOB job;
+    MACROBLOCKD *mbd = &cpi->mb.e_mbd;
+
+    // Save input state
+    unsigned char *y_buffer = mbd->pre.y_buffer;
+    unsigned char *u_buffer = mbd->pre.u_buffer;
+    unsigned char *v_buffer = mbd->pre.v_buffer;
+
+    job.frame_count = frame_count;
+    job.alt_ref_index = alt_ref_index;
+    job.strength = strength;
+    job.row_step = 1;
+
+#if CONFIG_MULTITHREAD
+    if (cpi->b_multi_threaded)
+    {
+        int i;
+
+        // The encoding threads search with the same settings as cpi->mb
+        for (i = 0; i < cpi->encoding_thread_count; i++)
+        {
+            MACROBLOCK *z = &cpi->mb_row_ei[i].mb;
+
+            z->sadperbit16 = cpi->mb.sadperbit16;
+            z->errorperbit = cpi->mb.errorperbit;
+            z->e_mbd.subpixel_predict8x8 = mbd->subpixel_predict8x8;
+            z->e_mbd.subpixel_predict16x16 = mbd->subpixel_predict16x16;
+        }
+
+        job.row_step = cpi->encoding_thread_count + 1;
+        vp8cx_mt_run_job(cpi, vp8_temporal_filter_iterate_rows, &job);
+    }
+    else
+#endif
+        vp8_temporal_filter_iterate_rows(cpi, &cpi->mb, 0, &job);
 
     // Restore input state
     mbd->pre.y_buffer = y_buffer;
@@ -0,0 +1,178 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include <emmintrin.h> /* SSE2 */
+#include "vpx_config.h"
+
+/* SSE2 versions of vp8_satd4x4_c() and vp8_satd8x8_c(), see satd_c.c. They
+ * return the same values. The differences stay within 16 bits through both
+ * passes of the transform: 8 * 8 * 255 for the 8x8 one.
+ */
+
+static __m128i load_diff4x2(const unsigned char *src_ptr, int src_stride,
+                            const unsigned char *ref_ptr, int ref_stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s = _mm_unpacklo_epi32(
+                    _mm_cvtsi32_si128(*(const int *)src_ptr),
+                    _mm_cvtsi32_si128(*(const int *)(src_ptr + src_stride)));
+    __m128i r = _mm_unpacklo_epi32(
+                    _mm_cvtsi32_si128(*(const int *)ref_ptr),
+                    _mm_cvtsi32_si128(*(const int *)(ref_ptr + ref_stride)));
+
+    return _mm_sub_epi16(_mm_unpacklo_epi8(s, zero),
+                         _mm_unpacklo_epi8(r, zero));
+}
+
+/* 4 point transform of the rows, with rows 0 and 1 in the low and high half
+ * of *a, and rows 2 and 3 in *b.
+ */
+static void hadamard4x2(__m128i *a, __m128i *b)
+{
+    __m128i s = _mm_add_epi16(*a, *b);
+    __m128i d = _mm_sub_epi16(*a, *b);
+    __m128i t0 = _mm_unpacklo_epi64(s, d);
+    __m128i t1 = _mm_unpackhi_epi64(s, d);
+
+    *a = _mm_add_epi16(t0, t1);
+    *b = _mm_sub_epi16(t0, t1);
+}
+
+static __m128i add_abs_epi16(__m128i sum, __m128i x)
+{
+    x = _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+
+    return _mm_add_epi32(sum, _mm_madd_epi16(x, _mm_set1_epi16(1)));
+}
+
+static unsigned int sum_epi32(__m128i sum)
+{
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 8));
+    sum = _mm_add_epi32(sum, _mm_srli_si128(sum, 4));
+
+    return _mm_cvtsi128_si32(sum);
+}
+
+unsigned int vp8_satd4x4_sse2(
+    const unsigned char *src_ptr,
+    int  src_stride,
+    const unsigned char *ref_ptr,
+    int  ref_stride)
+{
+    __m128i a, b, t0, t1;
+    __m128i sum = _mm_setzero_si128();
+
+    a = load_diff4x2(src_ptr, src_stride, ref_ptr, ref_stride);
+    b = load_diff4x2(src_ptr + 2 * src_stride, src_stride,
+                     ref_ptr + 2 * ref_stride, ref_stride);
+
+    hadamard4x2(&a, &b);
+
+    // Transpose, so that a and b hold columns 0 and 1, and 2 and 3
+    t0 = _mm_unpacklo_epi16(a, b);
+    t1 = _mm_unpackhi_epi16(a, b);
+    a = _mm_unpacklo_epi16(t0, t1);
+    b = _mm_unpackhi_epi16(t0, t1);
+
+    hadamard4x2(&a, &b);
+
+    sum = add_abs_epi16(sum, a);
+    sum = add_abs_epi16(sum, b);
+
+    return (sum_epi32(sum) + 2) >> 2;
+}
+
+
+/* 8 point transform across r[0] to r[7], like hadamard8() in satd_c.c */
+static void hadamard8x8(__m128i *r)
+{
+    __m128i b[8];
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        b[i] = _mm_add_epi16(r[i], r[i + 4]);
+        b[i + 4] = _mm_sub_epi16(r[i], r[i + 4]);
+    }
+
+    for (i = 0; i < 8; i += 4)
+    {
+        __m128i c0 = _mm_add_epi16(b[i], b[i + 2]);
+        __m128i c1 = _mm_add_epi16(b[i + 1], b[i + 3]);
+        __m128i c2 = _mm_sub_epi16(b[i], b[i + 2]);
+        __m128i c3 = _mm_sub_epi16(b[i + 1], b[i + 3]);
+
+        r[i] = _mm_add_epi16(c0, c1);
+        r[i + 1] = _mm_sub_epi16(c0, c1);
+        r[i + 2] = _mm_add_epi16(c2, c3);
+        r[i + 3] = _mm_sub_epi16(c2, c3);
+    }
+}
+
+static void transpose8x8(__m128i *r)
+{
+    __m128i a[8], b[8];
+    int i;
+
+    for (i = 0; i < 8; i += 2)
+    {
+        a[i] = _mm_unpacklo_epi16(r[i], r[i + 1]);
+        a[i + 1] = _mm_unpackhi_epi16(r[i], r[i + 1]);
+    }
+
+    for (i = 0; i < 8; i += 4)
+    {
+        b[i] = _mm_unpacklo_epi32(a[i], a[i + 2]);
+        b[i + 1] = _mm_unpackhi_epi32(a[i], a[i + 2]);
+        b[i + 2] = _mm_unpacklo_epi32(a[i + 1], a[i + 3]);
+        b[i + 3] = _mm_unpackhi_epi32(a[i + 1], a[i + 3]);
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        r[i * 2] = _mm_unpacklo_epi64(b[i], b[i + 4]);
+        r[i * 2 + 1] = _mm_unpackhi_epi64(b[i], b[i + 4]);
+    }
+}
+
+unsigned int vp8_satd8x8_sse2(
+    const unsigned char *src_ptr,
+    int  src_stride,
+    const unsigned char *ref_ptr,
+    int  ref_stride)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i r[8];
+    __m128i sum = zero;
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        __m128i s = _mm_loadl_epi64((const __m128i *)src_ptr);
+        __m128i p = _mm_loadl_epi64((const __m128i *)ref_ptr);
+
+        r[i] = _mm_sub_epi16(_mm_unpacklo_epi8(s, zero),
+                             _mm_unpacklo_epi8(p, zero));
+
+        src_ptr += src_stride;
+        ref_ptr += ref_stride;
+    }
+
+    // Columns, then rows
+    hadamard8x8(r);
+    transpose8x8(r);
+    hadamard8x8(r);
+
+    for (i = 0; i < 8; i++)
+        sum = add_abs_epi16(sum, r[i]);
+
+    return (sum_epi32(sum) + 4) >> 3;
+}
@@ -178,10 +178,13 @@ VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/idct_cl.h
 
 VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter_cl.h
 VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter_cl.c
-VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter_cl.cl
+VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter.cl
 VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter_filters_cl.c
+VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/loopfilter_tune_cl.c
 
 
+VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/profile_cl.c
+VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/profile_cl.h
 VP8_COMMON_SRCS-$(CONFIG_OPENCL) += common/opencl/opencl_systemdependent.c
 VP8_COMMON_SRCS-$(HAVE_DLOPEN) += common/opencl/dynamic_cl.c
 VP8_COMMON_SRCS-$(HAVE_DLOPEN) += common/opencl/dynamic_cl.h
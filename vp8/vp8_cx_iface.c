@@ -24,6 +24,14 @@
  */
 #define NO_MODE_SET 255
 
+#define VP8_CAP_MR_PIPELINE (CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD ? \
+                                    VPX_CODEC_CAP_MR_PIPELINE : 0)
+
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+extern void vp8cx_start_async(VP8_COMP *cpi, vp8cx_async_fn fn, void *data);
+extern int vp8cx_finish_async(VP8_COMP *cpi);
+#endif
+
 struct vp8_extracfg
 {
     struct vpx_codec_pkt_list *pkt_list;
@@ -40,6 +48,12 @@ struct vp8_extracfg
     vp8e_tuning                 tuning;
     unsigned int                cq_level;         /* constrained quality level */
     unsigned int                rc_max_intra_bitrate_pct;
+    unsigned int                first_pass_downscale;
+    unsigned int                lf_row_sync;
+    unsigned int                token_row_sync;
+    unsigned int                halfpel_planes_kb;
+    unsigned int                screen_content;
+    unsigned int                auto_active_map;
 
 };
 
@@ -73,6 +87,12 @@ static const struct extraconfig_map extracfg_map[] =
             0,                          /* tuning*/
             10,                         /* cq_level */
             0,                          /* rc_max_intra_bitrate_pct */
+            0,                          /* first_pass_downscale */
+            0,                          /* lf_row_sync */
+            0,                          /* token_row_sync */
+            0,                          /* halfpel_planes_kb */
+            0,                          /* screen_content */
+            0,                          /* auto_active_map */
         }
     }
 };
@@ -92,6 +112,9 @@ struct vpx_codec_alg_priv
     vpx_codec_pkt_list_decl(64) pkt_list;              // changed to accomendate the maximum number of lagged frames allowed
     int                         deprecated_mode;
     unsigned int                fixed_kf_cntr;
+#if CONFIG_MULTI_RES_ENCODING
+    int                         mr_flush;
+#endif
 };
 
 
@@ -148,6 +171,7 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t      *ctx,
     RANGE_CHECK_HI(cfg, rc_max_quantizer,   63);
     RANGE_CHECK_HI(cfg, rc_min_quantizer,   cfg->rc_max_quantizer);
     RANGE_CHECK_HI(cfg, g_threads,          64);
+    RANGE_CHECK_HI(cfg, g_pool_threads,     64);
 #if !(CONFIG_REALTIME_ONLY)
     RANGE_CHECK_HI(cfg, g_lag_in_frames,    25);
 #else
@@ -194,6 +218,21 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t      *ctx,
     RANGE_CHECK_HI(vp8_cfg, arnr_strength,   6);
     RANGE_CHECK(vp8_cfg, arnr_type,       1, 3);
     RANGE_CHECK(vp8_cfg, cq_level, 0, 63);
+#if CONFIG_SPATIAL_RESAMPLING
+    RANGE_CHECK_BOOL(vp8_cfg,               first_pass_downscale);
+#else
+    RANGE_CHECK(vp8_cfg, first_pass_downscale, 0, 0);
+#endif
+#if CONFIG_MULTITHREAD
+    RANGE_CHECK_BOOL(vp8_cfg,               lf_row_sync);
+    RANGE_CHECK_BOOL(vp8_cfg,               token_row_sync);
+#else
+    RANGE_CHECK(vp8_cfg, lf_row_sync, 0, 0);
+    RANGE_CHECK(vp8_cfg, token_row_sync, 0, 0);
+#endif
+    RANGE_CHECK_HI(vp8_cfg, halfpel_planes_kb, 1 << 20);
+    RANGE_CHECK_BOOL(vp8_cfg,               screen_content);
+    RANGE_CHECK_HI(vp8_cfg, auto_active_map, 64);
     if(finalize && cfg->rc_end_usage == VPX_CQ)
         RANGE_CHECK(vp8_cfg, cq_level,
                     cfg->rc_min_quantizer, cfg->rc_max_quantizer);
@@ -272,6 +311,7 @@ static vpx_codec_err_t set_vp8e_config(VP8_CONFIG *oxcf,
                                        vpx_codec_priv_enc_mr_cfg_t *mr_cfg)
 {
     oxcf->multi_threaded         = cfg.g_threads;
+    oxcf->pool_threads           = cfg.g_pool_threads;
     oxcf->Version               = cfg.g_profile;
 
     oxcf->Width                 = cfg.g_w;
@@ -326,6 +366,12 @@ static vpx_codec_err_t set_vp8e_config(VP8_CONFIG *oxcf,
 
     oxcf->target_bandwidth         = cfg.rc_target_bitrate;
     oxcf->rc_max_intra_bitrate_pct = vp8_cfg.rc_max_intra_bitrate_pct;
+    oxcf->first_pass_downscale     = vp8_cfg.first_pass_downscale;
+    oxcf->lf_row_sync              = vp8_cfg.lf_row_sync;
+    oxcf->token_row_sync           = vp8_cfg.token_row_sync;
+    oxcf->halfpel_planes_kb        = vp8_cfg.halfpel_planes_kb;
+    oxcf->screen_content           = vp8_cfg.screen_content;
+    oxcf->auto_active_map          = vp8_cfg.auto_active_map;
 
     oxcf->best_allowed_q           = cfg.rc_min_quantizer;
     oxcf->worst_allowed_q          = cfg.rc_max_quantizer;
@@ -482,6 +528,7 @@ static vpx_codec_err_t get_param(vpx_codec_alg_priv_t *ctx,
     {
         MAP(VP8E_GET_LAST_QUANTIZER, vp8_get_quantizer(ctx->cpi));
         MAP(VP8E_GET_LAST_QUANTIZER_64, vp8_reverse_trans(vp8_get_quantizer(ctx->cpi)));
+        MAP(VP8E_GET_HALFPEL_PLANES, vp8_get_halfpel_planes_kb(ctx->cpi));
     }
 
     return VPX_CODEC_OK;
@@ -514,6 +561,12 @@ static vpx_codec_err_t set_param(vpx_codec_alg_priv_t *ctx,
         MAP(VP8E_SET_TUNING,                xcfg.tuning);
         MAP(VP8E_SET_CQ_LEVEL,              xcfg.cq_level);
         MAP(VP8E_SET_MAX_INTRA_BITRATE_PCT, xcfg.rc_max_intra_bitrate_pct);
+        MAP(VP8E_SET_FIRST_PASS_DOWNSCALE,  xcfg.first_pass_downscale);
+        MAP(VP8E_SET_LF_ROW_SYNC,           xcfg.lf_row_sync);
+        MAP(VP8E_SET_TOKEN_ROW_SYNC,        xcfg.token_row_sync);
+        MAP(VP8E_SET_HALFPEL_PLANES,        xcfg.halfpel_planes_kb);
+        MAP(VP8E_SET_SCREEN_CONTENT,        xcfg.screen_content);
+        MAP(VP8E_SET_AUTO_ACTIVE_MAP,       xcfg.auto_active_map);
 
     }
 
@@ -536,10 +589,8 @@ static vpx_codec_err_t vp8e_mr_alloc_mem(const vpx_codec_enc_cfg_t *cfg,
     vpx_codec_err_t res = 0;
 
 #if CONFIG_MULTI_RES_ENCODING
-    int mb_rows = ((cfg->g_w + 15) >>4);
-    int mb_cols = ((cfg->g_h + 15) >>4);
-
-    *mem_loc = calloc(mb_rows*mb_cols, sizeof(LOWER_RES_INFO));
+    /* The encoders keep their own mode info, and find each other in here */
+    *mem_loc = calloc(1, sizeof(MR_SHARED_INFO));
     if(!(*mem_loc))
     {
         free(*mem_loc);
@@ -628,6 +679,12 @@ static vpx_codec_err_t vp8e_init(vpx_codec_ctx_t *ctx,
                              ctx->priv->alg_priv->vp8_cfg,
                              mr_cfg);
 
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+            if (mr_cfg && mr_cfg->mr_total_resolutions > 1
+                && (ctx->init_flags & VPX_CODEC_USE_MR_PIPELINE))
+                ctx->priv->alg_priv->oxcf.mr_pipeline = 1;
+#endif
+
             optr = vp8_create_compressor(&ctx->priv->alg_priv->oxcf);
 
             if (!optr)
@@ -643,9 +700,36 @@ static vpx_codec_err_t vp8e_init(vpx_codec_ctx_t *ctx,
 static vpx_codec_err_t vp8e_destroy(vpx_codec_alg_priv_t *ctx)
 {
 #if CONFIG_MULTI_RES_ENCODING
-    /* Free multi-encoder shared memory */
-    if (ctx->oxcf.mr_total_resolutions > 0 && (ctx->oxcf.mr_encoder_id == ctx->oxcf.mr_total_resolutions-1))
-        free(ctx->oxcf.mr_low_res_mode_info);
+    MR_SHARED_INFO *shared = (MR_SHARED_INFO *)ctx->oxcf.mr_low_res_mode_info;
+
+    if (ctx->oxcf.mr_total_resolutions > 0 && shared)
+    {
+        unsigned int id = ctx->oxcf.mr_encoder_id;
+
+#if CONFIG_MULTITHREAD
+        /* The encoders still running may read this one's mode info and
+         * progress, so stop them all before it goes away.
+         */
+        if (ctx->oxcf.mr_pipeline)
+        {
+            unsigned int i;
+
+            for (i = 0; i < ctx->oxcf.mr_total_resolutions; i++)
+                if (shared->cpi[i])
+                    vp8cx_finish_async(shared->cpi[i]);
+        }
+#endif
+
+        if (ctx->cpi && shared->cpi[id] == ctx->cpi)
+        {
+            shared->cpi[id] = NULL;
+            shared->num_encoders--;
+        }
+
+        /* Free multi-encoder shared memory */
+        if (!shared->num_encoders)
+            free(shared);
+    }
 #endif
 
     free(ctx->cx_data);
@@ -732,6 +816,153 @@ static void pick_quickcompress_mode(vpx_codec_alg_priv_t  *ctx,
 }
 
 
+/* Compresses the frames the encoder has ready, and queues their packets. */
+static vpx_codec_err_t encode_frames(vpx_codec_alg_priv_t *ctx, int flush)
+{
+    unsigned int lib_flags;
+    int64_t dst_time_stamp, dst_end_time_stamp;
+    unsigned long size, cx_data_sz;
+    unsigned char *cx_data;
+    unsigned char *cx_data_end;
+    int comp_data_state = 0;
+
+    cx_data = ctx->cx_data;
+    cx_data_sz = ctx->cx_data_sz;
+    cx_data_end = ctx->cx_data + cx_data_sz;
+    lib_flags = 0;
+
+    while (cx_data_sz >= ctx->cx_data_sz / 2)
+    {
+        comp_data_state = vp8_get_compressed_data(ctx->cpi,
+                                              &lib_flags,
+                                              &size,
+                                              cx_data,
+                                              cx_data_end,
+                                              &dst_time_stamp,
+                                              &dst_end_time_stamp,
+                                              flush);
+
+        if(comp_data_state == VPX_CODEC_CORRUPT_FRAME)
+            return VPX_CODEC_CORRUPT_FRAME;
+        else if(comp_data_state == -1)
+            break;
+
+        if (size)
+        {
+            vpx_codec_pts_t    round, delta;
+            vpx_codec_cx_pkt_t pkt;
+            VP8_COMP *cpi = (VP8_COMP *)ctx->cpi;
+
+            /* Add the frame packet to the list of returned packets. */
+            round = 1000000 * ctx->cfg.g_timebase.num / 2 - 1;
+            delta = (dst_end_time_stamp - dst_time_stamp);
+            pkt.kind = VPX_CODEC_CX_FRAME_PKT;
+            pkt.data.frame.pts =
+                (dst_time_stamp * ctx->cfg.g_timebase.den + round)
+                / ctx->cfg.g_timebase.num / 10000000;
+            pkt.data.frame.duration =
+                (delta * ctx->cfg.g_timebase.den + round)
+                / ctx->cfg.g_timebase.num / 10000000;
+            pkt.data.frame.flags = lib_flags << 16;
+
+            if (lib_flags & FRAMEFLAGS_KEY)
+                pkt.data.frame.flags |= VPX_FRAME_IS_KEY;
+
+            if (!cpi->common.show_frame)
+            {
+                pkt.data.frame.flags |= VPX_FRAME_IS_INVISIBLE;
+
+                // This timestamp should be as close as possible to the
+                // prior PTS so that if a decoder uses pts to schedule when
+                // to do this, we start right after last frame was decoded.
+                // Invisible frames have no duration.
+                pkt.data.frame.pts = ((cpi->last_time_stamp_seen
+                    * ctx->cfg.g_timebase.den + round)
+                    / ctx->cfg.g_timebase.num / 10000000) + 1;
+                pkt.data.frame.duration = 0;
+            }
+
+            if (cpi->droppable)
+                pkt.data.frame.flags |= VPX_FRAME_IS_DROPPABLE;
+
+            if (cpi->output_partition)
+            {
+                int i;
+                const int num_partitions =
+                        (1 << cpi->common.multi_token_partition) + 1;
+
+                pkt.data.frame.flags |= VPX_FRAME_IS_FRAGMENT;
+
+                for (i = 0; i < num_partitions; ++i)
+                {
+                    pkt.data.frame.buf = cx_data;
+                    pkt.data.frame.sz = cpi->partition_sz[i];
+                    pkt.data.frame.partition_id = i;
+                    /* don't set the fragment bit for the last partition */
+                    if (i == (num_partitions - 1))
+                        pkt.data.frame.flags &= ~VPX_FRAME_IS_FRAGMENT;
+                    vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
+                    cx_data += cpi->partition_sz[i];
+                    cx_data_sz -= cpi->partition_sz[i];
+                }
+            }
+            else
+            {
+                pkt.data.frame.buf = cx_data;
+                pkt.data.frame.sz  = size;
+                pkt.data.frame.partition_id = -1;
+                vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
+                cx_data += size;
+                cx_data_sz -= size;
+            }
+
+            //printf("timestamp: %lld, duration: %d\n", pkt->data.frame.pts, pkt->data.frame.duration);
+        }
+    }
+
+    return VPX_CODEC_OK;
+}
+
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+static int encode_frames_async(void *data)
+{
+    vpx_codec_alg_priv_t *ctx = (vpx_codec_alg_priv_t *)data;
+
+    return encode_frames(ctx, ctx->mr_flush);
+}
+
+/* vpx_codec_encode() calls the encoders from the lowest resolution up. All
+ * but the highest one only start compressing here, and the highest one waits
+ * for them once it's done, so they all run at the same time.
+ */
+static vpx_codec_err_t mr_pipeline_encode_frames(vpx_codec_alg_priv_t *ctx,
+                                                 int flush)
+{
+    MR_SHARED_INFO *shared = (MR_SHARED_INFO *)ctx->oxcf.mr_low_res_mode_info;
+    unsigned int i;
+    vpx_codec_err_t res;
+
+    if (ctx->oxcf.mr_encoder_id < ctx->oxcf.mr_total_resolutions - 1)
+    {
+        ctx->mr_flush = flush;
+        vp8cx_start_async(ctx->cpi, encode_frames_async, ctx);
+        return VPX_CODEC_OK;
+    }
+
+    res = encode_frames(ctx, flush);
+
+    for (i = 0; i < ctx->oxcf.mr_encoder_id; i++)
+    {
+        vpx_codec_err_t layer_res = vp8cx_finish_async(shared->cpi[i]);
+
+        if (!res)
+            res = layer_res;
+    }
+
+    return res;
+}
+#endif
+
 static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
                                    const vpx_image_t     *img,
                                    vpx_codec_pts_t        pts,
@@ -747,6 +978,12 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
     if (!res)
         res = validate_config(ctx, &ctx->cfg, &ctx->vp8_cfg, 1);
 
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+    /* In case nobody waited for the last frame */
+    if (ctx->oxcf.mr_pipeline && ctx->cpi)
+        vp8cx_finish_async(ctx->cpi);
+#endif
+
     pick_quickcompress_mode(ctx, duration, deadline);
     vpx_codec_pkt_list_init(&ctx->pkt_list);
 
@@ -815,10 +1052,7 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
         unsigned int lib_flags;
         YV12_BUFFER_CONFIG sd;
         int64_t dst_time_stamp, dst_end_time_stamp;
-        unsigned long size, cx_data_sz;
-        unsigned char *cx_data;
-        unsigned char *cx_data_end;
-        int comp_data_state = 0;
+        vpx_codec_err_t cx_res;
 
         /* Set up internal flags */
         if (ctx->base.init_flags & VPX_CODEC_USE_PSNR)
@@ -849,99 +1083,15 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
             ctx->next_frame_flag = 0;
         }
 
-        cx_data = ctx->cx_data;
-        cx_data_sz = ctx->cx_data_sz;
-        cx_data_end = ctx->cx_data + cx_data_sz;
-        lib_flags = 0;
-
-        while (cx_data_sz >= ctx->cx_data_sz / 2)
-        {
-            comp_data_state = vp8_get_compressed_data(ctx->cpi,
-                                                  &lib_flags,
-                                                  &size,
-                                                  cx_data,
-                                                  cx_data_end,
-                                                  &dst_time_stamp,
-                                                  &dst_end_time_stamp,
-                                                  !img);
-
-            if(comp_data_state == VPX_CODEC_CORRUPT_FRAME)
-                return VPX_CODEC_CORRUPT_FRAME;
-            else if(comp_data_state == -1)
-                break;
-
-            if (size)
-            {
-                vpx_codec_pts_t    round, delta;
-                vpx_codec_cx_pkt_t pkt;
-                VP8_COMP *cpi = (VP8_COMP *)ctx->cpi;
-
-                /* Add the frame packet to the list of returned packets. */
-                round = 1000000 * ctx->cfg.g_timebase.num / 2 - 1;
-                delta = (dst_end_time_stamp - dst_time_stamp);
-                pkt.kind = VPX_CODEC_CX_FRAME_PKT;
-                pkt.data.frame.pts =
-                    (dst_time_stamp * ctx->cfg.g_timebase.den + round)
-                    / ctx->cfg.g_timebase.num / 10000000;
-                pkt.data.frame.duration =
-                    (delta * ctx->cfg.g_timebase.den + round)
-                    / ctx->cfg.g_timebase.num / 10000000;
-                pkt.data.frame.flags = lib_flags << 16;
-
-                if (lib_flags & FRAMEFLAGS_KEY)
-                    pkt.data.frame.flags |= VPX_FRAME_IS_KEY;
-
-                if (!cpi->common.show_frame)
-                {
-                    pkt.data.frame.flags |= VPX_FRAME_IS_INVISIBLE;
-
-                    // This timestamp should be as close as possible to the
-                    // prior PTS so that if a decoder uses pts to schedule when
-                    // to do this, we start right after last frame was decoded.
-                    // Invisible frames have no duration.
-                    pkt.data.frame.pts = ((cpi->last_time_stamp_seen
-                        * ctx->cfg.g_timebase.den + round)
-                        / ctx->cfg.g_timebase.num / 10000000) + 1;
-                    pkt.data.frame.duration = 0;
-                }
-
-                if (cpi->droppable)
-                    pkt.data.frame.flags |= VPX_FRAME_IS_DROPPABLE;
-
-                if (cpi->output_partition)
-                {
-                    int i;
-                    const int num_partitions =
-                            (1 << cpi->common.multi_token_partition) + 1;
-
-                    pkt.data.frame.flags |= VPX_FRAME_IS_FRAGMENT;
-
-                    for (i = 0; i < num_partitions; ++i)
-                    {
-                        pkt.data.frame.buf = cx_data;
-                        pkt.data.frame.sz = cpi->partition_sz[i];
-                        pkt.data.frame.partition_id = i;
-                        /* don't set the fragment bit for the last partition */
-                        if (i == (num_partitions - 1))
-                            pkt.data.frame.flags &= ~VPX_FRAME_IS_FRAGMENT;
-                        vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
-                        cx_data += cpi->partition_sz[i];
-                        cx_data_sz -= cpi->partition_sz[i];
-                    }
-                }
-                else
-                {
-                    pkt.data.frame.buf = cx_data;
-                    pkt.data.frame.sz  = size;
-                    pkt.data.frame.partition_id = -1;
-                    vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
-                    cx_data += size;
-                    cx_data_sz -= size;
-                }
+#if CONFIG_MULTI_RES_ENCODING && CONFIG_MULTITHREAD
+        if (ctx->oxcf.mr_pipeline)
+            cx_res = mr_pipeline_encode_frames(ctx, !img);
+        else
+#endif
+            cx_res = encode_frames(ctx, !img);
 
-                //printf("timestamp: %lld, duration: %d\n", pkt->data.frame.pts, pkt->data.frame.duration);
-            }
-        }
+        if (cx_res)
+            return cx_res;
     }
 
     return res;
@@ -1140,6 +1290,23 @@ static vpx_codec_err_t vp8e_set_activemap(vpx_codec_alg_priv_t *ctx,
         return VPX_CODEC_INVALID_PARAM;
 }
 
+static vpx_codec_err_t vp8e_set_mb_hints(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    vpx_mb_hint_map_t *data = va_arg(args, vpx_mb_hint_map_t *);
+
+    if (data)
+    {
+        if (!vp8_set_mb_hints(ctx->cpi, data))
+            return VPX_CODEC_OK;
+        else
+            return VPX_CODEC_INVALID_PARAM;
+    }
+    else
+        return VPX_CODEC_INVALID_PARAM;
+}
+
 static vpx_codec_err_t vp8e_set_scalemode(vpx_codec_alg_priv_t *ctx,
         int ctr_id,
         va_list args)
@@ -1177,6 +1344,8 @@ static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] =
     {VP8E_USE_REFERENCE,                vp8e_use_reference},
     {VP8E_SET_ROI_MAP,                  vp8e_set_roi_map},
     {VP8E_SET_ACTIVEMAP,                vp8e_set_activemap},
+    {VP8E_SET_MB_HINTS,                 vp8e_set_mb_hints},
+    {VP8E_SET_AUTO_ACTIVE_MAP,          set_param},
     {VP8E_SET_SCALEMODE,                vp8e_set_scalemode},
     {VP8E_SET_ENCODING_MODE,            set_param},
     {VP8E_SET_CPUUSED,                  set_param},
@@ -1193,6 +1362,12 @@ static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] =
     {VP8E_SET_TUNING,                   set_param},
     {VP8E_SET_CQ_LEVEL,                 set_param},
     {VP8E_SET_MAX_INTRA_BITRATE_PCT,    set_param},
+    {VP8E_SET_FIRST_PASS_DOWNSCALE,     set_param},
+    {VP8E_SET_LF_ROW_SYNC,              set_param},
+    {VP8E_SET_TOKEN_ROW_SYNC,           set_param},
+    {VP8E_SET_HALFPEL_PLANES,           set_param},
+    {VP8E_GET_HALFPEL_PLANES,           get_param},
+    {VP8E_SET_SCREEN_CONTENT,           set_param},
     { -1, NULL},
 };
 
@@ -1253,6 +1428,8 @@ static vpx_codec_enc_cfg_map_t vp8e_usage_cfg_map[] =
         {0},                /* ts_rate_decimator */
         0,                  /* ts_periodicity */
         {0},                /* ts_layer_id */
+
+        0,                  /* g_pool_threads */
     }},
     { -1, {NOT_IMPLEMENTED}}
 };
@@ -1266,7 +1443,7 @@ CODEC_INTERFACE(vpx_codec_vp8_cx) =
     "WebM Project VP8 Encoder" VERSION_STRING,
     VPX_CODEC_INTERNAL_ABI_VERSION,
     VPX_CODEC_CAP_ENCODER | VPX_CODEC_CAP_PSNR |
-    VPX_CODEC_CAP_OUTPUT_PARTITION,
+    VPX_CODEC_CAP_OUTPUT_PARTITION | VP8_CAP_MR_PIPELINE,
     /* vpx_codec_caps_t          caps; */
     vp8e_init,          /* vpx_codec_init_fn_t       init; */
     vp8e_destroy,       /* vpx_codec_destroy_fn_t    destroy; */
@@ -20,11 +20,14 @@
 
 #if CONFIG_OPENCL
 #include "common/opencl/vp8_opencl.h"
+#include "common/opencl/profile_cl.h"
 #endif
 
 #define VP8_CAP_POSTPROC (CONFIG_POSTPROC ? VPX_CODEC_CAP_POSTPROC : 0)
 #define VP8_CAP_ERROR_CONCEALMENT (CONFIG_ERROR_CONCEALMENT ? \
                                     VPX_CODEC_CAP_ERROR_CONCEALMENT : 0)
+#define VP8_CAP_ASYNC_LOOPFILTER (CONFIG_OPENCL ? \
+                                    VPX_CODEC_CAP_ASYNC_LOOPFILTER : 0)
 
 typedef vpx_codec_stream_info_t  vp8_stream_info_t;
 
@@ -74,6 +77,7 @@ struct vpx_codec_alg_priv
     vpx_image_t             img;
     int                     img_setup;
     int                     img_avail;
+    int                     cl_profiling;
 };
 
 static unsigned long vp8_priv_sz(const vpx_codec_dec_cfg_t *si, vpx_codec_flags_t flags)
@@ -415,6 +419,13 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
                     (ctx->base.init_flags & VPX_CODEC_USE_ERROR_CONCEALMENT);
             oxcf.input_fragments =
                     (ctx->base.init_flags & VPX_CODEC_USE_INPUT_FRAGMENTS);
+            /* Postprocessing works on the most recently decoded frame, so
+             * it can't be combined with the delayed output.
+             */
+            oxcf.async_loopfilter =
+                    (ctx->base.init_flags & VPX_CODEC_USE_ASYNC_LOOPFILTER) &&
+                    !(ctx->base.init_flags & VPX_CODEC_USE_POSTPROC);
+            oxcf.cl_profiling = ctx->cl_profiling;
 
             optr = vp8dx_create_decompressor(&oxcf);
 
@@ -754,6 +765,112 @@ static vpx_codec_err_t vp8_get_frame_corrupted(vpx_codec_alg_priv_t *ctx,
 
 }
 
+static vpx_codec_err_t vp8_set_cl_profiling(vpx_codec_alg_priv_t *ctx,
+                                            int ctrl_id,
+                                            va_list args)
+{
+#if CONFIG_OPENCL
+    int data = va_arg(args, int);
+
+    /* The command queue is created along with the decoder. */
+    if (ctx->decoder_init)
+        return VPX_CODEC_ERROR;
+
+    ctx->cl_profiling = data;
+    return VPX_CODEC_OK;
+#else
+    return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+static vpx_codec_err_t vp8_get_cl_profile(vpx_codec_alg_priv_t *ctx,
+                                          int ctrl_id,
+                                          va_list args)
+{
+#if CONFIG_OPENCL
+    vp8_cl_profile_t *profile = va_arg(args, vp8_cl_profile_t *);
+    VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
+
+    if (profile && pbi)
+    {
+        vp8_cl_profile_get(&pbi->cl_profile, profile);
+        return VPX_CODEC_OK;
+    }
+    else
+        return VPX_CODEC_INVALID_PARAM;
+#else
+    return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+static vpx_codec_err_t vp8_get_mb_hints(vpx_codec_alg_priv_t *ctx,
+                                        int ctrl_id,
+                                        va_list args)
+{
+    static const vpx_ref_frame_type_t ref_frames[MAX_REF_FRAMES] =
+    {
+        0, VP8_LAST_FRAME, VP8_GOLD_FRAME, VP8_ALTR_FRAME
+    };
+    vpx_mb_hint_map_t *map = va_arg(args, vpx_mb_hint_map_t *);
+    VP8D_COMP *pbi = (VP8D_COMP *)ctx->pbi;
+    VP8_COMMON *oci;
+    const MODE_INFO *mi;
+    unsigned int row, col;
+    int i;
+
+    if (!map || !map->hints || !pbi)
+        return VPX_CODEC_INVALID_PARAM;
+
+    oci = &pbi->common;
+
+    if (map->rows != (unsigned int)oci->mb_rows ||
+        map->cols != (unsigned int)oci->mb_cols)
+        return VPX_CODEC_INVALID_PARAM;
+
+    mi = oci->mi;
+#if CONFIG_ERROR_CONCEALMENT
+    /* The modes of the last frame were swapped out for concealment */
+    if (pbi->ec_enabled && oci->prev_mi)
+        mi = oci->prev_mi;
+#endif
+
+    for (row = 0; row < map->rows; row++)
+    {
+        for (col = 0; col < map->cols; col++)
+        {
+            const MODE_INFO *m = mi + row * oci->mode_info_stride + col;
+            vpx_mb_hint_t *hint = map->hints + row * map->cols + col;
+
+            hint->ref_frame = ref_frames[m->mbmi.ref_frame];
+
+            if (m->mbmi.ref_frame == INTRA_FRAME)
+                hint->mode = VP8_MB_HINT_INTRA;
+            else if (m->mbmi.mode == SPLITMV)
+                hint->mode = VP8_MB_HINT_SPLIT;
+            else
+                hint->mode = VP8_MB_HINT_INTER;
+
+            /* MODE_INFO keeps the MVs in 1/8 pel */
+            for (i = 0; i < 16; i++)
+            {
+                int_mv mv;
+
+                if (hint->mode == VP8_MB_HINT_SPLIT)
+                    mv.as_int = m->bmi[i].mv.as_int;
+                else if (hint->mode == VP8_MB_HINT_INTER)
+                    mv.as_int = m->mbmi.mv.as_int;
+                else
+                    mv.as_int = 0;
+
+                hint->mv[i][0] = mv.as_mv.row >> 1;
+                hint->mv[i][1] = mv.as_mv.col >> 1;
+            }
+        }
+    }
+
+    return VPX_CODEC_OK;
+}
+
 vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] =
 {
     {VP8_SET_REFERENCE,             vp8_set_reference},
@@ -766,6 +883,9 @@ vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] =
     {VP8D_GET_LAST_REF_UPDATES,     vp8_get_last_ref_updates},
     {VP8D_GET_FRAME_CORRUPTED,      vp8_get_frame_corrupted},
     {VP8D_GET_LAST_REF_USED,        vp8_get_last_ref_frame},
+    {VP8D_SET_CL_PROFILING,         vp8_set_cl_profiling},
+    {VP8D_GET_CL_PROFILE,           vp8_get_cl_profile},
+    {VP8D_GET_MB_HINTS,             vp8_get_mb_hints},
     { -1, NULL},
 };
 
@@ -778,7 +898,7 @@ CODEC_INTERFACE(vpx_codec_vp8_dx) =
     "WebM Project VP8 Decoder" VERSION_STRING,
     VPX_CODEC_INTERNAL_ABI_VERSION,
     VPX_CODEC_CAP_DECODER | VP8_CAP_POSTPROC | VP8_CAP_ERROR_CONCEALMENT |
-    VPX_CODEC_CAP_INPUT_FRAGMENTS,
+    VPX_CODEC_CAP_INPUT_FRAGMENTS | VP8_CAP_ASYNC_LOOPFILTER,
     /* vpx_codec_caps_t          caps; */
     vp8_init,         /* vpx_codec_init_fn_t       init; */
     vp8_destroy,      /* vpx_codec_destroy_fn_t    destroy; */
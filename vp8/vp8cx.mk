@@ -54,6 +54,11 @@ VP8_CX_SRCS-yes += encoder/firstpass.h
 VP8_CX_SRCS-yes += encoder/lookahead.c
 VP8_CX_SRCS-yes += encoder/lookahead.h
 VP8_CX_SRCS-yes += encoder/mcomp.h
+VP8_CX_SRCS-yes += encoder/mepyramid.h
+VP8_CX_SRCS-yes += encoder/halfpel.h
+VP8_CX_SRCS-yes += encoder/hashme.h
+VP8_CX_SRCS-yes += encoder/blocksum.h
+VP8_CX_SRCS-yes += encoder/mbhint.h
 VP8_CX_SRCS-yes += encoder/modecosts.h
 VP8_CX_SRCS-yes += encoder/onyx_int.h
 VP8_CX_SRCS-yes += encoder/pickinter.h
@@ -65,6 +70,11 @@ VP8_CX_SRCS-yes += encoder/tokenize.h
 VP8_CX_SRCS-yes += encoder/treewriter.h
 VP8_CX_SRCS-yes += encoder/variance.h
 VP8_CX_SRCS-yes += encoder/mcomp.c
+VP8_CX_SRCS-yes += encoder/mepyramid.c
+VP8_CX_SRCS-yes += encoder/halfpel.c
+VP8_CX_SRCS-yes += encoder/hashme.c
+VP8_CX_SRCS-yes += encoder/blocksum.c
+VP8_CX_SRCS-yes += encoder/mbhint.c
 VP8_CX_SRCS-yes += encoder/modecosts.c
 VP8_CX_SRCS-yes += encoder/onyx_if.c
 VP8_CX_SRCS-yes += encoder/pickinter.c
@@ -74,6 +84,7 @@ VP8_CX_SRCS-yes += encoder/quantize.c
 VP8_CX_SRCS-yes += encoder/ratectrl.c
 VP8_CX_SRCS-yes += encoder/rdopt.c
 VP8_CX_SRCS-yes += encoder/sad_c.c
+VP8_CX_SRCS-yes += encoder/satd_c.c
 VP8_CX_SRCS-yes += encoder/segmentation.c
 VP8_CX_SRCS-yes += encoder/segmentation.h
 VP8_CX_SRCS-$(CONFIG_INTERNAL_STATS) += encoder/ssim.c
@@ -106,6 +117,7 @@ VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/quantize_sse2.asm
 VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/subtract_sse2.asm
 VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/temporal_filter_apply_sse2.asm
 VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/vp8_enc_stubs_sse2.c
+VP8_CX_SRCS-$(HAVE_SSE2) += encoder/x86/satd_sse2.c
 VP8_CX_SRCS-$(HAVE_SSE3) += encoder/x86/sad_sse3.asm
 VP8_CX_SRCS-$(HAVE_SSSE3) += encoder/x86/sad_ssse3.asm
 VP8_CX_SRCS-$(HAVE_SSSE3) += encoder/x86/variance_ssse3.c
@@ -117,6 +129,13 @@ VP8_CX_SRCS-$(ARCH_X86)$(ARCH_X86_64) += encoder/x86/quantize_mmx.asm
 VP8_CX_SRCS-$(ARCH_X86)$(ARCH_X86_64) += encoder/x86/encodeopt.asm
 VP8_CX_SRCS-$(ARCH_X86_64) += encoder/x86/ssim_opt.asm
 
+# The SATD kernels are SSE2 intrinsics, which 32 bit x86 doesn't enable by
+# default
+ifeq ($(HAVE_SSE2),yes)
+vp8/encoder/x86/satd_sse2.c.o: CFLAGS += -msse2
+vp8/encoder/x86/satd_sse2.c.d: CFLAGS += -msse2
+endif
+
 ifeq ($(CONFIG_REALTIME_ONLY),yes)
 VP8_CX_SRCS_REMOVE-$(HAVE_SSE2) += encoder/x86/temporal_filter_apply_sse2.asm
 endif
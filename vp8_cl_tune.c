@@ -0,0 +1,46 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * Times the OpenCL loop filter variants on the current device and stores the
+ * fastest one in the OpenCL cache directory ($VPX_CL_CACHE_DIR), where the
+ * decoder picks it up automatically.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Not part of the public API, so this tool needs the static library. */
+extern int vp8_cl_loop_filter_autotune(int verbose);
+
+int main(int argc, char **argv)
+{
+    int verbose = 1;
+
+    if (argc > 1)
+    {
+        if (argc == 2 && (!strcmp(argv[1], "-q") || !strcmp(argv[1], "--quiet")))
+            verbose = 0;
+        else
+        {
+            fprintf(stderr, "Usage: %s [-q|--quiet]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (vp8_cl_loop_filter_autotune(verbose))
+    {
+        fprintf(stderr, "OpenCL loop filter tuning failed\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -263,7 +263,8 @@ int main(int argc, char **argv)
     /* Highest-resolution encoder settings */
     cfg[0].g_w = width;
     cfg[0].g_h = height;
-    cfg[0].g_threads = 1;                           /* number of threads used */
+    cfg[0].g_threads = 4;                           /* number of threads used */
+    cfg[0].g_pool_threads = 7;     /* all encoders share one pool of threads */
     cfg[0].rc_dropframe_thresh = 0;
     cfg[0].rc_end_usage = VPX_CBR;
     cfg[0].rc_resize_allowed = 0;
@@ -291,7 +292,7 @@ int main(int argc, char **argv)
     {
         memcpy(&cfg[i], &cfg[0], sizeof(vpx_codec_enc_cfg_t));
 
-        cfg[i].g_threads = 1;                       /* number of threads used */
+        cfg[i].g_threads = 2;                       /* number of threads used */
         cfg[i].rc_target_bitrate = target_bitrate[i];
 
         /* Note: Width & height of other-resolution encoders are calculated
@@ -325,8 +326,11 @@ int main(int argc, char **argv)
         write_ivf_file_header(outfile[i], &cfg[i], 0);
 
     /* Initialize multi-encoder */
+    /* Encode the resolutions at the same time, each one a few MB rows behind
+     * the next lower one. */
     if(vpx_codec_enc_init_multi(&codec[0], interface, &cfg[0], NUM_ENCODERS,
-                                (show_psnr ? VPX_CODEC_USE_PSNR : 0), &dsf[0]))
+                                (show_psnr ? VPX_CODEC_USE_PSNR : 0) |
+                                VPX_CODEC_USE_MR_PIPELINE, &dsf[0]))
         die_codec(&codec[0], "Failed to initialize encoder");
 
     /* The extra encoding configuration parameters can be set as follows. */
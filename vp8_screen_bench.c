@@ -0,0 +1,232 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * Encodes synthetic screen content, a page of text scrolling by a fixed
+ * number of lines per frame with a window moving over it, with and
+ * without VP8E_SET_SCREEN_CONTENT, and prints the size, quality and time
+ * of both encodes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "vpx_config.h"
+#define VPX_CODEC_DISABLE_COMPAT 1
+#include "vpx/vpx_encoder.h"
+#include "vpx/vp8cx.h"
+#include "vpx_ports/vpx_timer.h"
+#define interface (vpx_codec_vp8_cx())
+
+#define GLYPHS   64
+#define GLYPH_W  6
+#define GLYPH_H  9
+#define LINE_H   14
+#define WINDOW_W 160
+#define WINDOW_H 120
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    if(fmt[strlen(fmt)-1] != '\n')
+        printf("\n");
+    exit(EXIT_FAILURE);
+}
+
+static void die_codec(vpx_codec_ctx_t *ctx, const char *s) {
+    const char *detail = vpx_codec_error_detail(ctx);
+
+    printf("%s: %s\n", s, vpx_codec_error(ctx));
+    if(detail)
+        printf("    %s\n",detail);
+    exit(EXIT_FAILURE);
+}
+
+static unsigned int seed = 1;
+
+static unsigned int next_random(void) {
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+/* A page of lines of random glyphs, dark on light */
+static unsigned char *make_page(int width, int height) {
+    unsigned char glyphs[GLYPHS][GLYPH_H][GLYPH_W];
+    unsigned char *page = malloc(width * height);
+    int g, r, c, x, y;
+
+    if(!page)
+        die("Failed to allocate page");
+
+    for(g = 0; g < GLYPHS; g++)
+        for(r = 0; r < GLYPH_H; r++)
+            for(c = 0; c < GLYPH_W; c++)
+                glyphs[g][r][c] = next_random() % 100 < 45;
+
+    memset(page, 235, width * height);
+
+    for(y = 4; y + LINE_H < height; y += LINE_H) {
+        int line_end = 200 + next_random() % (width - 216);
+
+        for(x = 8; x + GLYPH_W + 1 < line_end; x += GLYPH_W + 1) {
+            if(next_random() % 100 < 15)
+                continue;
+
+            g = next_random() % GLYPHS;
+
+            for(r = 0; r < GLYPH_H; r++)
+                for(c = 0; c < GLYPH_W; c++)
+                    if(glyphs[g][r][c])
+                        page[(y + r) * width + x + c] = 30;
+        }
+    }
+
+    return page;
+}
+
+static void make_frame(vpx_image_t *img, const unsigned char *page,
+                       const unsigned char *window, int frame, int scroll) {
+    int wx = (40 + frame * 53) % (img->d_w - WINDOW_W);
+    int wy = (60 + frame * 29) % (img->d_h - WINDOW_H);
+    unsigned int r;
+
+    for(r = 0; r < img->d_h; r++)
+        memcpy(img->planes[0] + r * img->stride[0],
+               page + (frame * scroll + r) * img->d_w, img->d_w);
+
+    for(r = 0; r < WINDOW_H; r++)
+        memcpy(img->planes[0] + (wy + r) * img->stride[0] + wx,
+               window + r * WINDOW_W, WINDOW_W);
+
+    for(r = 0; r < (img->d_h + 1) / 2; r++) {
+        memset(img->planes[1] + r * img->stride[1], 128, (img->d_w + 1) / 2);
+        memset(img->planes[2] + r * img->stride[2], 128, (img->d_w + 1) / 2);
+    }
+}
+
+static void encode(int screen_content, int width, int height, int frames,
+                   int scroll, int q, int cpu_used,
+                   const unsigned char *page, const unsigned char *window) {
+    vpx_codec_ctx_t      codec;
+    vpx_codec_enc_cfg_t  cfg;
+    vpx_image_t          raw;
+    struct vpx_usec_timer timer;
+    long                 bytes = 0;
+    double               psnr = 0;
+    int                  psnr_count = 0;
+    double               usecs = 0;
+    int                  frame;
+
+    if(!vpx_img_alloc(&raw, VPX_IMG_FMT_I420, width, height, 1))
+        die("Failed to allocate image");
+
+    if(vpx_codec_enc_config_default(interface, &cfg, 0))
+        die("Failed to get config");
+
+    cfg.g_w = width;
+    cfg.g_h = height;
+    cfg.g_timebase.num = 1;
+    cfg.g_timebase.den = 30;
+    cfg.g_lag_in_frames = 0;
+    cfg.rc_end_usage = VPX_CBR;
+    cfg.rc_target_bitrate = 50000;
+    cfg.rc_min_quantizer = q;
+    cfg.rc_max_quantizer = q;
+    cfg.kf_mode = VPX_KF_DISABLED;
+
+    if(vpx_codec_enc_init(&codec, interface, &cfg, VPX_CODEC_USE_PSNR))
+        die_codec(&codec, "Failed to initialize encoder");
+
+    if(vpx_codec_control(&codec, VP8E_SET_CPUUSED, cpu_used)
+       || vpx_codec_control(&codec, VP8E_SET_SCREEN_CONTENT, screen_content))
+        die_codec(&codec, "Failed to set controls");
+
+    for(frame = 0; frame <= frames; frame++) {
+        vpx_codec_iter_t iter = NULL;
+        const vpx_codec_cx_pkt_t *pkt;
+
+        if(frame < frames)
+            make_frame(&raw, page, window, frame, scroll);
+
+        vpx_usec_timer_start(&timer);
+        if(vpx_codec_encode(&codec, frame < frames ? &raw : NULL, frame, 1,
+                            0, cpu_used < 0 ? VPX_DL_REALTIME
+                                            : VPX_DL_GOOD_QUALITY))
+            die_codec(&codec, "Failed to encode frame");
+        vpx_usec_timer_mark(&timer);
+        usecs += vpx_usec_timer_elapsed(&timer);
+
+        while((pkt = vpx_codec_get_cx_data(&codec, &iter))) {
+            if(pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+                bytes += pkt->data.frame.sz;
+            else if(pkt->kind == VPX_CODEC_PSNR_PKT) {
+                psnr += pkt->data.psnr.psnr[1];
+                psnr_count++;
+            }
+        }
+    }
+
+    printf("screen content %d: %8.1f kbps  Y PSNR %6.3f  %6.2f fps\n",
+           screen_content, bytes * 8.0 * 30 / frames / 1000,
+           psnr_count ? psnr / psnr_count : 0,
+           usecs ? frames * 1000000.0 / usecs : 0);
+
+    vpx_img_free(&raw);
+
+    if(vpx_codec_destroy(&codec))
+        die_codec(&codec, "Failed to destroy codec");
+}
+
+int main(int argc, char **argv) {
+    int width = 640, height = 480, frames = 30, scroll = 37;
+    int q = 40, cpu_used = -6;
+    unsigned char *page, *window;
+    int i;
+
+    if(argc > 7 || argc == 2 || argc == 6)
+        die("Usage: %s [<frames> <scroll> <q> <cpu-used> <width> <height>]\n"
+            "Defaults: 30 frames scrolling 37 lines, q 40, cpu-used -6, "
+            "640x480\n", argv[0]);
+
+    if(argc > 2) {
+        frames = strtol(argv[1], NULL, 0);
+        scroll = strtol(argv[2], NULL, 0);
+    }
+    if(argc > 3)
+        q = strtol(argv[3], NULL, 0);
+    if(argc > 4)
+        cpu_used = strtol(argv[4], NULL, 0);
+    if(argc > 6) {
+        width = strtol(argv[5], NULL, 0);
+        height = strtol(argv[6], NULL, 0);
+    }
+
+    if(frames < 1 || scroll < 0 || q < 0 || q > 63
+       || width < 2 * WINDOW_W || height < 2 * WINDOW_H)
+        die("Invalid parameters");
+
+    page = make_page(width, height + frames * scroll);
+    window = malloc(WINDOW_W * WINDOW_H);
+    if(!window)
+        die("Failed to allocate window");
+
+    for(i = 0; i < WINDOW_W * WINDOW_H; i++)
+        window[i] = 60 + next_random() % 3 * 70;
+
+    encode(0, width, height, frames, scroll, q, cpu_used, page, window);
+    encode(1, width, height, frames, scroll, q, cpu_used, page, window);
+
+    free(page);
+    free(window);
+    return EXIT_SUCCESS;
+}
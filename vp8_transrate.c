@@ -0,0 +1,286 @@
+/*
+ *  Copyright (c) 2011 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/*
+ * Transrates a VP8 IVF file to another bitrate, passing the modes and MVs
+ * of each decoded frame to the encoder as hints (VP8D_GET_MB_HINTS and
+ * VP8E_SET_MB_HINTS) and mirroring the golden and altref updates of the
+ * input so that the hinted references match. Prints the size, quality and
+ * encoding time of the output.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include "vpx_config.h"
+#define VPX_CODEC_DISABLE_COMPAT 1
+#include "vpx/vpx_decoder.h"
+#include "vpx/vpx_encoder.h"
+#include "vpx/vp8dx.h"
+#include "vpx/vp8cx.h"
+#include "vpx_ports/vpx_timer.h"
+#define fourcc    0x30385056
+
+#define IVF_FILE_HDR_SZ  (32)
+#define IVF_FRAME_HDR_SZ (12)
+
+static unsigned int mem_get_le16(const unsigned char *mem) {
+    return (mem[1] << 8)|(mem[0]);
+}
+
+static unsigned int mem_get_le32(const unsigned char *mem) {
+    return (mem[3] << 24)|(mem[2] << 16)|(mem[1] << 8)|(mem[0]);
+}
+
+static vpx_codec_pts_t frame_pts(const unsigned char *frame_hdr) {
+    return mem_get_le32(frame_hdr + 4)
+           | (vpx_codec_pts_t)mem_get_le32(frame_hdr + 8) << 32;
+}
+
+static void mem_put_le16(char *mem, unsigned int val) {
+    mem[0] = val;
+    mem[1] = val>>8;
+}
+
+static void mem_put_le32(char *mem, unsigned int val) {
+    mem[0] = val;
+    mem[1] = val>>8;
+    mem[2] = val>>16;
+    mem[3] = val>>24;
+}
+
+static void die(const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    if(fmt[strlen(fmt)-1] != '\n')
+        printf("\n");
+    exit(EXIT_FAILURE);
+}
+
+static void die_codec(vpx_codec_ctx_t *ctx, const char *s) {
+    const char *detail = vpx_codec_error_detail(ctx);
+
+    printf("%s: %s\n", s, vpx_codec_error(ctx));
+    if(detail)
+        printf("    %s\n",detail);
+    exit(EXIT_FAILURE);
+}
+
+static void write_ivf_file_header(FILE *outfile,
+                                  const vpx_codec_enc_cfg_t *cfg,
+                                  int frame_cnt) {
+    char header[32];
+
+    header[0] = 'D';
+    header[1] = 'K';
+    header[2] = 'I';
+    header[3] = 'F';
+    mem_put_le16(header+4,  0);                   /* version */
+    mem_put_le16(header+6,  32);                  /* headersize */
+    mem_put_le32(header+8,  fourcc);              /* headersize */
+    mem_put_le16(header+12, cfg->g_w);            /* width */
+    mem_put_le16(header+14, cfg->g_h);            /* height */
+    mem_put_le32(header+16, cfg->g_timebase.den); /* rate */
+    mem_put_le32(header+20, cfg->g_timebase.num); /* scale */
+    mem_put_le32(header+24, frame_cnt);           /* length */
+    mem_put_le32(header+28, 0);                   /* unused */
+
+    if(fwrite(header, 1, 32, outfile));
+}
+
+static void write_ivf_frame_header(FILE *outfile,
+                                   const vpx_codec_cx_pkt_t *pkt)
+{
+    char             header[12];
+    vpx_codec_pts_t  pts;
+
+    pts = pkt->data.frame.pts;
+    mem_put_le32(header, pkt->data.frame.sz);
+    mem_put_le32(header+4, pts&0xFFFFFFFF);
+    mem_put_le32(header+8, pts >> 32);
+
+    if(fwrite(header, 1, 12, outfile));
+}
+
+int main(int argc, char **argv) {
+    FILE                *infile, *outfile;
+    vpx_codec_ctx_t      decoder, encoder;
+    vpx_codec_enc_cfg_t  cfg;
+    vpx_mb_hint_map_t    map;
+    struct vpx_usec_timer timer;
+    unsigned char        file_hdr[IVF_FILE_HDR_SZ];
+    unsigned char        frame_hdr[IVF_FRAME_HDR_SZ];
+    unsigned char        next_hdr[IVF_FRAME_HDR_SZ];
+    vpx_codec_pts_t      pts = 0, first_pts = 0;
+    unsigned long        duration = 1;
+    unsigned char       *frame = NULL;
+    unsigned int         frame_buf_sz = 0;
+    int                  hint_mode, cpu_used = -6;
+    int                  frame_cnt = 0;
+    long                 bytes = 0;
+    double               psnr = 0;
+    int                  psnr_count = 0;
+    double               usecs = 0;
+    int                  done = 0;
+
+    if(argc != 5 && argc != 6)
+        die("Usage: %s <infile> <outfile> <kbps> <hints> [<cpu-used>]\n"
+            "Hints: 0 none, 1 as first candidates, 2 only. "
+            "Default cpu-used -6\n", argv[0]);
+
+    hint_mode = strtol(argv[4], NULL, 0);
+    if(argc > 5)
+        cpu_used = strtol(argv[5], NULL, 0);
+
+    if(!(infile = fopen(argv[1], "rb")))
+        die("Failed to open %s for reading", argv[1]);
+    if(!(outfile = fopen(argv[2], "wb")))
+        die("Failed to open %s for writing", argv[2]);
+
+    if(!(fread(file_hdr, 1, IVF_FILE_HDR_SZ, infile) == IVF_FILE_HDR_SZ
+         && file_hdr[0]=='D' && file_hdr[1]=='K' && file_hdr[2]=='I'
+         && file_hdr[3]=='F'))
+        die("%s is not an IVF file.", argv[1]);
+
+    if(vpx_codec_enc_config_default(vpx_codec_vp8_cx(), &cfg, 0))
+        die("Failed to get config");
+
+    cfg.g_w = mem_get_le16(file_hdr + 12);
+    cfg.g_h = mem_get_le16(file_hdr + 14);
+    cfg.g_timebase.den = mem_get_le32(file_hdr + 16);
+    cfg.g_timebase.num = mem_get_le32(file_hdr + 20);
+    cfg.g_lag_in_frames = 0;
+    cfg.rc_target_bitrate = strtol(argv[3], NULL, 0);
+    cfg.kf_mode = VPX_KF_DISABLED;   /* Key frames follow the input */
+
+    map.rows = (cfg.g_h + 15) / 16;
+    map.cols = (cfg.g_w + 15) / 16;
+    map.only = hint_mode == 2;
+    map.hints = malloc(map.rows * map.cols * sizeof(*map.hints));
+    if(!map.hints)
+        die("Failed to allocate hints");
+
+    if(vpx_codec_dec_init(&decoder, vpx_codec_vp8_dx(), NULL, 0))
+        die_codec(&decoder, "Failed to initialize decoder");
+    if(vpx_codec_enc_init(&encoder, vpx_codec_vp8_cx(), &cfg,
+                          VPX_CODEC_USE_PSNR))
+        die_codec(&encoder, "Failed to initialize encoder");
+    if(vpx_codec_control(&encoder, VP8E_SET_CPUUSED, cpu_used))
+        die_codec(&encoder, "Failed to set cpu-used");
+
+    write_ivf_file_header(outfile, &cfg, 0);
+
+    while(!done) {
+        vpx_codec_iter_t           iter = NULL;
+        const vpx_codec_cx_pkt_t  *pkt;
+        vpx_image_t               *img = NULL;
+        vpx_enc_frame_flags_t      flags = 0;
+
+        if(fread(frame_hdr, 1, IVF_FRAME_HDR_SZ, infile) == IVF_FRAME_HDR_SZ) {
+            unsigned int frame_sz = mem_get_le32(frame_hdr);
+            int          updates = 0;
+
+            if(frame_sz > frame_buf_sz) {
+                frame_buf_sz = frame_sz;
+                frame = realloc(frame, frame_buf_sz);
+                if(!frame)
+                    die("Failed to allocate frame buffer");
+            }
+            if(fread(frame, 1, frame_sz, infile) != frame_sz)
+                die("Failed to read full frame");
+
+            /* Each frame lasts until the next one starts */
+            pts = frame_pts(frame_hdr);
+            if(fread(next_hdr, 1, IVF_FRAME_HDR_SZ, infile)
+               == IVF_FRAME_HDR_SZ) {
+                if(frame_pts(next_hdr) > pts)
+                    duration = (unsigned long)(frame_pts(next_hdr) - pts);
+                fseek(infile, -IVF_FRAME_HDR_SZ, SEEK_CUR);
+            }
+            if(!frame_cnt)
+                first_pts = pts;
+
+            if(vpx_codec_decode(&decoder, frame, frame_sz, NULL, 0))
+                die_codec(&decoder, "Failed to decode frame");
+
+            img = vpx_codec_get_frame(&decoder, &iter);
+            if(!img)
+                continue;   /* Hidden frames can not be mirrored */
+
+            if(vpx_codec_control(&decoder, VP8D_GET_LAST_REF_UPDATES,
+                                 &updates))
+                die_codec(&decoder, "Failed to get reference updates");
+
+            if(!(frame[0] & 1))
+                flags |= VPX_EFLAG_FORCE_KF;
+            flags |= updates & VP8_GOLD_FRAME ? VP8_EFLAG_FORCE_GF
+                                              : VP8_EFLAG_NO_UPD_GF;
+            flags |= updates & VP8_ALTR_FRAME ? VP8_EFLAG_FORCE_ARF
+                                              : VP8_EFLAG_NO_UPD_ARF;
+
+            if(hint_mode) {
+                if(vpx_codec_control(&decoder, VP8D_GET_MB_HINTS, &map))
+                    die_codec(&decoder, "Failed to get hints");
+                if(vpx_codec_control(&encoder, VP8E_SET_MB_HINTS, &map))
+                    die_codec(&encoder, "Failed to set hints");
+            }
+        }
+        else
+            done = 1;
+
+        vpx_usec_timer_start(&timer);
+        if(vpx_codec_encode(&encoder, img, pts, duration, flags,
+                            cpu_used < 0 ? VPX_DL_REALTIME
+                                         : VPX_DL_GOOD_QUALITY))
+            die_codec(&encoder, "Failed to encode frame");
+        vpx_usec_timer_mark(&timer);
+        usecs += vpx_usec_timer_elapsed(&timer);
+
+        iter = NULL;
+        while((pkt = vpx_codec_get_cx_data(&encoder, &iter))) {
+            if(pkt->kind == VPX_CODEC_CX_FRAME_PKT) {
+                write_ivf_frame_header(outfile, pkt);
+                if(fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz,
+                          outfile));
+                bytes += pkt->data.frame.sz;
+            }
+            else if(pkt->kind == VPX_CODEC_PSNR_PKT) {
+                psnr += pkt->data.psnr.psnr[0];
+                psnr_count++;
+            }
+        }
+
+        if(img)
+            frame_cnt++;
+    }
+
+    printf("%d frames: %8.1f kbps  PSNR %6.3f  %6.2f fps\n", frame_cnt,
+           frame_cnt ? bytes * 8.0 * cfg.g_timebase.den / cfg.g_timebase.num
+                       / (pts + duration - first_pts) / 1000 : 0,
+           psnr_count ? psnr / psnr_count : 0,
+           usecs ? frame_cnt * 1000000.0 / usecs : 0);
+
+    if(!fseek(outfile, 0, SEEK_SET))
+        write_ivf_file_header(outfile, &cfg, frame_cnt);
+
+    free(map.hints);
+    free(frame);
+    fclose(infile);
+    fclose(outfile);
+
+    if(vpx_codec_destroy(&decoder))
+        die_codec(&decoder, "Failed to destroy decoder");
+    if(vpx_codec_destroy(&encoder))
+        die_codec(&encoder, "Failed to destroy encoder");
+    return EXIT_SUCCESS;
+}
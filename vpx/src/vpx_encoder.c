@@ -92,6 +92,9 @@ vpx_codec_err_t vpx_codec_enc_init_multi_ver(vpx_codec_ctx_t      *ctx,
     else if ((flags & VPX_CODEC_USE_OUTPUT_PARTITION)
              && !(iface->caps & VPX_CODEC_CAP_OUTPUT_PARTITION))
         res = VPX_CODEC_INCAPABLE;
+    else if ((flags & VPX_CODEC_USE_MR_PIPELINE)
+             && !(iface->caps & VPX_CODEC_CAP_MR_PIPELINE))
+        res = VPX_CODEC_INCAPABLE;
     else
     {
         int i;
@@ -228,6 +231,8 @@ vpx_codec_err_t  vpx_codec_encode(vpx_codec_ctx_t            *ctx,
              * Encode multi-levels in reverse order. For example,
              * if mr_total_resolutions = 3, first encode level 2,
              * then encode level 1, and finally encode level 0.
+             * With VPX_CODEC_USE_MR_PIPELINE, levels 2 and 1 may still be
+             * encoding when their calls return, and level 0 waits for them.
              */
             int i;
 
@@ -102,6 +102,42 @@ typedef struct vpx_ref_frame
     vpx_image_t           img;          /**< reference frame data in image format */
 } vpx_ref_frame_t;
 
+/*!\brief macroblock hint kind
+ *
+ * The set of macros define how a macroblock hint says it was coded
+ */
+typedef enum vp8_mb_hint_mode
+{
+    VP8_MB_HINT_NONE  = 0,  /**< no hint, the macroblock is searched as usual */
+    VP8_MB_HINT_INTRA = 1,  /**< intra prediction */
+    VP8_MB_HINT_INTER = 2,  /**< one MV for the whole macroblock */
+    VP8_MB_HINT_SPLIT = 3   /**< one MV per 4x4 block */
+} vp8_mb_hint_mode_t;
+
+/*!\brief macroblock hint
+ *
+ * How a macroblock was coded, as taken from a decoded frame or found by
+ * external analysis. MVs are in 1/4 pel units, row then column.
+ */
+typedef struct vpx_mb_hint
+{
+    vp8_mb_hint_mode_t    mode;       /**< how the macroblock was coded */
+    vpx_ref_frame_type_t  ref_frame;  /**< reference of inter and split hints */
+    short                 mv[16][2];  /**< MV of each 4x4 block in raster order, inter hints only use mv[0] */
+} vpx_mb_hint_t;
+
+/*!\brief macroblock hint map
+ *
+ * The hints of all the macroblocks of a frame, in raster order
+ */
+typedef struct vpx_mb_hint_map
+{
+    vpx_mb_hint_t  *hints;      /**< one hint per macroblock */
+    unsigned int    rows;       /**< number of rows */
+    unsigned int    cols;       /**< number of cols */
+    int             only;       /**< encoder: try the hinted modes only, without motion search */
+} vpx_mb_hint_map_t;
+
 
 /*!\brief vp8 decoder control function parameter type
  *
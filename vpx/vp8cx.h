@@ -178,6 +178,85 @@ enum vp8e_enc_control_id
      *
      */
     VP8E_SET_MAX_INTRA_BITRATE_PCT,
+
+    /*!\brief Gather first pass statistics at half resolution
+     *
+     * When set, the first pass of a two pass encode runs on a 2:1
+     * downscaled copy of the source, taking about a quarter of the time.
+     * The statistics are scaled back to full resolution, so the second
+     * pass uses them as usual. Requires spatial resampling support.
+     */
+    VP8E_SET_FIRST_PASS_DOWNSCALE,
+
+    /*!\brief Loop filter the frame while it is being encoded
+     *
+     * In realtime mode with multiple threads, the loop filter follows the
+     * encoding of the macroblock rows instead of running after the whole
+     * frame, which shortens the time taken per frame. The filter level is
+     * then chosen before the frame is encoded, based on the previous
+     * frame. Requires multithreading support.
+     */
+    VP8E_SET_LF_ROW_SYNC,
+
+    /*!\brief Pack the tokens of the frame while it is being encoded
+     *
+     * In realtime mode with multiple threads, the tokens of each macroblock
+     * row are packed into their partition as soon as the row is encoded,
+     * leaving only the first partition to write after the frame. The
+     * coefficient probabilities are then updated from the statistics of the
+     * previous frame, which costs some compression. Requires multithreading
+     * support.
+     */
+    VP8E_SET_TOKEN_ROW_SYNC,
+
+    /*!\brief Memory for precomputed half pel reference planes, in kB
+     *
+     * The half pel interpolations of the reference frames are computed
+     * once per reference instead of for every motion search candidate.
+     * Each reference needs three planes the size of its bordered luma
+     * plane; as many references get them as fit in this budget, the last
+     * frame first. 0 (the default) disables them. The output does not
+     * change.
+     */
+    VP8E_SET_HALFPEL_PLANES,
+
+    /*!\brief Memory used by the half pel reference planes, in kB */
+    VP8E_GET_HALFPEL_PLANES,
+
+    /*!\brief Tune the motion search for screen content
+     *
+     * Every 16x16 and 8x8 block of the last frame is hashed once per
+     * frame, and macroblocks found elsewhere in it unchanged, as after
+     * scrolling or moving a window, are predicted from there however far
+     * they moved. The tables take 24 to 40 bytes per pixel.
+     */
+    VP8E_SET_SCREEN_CONTENT,
+
+    /*!\brief Pass coding hints for the macroblocks of the next frame
+     *
+     * The hinted MVs are tried first by the motion search of the next frame
+     * coded, so a stream being transrated can keep most of the motion of
+     * its decoded frames (see VP8D_GET_MB_HINTS). With
+     * vpx_mb_hint_map_t::only set, each macroblock is only coded with the
+     * modes of its hinted reference frame and inter hints skip the motion
+     * search. Key frames ignore the hints. Use no lag, so that the next
+     * frame coded is the next one passed in.
+     */
+    VP8E_SET_MB_HINTS,
+
+    /*!\brief Derive the active map from the source
+     *
+     * Each incoming macroblock is compared with the last frame, and those
+     * that stayed within this noise threshold, as the average absolute
+     * luma difference per pixel, for a few frames in a row are marked
+     * inactive: they are neither copied nor coded. Every macroblock is
+     * active again on forced key frames and periodically, and has to be
+     * still for a few frames after a key frame. This replaces any map set
+     * with VP8E_SET_ACTIVEMAP, and setting it back to 0 leaves every
+     * macroblock active until a new map is set. Only used with no lag.
+     * 0 (the default) disables it.
+     */
+    VP8E_SET_AUTO_ACTIVE_MAP,
 };
 
 /*!\brief vpx 1-D scaling mode
@@ -311,6 +390,21 @@ VPX_CTRL_USE_TYPE(VP8E_GET_LAST_QUANTIZER_64,  int *)
 
 VPX_CTRL_USE_TYPE(VP8E_SET_MAX_INTRA_BITRATE_PCT, unsigned int)
 
+VPX_CTRL_USE_TYPE(VP8E_SET_FIRST_PASS_DOWNSCALE, unsigned int)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_LF_ROW_SYNC,        unsigned int)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_TOKEN_ROW_SYNC,     unsigned int)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_HALFPEL_PLANES,     unsigned int)
+VPX_CTRL_USE_TYPE(VP8E_GET_HALFPEL_PLANES,     int *)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_SCREEN_CONTENT,     unsigned int)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_MB_HINTS,           vpx_mb_hint_map_t *)
+
+VPX_CTRL_USE_TYPE(VP8E_SET_AUTO_ACTIVE_MAP,    unsigned int)
+
 
 /*! @} - end defgroup vp8_encoder */
 #include "vpx_codec_impl_bottom.h"
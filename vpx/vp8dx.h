@@ -60,10 +60,56 @@ enum vp8_dec_control_id
      */
     VP8D_GET_LAST_REF_USED,
 
+    /** control function to enable OpenCL profiling. Must be set before the
+     *  first frame is decoded. Only available in OpenCL builds.
+     */
+    VP8D_SET_CL_PROFILING,
+
+    /** control function to get the OpenCL profiling data collected so far */
+    VP8D_GET_CL_PROFILE,
+
+    /** control function to get the modes and MVs of the last decoded frame
+     *  as encoder hints, see VP8E_SET_MB_HINTS. The map must have room for
+     *  the hints of all the macroblocks.
+     */
+    VP8D_GET_MB_HINTS,
+
     VP8_DECODER_CTRL_ID_MAX
 } ;
 
 
+/*!\brief Kind of OpenCL command measured by a profile entry */
+typedef enum vp8_cl_profile_kind
+{
+    VP8_CL_PROFILE_WRITE,   /**< host to device transfer */
+    VP8_CL_PROFILE_KERNEL,  /**< kernel execution */
+    VP8_CL_PROFILE_READ     /**< device to host transfer */
+} vp8_cl_profile_kind_t;
+
+#define VP8_CL_PROFILE_MAX_ENTRIES 16
+
+/*!\brief Device time spent in one kind of OpenCL command
+ *
+ * Times are taken from the command start and end events, in nanoseconds.
+ */
+typedef struct vp8_cl_profile_entry
+{
+    const char            *name;
+    vp8_cl_profile_kind_t  kind;
+    unsigned int           count;         /**< commands in all frames */
+    uint64_t               last_frame_ns; /**< time spent in the last frame */
+    uint64_t               total_ns;      /**< time spent in all frames */
+} vp8_cl_profile_entry_t;
+
+/*!\brief OpenCL profiling data, as returned by VP8D_GET_CL_PROFILE */
+typedef struct vp8_cl_profile
+{
+    unsigned int           frames;        /**< frames profiled */
+    int                    num_entries;
+    vp8_cl_profile_entry_t entries[VP8_CL_PROFILE_MAX_ENTRIES];
+} vp8_cl_profile_t;
+
+
 /*!\brief VP8 decoder control function parameter type
  *
  * Defines the data types that VP8D control functions take. Note that
@@ -75,6 +121,9 @@ enum vp8_dec_control_id
 VPX_CTRL_USE_TYPE(VP8D_GET_LAST_REF_UPDATES,   int *)
 VPX_CTRL_USE_TYPE(VP8D_GET_FRAME_CORRUPTED,    int *)
 VPX_CTRL_USE_TYPE(VP8D_GET_LAST_REF_USED,      int *)
+VPX_CTRL_USE_TYPE(VP8D_SET_CL_PROFILING,      int)
+VPX_CTRL_USE_TYPE(VP8D_GET_CL_PROFILE,        vp8_cl_profile_t *)
+VPX_CTRL_USE_TYPE(VP8D_GET_MB_HINTS,          vpx_mb_hint_map_t *)
 
 /*! @} - end defgroup vp8_decoder */
 
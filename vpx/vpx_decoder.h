@@ -57,6 +57,8 @@ extern "C" {
                                                        packet loss */
 #define VPX_CODEC_CAP_INPUT_FRAGMENTS   0x100000 /**< Can receive encoded frames
                                                     one fragment at a time */
+#define VPX_CODEC_CAP_ASYNC_LOOPFILTER  0x200000 /**< Can loop filter a frame
+                                                    while decoding the next */
 
     /*! \brief Initialization-time Feature Enabling
      *
@@ -71,6 +73,10 @@ extern "C" {
 #define VPX_CODEC_USE_INPUT_FRAGMENTS   0x40000 /**< The input frame should be
                                                     passed to the decoder one
                                                     fragment at a time */
+#define VPX_CODEC_USE_ASYNC_LOOPFILTER  0x80000 /**< Loop filter each frame
+                                                    while the next one is
+                                                    decoded. Output is delayed
+                                                    by one frame */
 
     /*!\brief Stream properties
      *
@@ -196,6 +202,9 @@ extern "C" {
      * empty. When no more data is available, this function should be called
      * with NULL as data and 0 as data_sz. The memory passed to this function
      * must be available until the frame has been decoded.
+     * If the decoder is configured with VPX_CODEC_USE_ASYNC_LOOPFILTER enabled,
+     * each call returns the frame decoded by the previous call. The last frame
+     * is returned by calling this function with NULL as data and 0 as data_sz.
      *
      * \param[in] ctx          Pointer to this instance's context
      * \param[in] data         Pointer to this block of new coded data. If
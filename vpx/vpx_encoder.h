@@ -43,7 +43,7 @@ extern "C" {
      * types, removing or reassigning enums, adding/removing/rearranging
      * fields to structures
      */
-#define VPX_ENCODER_ABI_VERSION (3 + VPX_CODEC_ABI_VERSION) /**<\hideinitializer*/
+#define VPX_ENCODER_ABI_VERSION (4 + VPX_CODEC_ABI_VERSION) /**<\hideinitializer*/
 
 
     /*! \brief Encoder capabilities bitfield
@@ -64,6 +64,11 @@ extern "C" {
      */
 #define VPX_CODEC_CAP_OUTPUT_PARTITION  0x20000
 
+    /*! Can encode the resolutions of a multi-resolution encoder at the same
+     *  time, see VPX_CODEC_USE_MR_PIPELINE.
+     */
+#define VPX_CODEC_CAP_MR_PIPELINE  0x40000
+
 
     /*! \brief Initialization-time Feature Enabling
      *
@@ -75,6 +80,11 @@ extern "C" {
 #define VPX_CODEC_USE_PSNR  0x10000 /**< Calculate PSNR on each frame */
 #define VPX_CODEC_USE_OUTPUT_PARTITION  0x20000 /**< Make the encoder output one
                                                      partition at a time. */
+#define VPX_CODEC_USE_MR_PIPELINE  0x40000 /**< Encode the resolutions passed to
+                                                vpx_codec_enc_init_multi() at
+                                                the same time, each a few MB
+                                                rows behind the next lower
+                                                one */
 
 
     /*!\brief Generic fixed size buffer structure
@@ -634,6 +644,23 @@ extern "C" {
          * then ts_layer_id = (0,1,0,1,0,1,0,1).
          */
         unsigned int           ts_layer_id[MAX_PERIODICITY];
+
+        /*
+         * Thread pool settings
+         */
+
+        /*!\brief Size of the thread pool shared by encoder instances
+         *
+         * When nonzero, the encoder doesn't start threads of its own but runs
+         * its multi-threaded work on a thread pool shared by every encoder
+         * instance in the process that sets this value, for example the
+         * layers of a simulcast encode. The pool starts with the first such
+         * instance, grows to the largest value set and stops with the last
+         * one. Each instance still uses at most g_threads threads at a time,
+         * counting the one calling vpx_codec_encode(). The value 0 gives the
+         * instance threads of its own.
+         */
+        unsigned int           g_pool_threads;
     } vpx_codec_enc_cfg_t; /**< alias for struct vpx_codec_enc_cfg */
 
 
@@ -95,6 +95,10 @@ static const arg_def_t error_concealment = ARG_DEF(NULL, "error-concealment", 0,
 static const arg_def_t md5arg = ARG_DEF(NULL, "md5", 0,
                                         "Compute the MD5 sum of the decoded frame");
 #endif
+static const arg_def_t async_lf = ARG_DEF(NULL, "async-loopfilter", 0,
+                                          "Overlap the loop filter with decoding of the next frame (OpenCL)");
+static const arg_def_t cl_profile = ARG_DEF(NULL, "cl-profile", 0,
+                                            "Show time spent in OpenCL transfers and kernels");
 static const arg_def_t *all_args[] =
 {
     &codecarg, &use_yv12, &use_i420, &flipuvarg, &noblitarg,
@@ -103,7 +107,7 @@ static const arg_def_t *all_args[] =
 #if CONFIG_MD5
     &md5arg,
 #endif
-    &error_concealment,
+    &error_concealment, &async_lf, &cl_profile,
     NULL
 };
 
@@ -135,6 +139,45 @@ static const arg_def_t *vp8_pp_args[] =
 };
 #endif
 
+#if CONFIG_VP8_DECODER
+static void show_cl_profile(vpx_codec_ctx_t *decoder)
+{
+    static const char *kind_names[] = {"write", "kernel", "read"};
+    vp8_cl_profile_t profile;
+    uint64_t kind_ns[3] = {0};
+    int i;
+
+    if (vpx_codec_control(decoder, VP8D_GET_CL_PROFILE, &profile))
+    {
+        fprintf(stderr, "Failed to get OpenCL profile: %s\n", vpx_codec_error(decoder));
+        return;
+    }
+
+    fprintf(stderr, "OpenCL profile, %u frames (device time):\n", profile.frames);
+    fprintf(stderr, "  %-38s %-6s %9s %12s %12s\n",
+            "command", "kind", "count", "total ms", "us/frame");
+
+    for (i = 0; i < profile.num_entries; i++)
+    {
+        vp8_cl_profile_entry_t *e = &profile.entries[i];
+
+        kind_ns[e->kind] += e->total_ns;
+
+        if (!e->count)
+            continue;
+
+        fprintf(stderr, "  %-38s %-6s %9u %12.3f %12.1f\n",
+                e->name, kind_names[e->kind], e->count, e->total_ns / 1e6,
+                profile.frames ? e->total_ns / 1e3 / profile.frames : 0.0);
+    }
+
+    for (i = 0; i < 3; i++)
+        fprintf(stderr, "  %-38s %-6s %9s %12.3f %12.1f\n",
+                "total", kind_names[i], "", kind_ns[i] / 1e6,
+                profile.frames ? kind_ns[i] / 1e3 / profile.frames : 0.0);
+}
+#endif
+
 static void usage_exit()
 {
     int i;
@@ -707,6 +750,7 @@ int main(int argc, const char **argv_)
     int                    frame_in = 0, frame_out = 0, flipuv = 0, noblit = 0, do_md5 = 0, progress = 0;
     int                    stop_after = 0, postproc = 0, summary = 0, quiet = 1;
     int                    ec_enabled = 0;
+    int                    async_lf_enabled = 0, flushing = 0, draining = 0;
     vpx_codec_iface_t       *iface = NULL;
     unsigned int           fourcc;
     unsigned long          dx_time = 0;
@@ -728,6 +772,7 @@ int main(int argc, const char **argv_)
     int                     vp8_dbg_color_mb_modes = 0;
     int                     vp8_dbg_color_b_modes = 0;
     int                     vp8_dbg_display_mv = 0;
+    int                     cl_profile_enabled = 0;
 #endif
     struct input_ctx        input = {0};
     int                     frames_corrupted = 0;
@@ -860,6 +905,14 @@ int main(int argc, const char **argv_)
         {
             ec_enabled = 1;
         }
+        else if (arg_match(&arg, &async_lf, argi))
+        {
+            async_lf_enabled = 1;
+        }
+        else if (arg_match(&arg, &cl_profile, argi))
+        {
+            cl_profile_enabled = 1;
+        }
 
 #endif
         else
@@ -981,7 +1034,8 @@ int main(int argc, const char **argv_)
         }
 
     dec_flags = (postproc ? VPX_CODEC_USE_POSTPROC : 0) |
-                (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0);
+                (ec_enabled ? VPX_CODEC_USE_ERROR_CONCEALMENT : 0) |
+                (async_lf_enabled ? VPX_CODEC_USE_ASYNC_LOOPFILTER : 0);
     if (vpx_codec_dec_init(&decoder, iface ? iface :  ifaces[0].iface, &cfg,
                            dec_flags))
     {
@@ -1028,19 +1082,38 @@ int main(int argc, const char **argv_)
         fprintf(stderr, "Failed to configure motion vector visualizer: %s\n", vpx_codec_error(&decoder));
         return EXIT_FAILURE;
     }
+
+    if (cl_profile_enabled
+        && vpx_codec_control(&decoder, VP8D_SET_CL_PROFILING, 1))
+    {
+        fprintf(stderr, "Failed to enable OpenCL profiling: %s\n", vpx_codec_error(&decoder));
+        return EXIT_FAILURE;
+    }
 #endif
 
     /* Decode file */
-    while (!read_frame(&input, &buf, &buf_sz, &buf_alloc_sz))
+    while (!flushing)
     {
         vpx_codec_iter_t  iter = NULL;
         vpx_image_t    *img;
         struct vpx_usec_timer timer;
         int                   corrupted;
 
+        if (draining || read_frame(&input, &buf, &buf_sz, &buf_alloc_sz))
+        {
+            /* With the asynchronous loop filter the decoder holds on to the
+             * last frame until it is flushed with an empty buffer.
+             */
+            if (!async_lf_enabled)
+                break;
+
+            flushing = 1;
+        }
+
         vpx_usec_timer_start(&timer);
 
-        if (vpx_codec_decode(&decoder, buf, buf_sz, NULL, 0))
+        if (vpx_codec_decode(&decoder, flushing ? NULL : buf,
+                             flushing ? 0 : buf_sz, NULL, 0))
         {
             const char *detail = vpx_codec_error_detail(&decoder);
             fprintf(stderr, "Failed to decode frame: %s\n", vpx_codec_error(&decoder));
@@ -1054,15 +1127,18 @@ int main(int argc, const char **argv_)
         vpx_usec_timer_mark(&timer);
         dx_time += vpx_usec_timer_elapsed(&timer);
 
-        ++frame_in;
-
-        if (vpx_codec_control(&decoder, VP8D_GET_FRAME_CORRUPTED, &corrupted))
+        if (!flushing)
         {
-            fprintf(stderr, "Failed VP8_GET_FRAME_CORRUPTED: %s\n",
-                    vpx_codec_error(&decoder));
-            goto fail;
+            ++frame_in;
+
+            if (vpx_codec_control(&decoder, VP8D_GET_FRAME_CORRUPTED, &corrupted))
+            {
+                fprintf(stderr, "Failed VP8_GET_FRAME_CORRUPTED: %s\n",
+                        vpx_codec_error(&decoder));
+                goto fail;
+            }
+            frames_corrupted += corrupted;
         }
-        frames_corrupted += corrupted;
 
         if ((img = vpx_codec_get_frame(&decoder, &iter)))
             ++frame_out;
@@ -1120,7 +1196,12 @@ int main(int argc, const char **argv_)
         }
 
         if (stop_after && frame_in >= stop_after)
-            break;
+        {
+            if (!async_lf_enabled)
+                break;
+
+            draining = 1;
+        }
     }
 
     if (summary || progress)
@@ -1132,6 +1213,11 @@ int main(int argc, const char **argv_)
     if (frames_corrupted)
         fprintf(stderr, "WARNING: %d frames corrupted.\n",frames_corrupted);
 
+#if CONFIG_VP8_DECODER
+    if (cl_profile_enabled)
+        show_cl_profile(&decoder);
+#endif
+
 fail:
 
     if (vpx_codec_destroy(&decoder))
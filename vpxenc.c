@@ -965,6 +965,8 @@ static const arg_def_t usage            = ARG_DEF("u", "usage", 1,
         "Usage profile number to use");
 static const arg_def_t threads          = ARG_DEF("t", "threads", 1,
         "Max number of threads to use");
+static const arg_def_t pool_threads     = ARG_DEF(NULL, "pool-threads", 1,
+        "Run the threads on a shared pool of this size");
 static const arg_def_t profile          = ARG_DEF(NULL, "profile", 1,
         "Bitstream profile number to use");
 static const arg_def_t width            = ARG_DEF("w", "width", 1,
@@ -990,7 +992,7 @@ static const arg_def_t lag_in_frames    = ARG_DEF(NULL, "lag-in-frames", 1,
 
 static const arg_def_t *global_args[] =
 {
-    &use_yv12, &use_i420, &usage, &threads, &profile,
+    &use_yv12, &use_i420, &usage, &threads, &pool_threads, &profile,
     &width, &height, &stereo_mode, &timebase, &framerate, &error_resilient,
     &lag_in_frames, NULL
 };
@@ -1097,12 +1099,26 @@ static const arg_def_t cq_level = ARG_DEF(NULL, "cq-level", 1,
                                    "Constrained Quality Level");
 static const arg_def_t max_intra_rate_pct = ARG_DEF(NULL, "max-intra-rate", 1,
         "Max I-frame bitrate (pct)");
+static const arg_def_t fp_downscale = ARG_DEF(NULL, "fp-downscale", 1,
+        "Run the first pass at half resolution (0/1)");
+static const arg_def_t lf_row_sync = ARG_DEF(NULL, "lf-row-sync", 1,
+        "Loop filter rows as they are encoded (0/1)");
+static const arg_def_t token_row_sync = ARG_DEF(NULL, "token-row-sync", 1,
+        "Pack tokens of rows as they are encoded (0/1)");
+static const arg_def_t halfpel_planes = ARG_DEF(NULL, "halfpel-planes", 1,
+        "Memory for precomputed half pel planes (kB)");
+static const arg_def_t screen_content = ARG_DEF(NULL, "screen-content", 1,
+        "Search for moved blocks of screen content (0/1)");
+static const arg_def_t auto_active_map = ARG_DEF(NULL, "auto-active-map", 1,
+        "Skip MBs still within this noise level (0-64)");
 
 static const arg_def_t *vp8_args[] =
 {
     &cpu_used, &auto_altref, &noise_sens, &sharpness, &static_thresh,
     &token_parts, &arnr_maxframes, &arnr_strength, &arnr_type,
-    &tune_ssim, &cq_level, &max_intra_rate_pct, NULL
+    &tune_ssim, &cq_level, &max_intra_rate_pct, &fp_downscale,
+    &lf_row_sync, &token_row_sync, &halfpel_planes,
+    &screen_content, &auto_active_map, NULL
 };
 static const int vp8_arg_ctrl_map[] =
 {
@@ -1110,7 +1126,10 @@ static const int vp8_arg_ctrl_map[] =
     VP8E_SET_NOISE_SENSITIVITY, VP8E_SET_SHARPNESS, VP8E_SET_STATIC_THRESHOLD,
     VP8E_SET_TOKEN_PARTITIONS,
     VP8E_SET_ARNR_MAXFRAMES, VP8E_SET_ARNR_STRENGTH , VP8E_SET_ARNR_TYPE,
-    VP8E_SET_TUNING, VP8E_SET_CQ_LEVEL, VP8E_SET_MAX_INTRA_BITRATE_PCT, 0
+    VP8E_SET_TUNING, VP8E_SET_CQ_LEVEL, VP8E_SET_MAX_INTRA_BITRATE_PCT,
+    VP8E_SET_FIRST_PASS_DOWNSCALE, VP8E_SET_LF_ROW_SYNC,
+    VP8E_SET_TOKEN_ROW_SYNC, VP8E_SET_HALFPEL_PLANES,
+    VP8E_SET_SCREEN_CONTENT, VP8E_SET_AUTO_ACTIVE_MAP, 0
 };
 #endif
 
@@ -1622,6 +1641,8 @@ int main(int argc, const char **argv_)
         if (0);
         else if (arg_match(&arg, &threads, argi))
             cfg.g_threads = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &pool_threads, argi))
+            cfg.g_pool_threads = arg_parse_uint(&arg);
         else if (arg_match(&arg, &profile, argi))
             cfg.g_profile = arg_parse_uint(&arg);
         else if (arg_match(&arg, &width, argi))
@@ -1851,6 +1872,7 @@ int main(int argc, const char **argv_)
 
             SHOW(g_usage);
             SHOW(g_threads);
+            SHOW(g_pool_threads);
             SHOW(g_profile);
             SHOW(g_w);
             SHOW(g_h);
@@ -2102,6 +2124,17 @@ int main(int argc, const char **argv_)
             }
         }
 
+#if CONFIG_VP8_ENCODER
+        if (verbose)
+        {
+            int halfpel_kb;
+
+            if (!vpx_codec_control(&encoder, VP8E_GET_HALFPEL_PLANES,
+                                   &halfpel_kb) && halfpel_kb)
+                fprintf(stderr, "\nHalf pel planes: %d kB", halfpel_kb);
+        }
+#endif
+
         vpx_codec_destroy(&encoder);
 
         fclose(infile);